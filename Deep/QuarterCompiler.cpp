@@ -5,7 +5,7 @@
 #include <string>
 #include "Lexer.h"
 #include "Parser.h"
-#include "AST.h"
+#include "AstArena.h"
 #include "Binder.h"
 #include "Optimizer.h"
 #include "CodeGenerator.h"
@@ -17,6 +17,10 @@
 #include "SyntaxHighlighter.h"
 #include "Debugger.h"
 #include "Indexter.h"
+#include "SymbolInterner.h"
+#include "SourceScanner.h"
+#include "QuarterLang_Keywords.h"
+#include "QuarterLang_SourceBuffer.h"
 #include "Filer.h"
 #include "Formatter.h"
 #include "Renderer.h"
@@ -39,29 +43,36 @@
 #include <string>
 #include <vector>
 #include <regex>
+#include <cctype>
+#include <string_view>
+#include "QuarterLang_Keywords.h"
+#include "QuarterLang_SourceBuffer.h"
 
 // Heuristics for QuarterLang
-const std::vector<std::string> quarter_keywords = {
-    "quarter", "func", "begin", "end", "let", "const", "if", "else", "loop", "out", "in", "ret", "import"
-};
 
 const std::vector<std::string> quarter_operators = {
     ":>", "<:", "->", "<-", "::", "=>"
 };
 
-bool containsQuarterKeyword(const std::string& code) {
-    for (const auto& keyword : quarter_keywords) {
-        std::regex word_regex("\\b" + keyword + "\\b");
-        if (std::regex_search(code, word_regex)) {
-            return true;
+// One pass over the words of `code`, each checked against the shared keyword table.
+bool containsQuarterKeyword(std::string_view code) {
+    size_t i = 0, n = code.size();
+    while (i < n) {
+        if (std::isalnum(static_cast<unsigned char>(code[i])) || code[i] == '_') {
+            size_t start = i;
+            while (i < n && (std::isalnum(static_cast<unsigned char>(code[i])) || code[i] == '_')) ++i;
+            if (QuarterKeywords::isKeyword(code.substr(start, i - start)))
+                return true;
+        } else {
+            ++i;
         }
     }
     return false;
 }
 
-bool containsQuarterOperator(const std::string& code) {
+bool containsQuarterOperator(std::string_view code) {
     for (const auto& op : quarter_operators) {
-        if (code.find(op) != std::string::npos) {
+        if (code.find(op) != std::string_view::npos) {
             return true;
         }
     }
@@ -69,7 +80,7 @@ bool containsQuarterOperator(const std::string& code) {
 }
 
 // Main detection function
-bool isQuarterLang(const std::string& code) {
+bool isQuarterLang(std::string_view code) {
     int score = 0;
 
     if (containsQuarterKeyword(code)) score += 2;
@@ -77,24 +88,23 @@ bool isQuarterLang(const std::string& code) {
 
     // Look for "func" function declarations (common in QuarterLang)
     std::regex func_decl(R"(func\s+\w+\s*\()");
-    if (std::regex_search(code, func_decl)) score += 2;
+    if (std::regex_search(code.begin(), code.end(), func_decl)) score += 2;
 
     // Heuristic: does code start with "quarter"
     if (code.find("quarter") == 0) score += 1;
 
     // Heuristic: line contains ":>"
-    if (code.find(":>") != std::string::npos) score += 1;
+    if (code.find(":>") != std::string_view::npos) score += 1;
 
     // At least 4 points => likely QuarterLang
     return score >= 4;
 }
 
-// Read file to string
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+// Map the file (or stream it, for pipes); an unreadable file reads as empty
+SourceBuffer readFile(const std::string& filename) {
+    SourceBuffer buffer;
+    buffer.open(filename);
+    return buffer;
 }
 
 // Usage: ./lang_detector <filename>
@@ -104,9 +114,9 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::string code = readFile(argv[1]);
+    SourceBuffer code = readFile(argv[1]);
 
-    if (isQuarterLang(code)) {
+    if (isQuarterLang(code.view())) {
         std::cout << "Detected: Quarter Programming Language!\n";
     } else {
         std::cout << "Not QuarterLang (or unsure).\n";
@@ -221,13 +231,10 @@ int main(int argc, char* argv[]) {
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <string_view>
+#include "QuarterLang_Keywords.h"
 
-// Basic QuarterLang keywords & types (expand as needed)
-const std::vector<std::string> quarter_keywords = {
-    "let", "fn", "if", "else", "while", "for", "return", "import",
-    "as", "from", "struct", "enum", "match", "break", "continue", "true", "false"
-};
-
+// Keywords come from the shared QuarterKeywords table; types & operators below (expand as needed)
 const std::vector<std::string> quarter_types = {
     "Int", "Float", "Bool", "Char", "String", "Void"
 };
@@ -238,7 +245,7 @@ const std::vector<std::string> quarter_operators = {
 };
 
 // Utility: startsWith for suggestions
-bool startsWith(const std::string& str, const std::string& prefix) {
+bool startsWith(std::string_view str, std::string_view prefix) {
     return str.size() >= prefix.size()
         && std::equal(prefix.begin(), prefix.end(), str.begin());
 }
@@ -248,8 +255,8 @@ std::vector<std::string> getSuggestions(const std::string& partial) {
     std::vector<std::string> suggestions;
 
     // Keywords
-    for (const auto& kw : quarter_keywords) {
-        if (startsWith(kw, partial)) suggestions.push_back(kw);
+    for (std::string_view kw : QuarterKeywords::LIST) {
+        if (startsWith(kw, partial)) suggestions.emplace_back(kw);
     }
     // Types
     for (const auto& tp : quarter_types) {
@@ -310,13 +317,10 @@ int main() {
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <string_view>
+#include "QuarterLang_Keywords.h"
 
-// Basic QuarterLang keywords & types (expand as needed)
-const std::vector<std::string> quarter_keywords = {
-    "let", "fn", "if", "else", "while", "for", "return", "import",
-    "as", "from", "struct", "enum", "match", "break", "continue", "true", "false"
-};
-
+// Keywords come from the shared QuarterKeywords table; types & operators below (expand as needed)
 const std::vector<std::string> quarter_types = {
     "Int", "Float", "Bool", "Char", "String", "Void"
 };
@@ -327,7 +331,7 @@ const std::vector<std::string> quarter_operators = {
 };
 
 // Utility: startsWith for suggestions
-bool startsWith(const std::string& str, const std::string& prefix) {
+bool startsWith(std::string_view str, std::string_view prefix) {
     return str.size() >= prefix.size()
         && std::equal(prefix.begin(), prefix.end(), str.begin());
 }
@@ -337,8 +341,8 @@ std::vector<std::string> getSuggestions(const std::string& partial) {
     std::vector<std::string> suggestions;
 
     // Keywords
-    for (const auto& kw : quarter_keywords) {
-        if (startsWith(kw, partial)) suggestions.push_back(kw);
+    for (std::string_view kw : QuarterKeywords::LIST) {
+        if (startsWith(kw, partial)) suggestions.emplace_back(kw);
     }
     // Types
     for (const auto& tp : quarter_types) {
@@ -584,14 +588,13 @@ public:
     }
 
     bool processIR(const QuarterLangIR& ir) override {
-        // JIT compile and run
-        // ...implementation...
+        // Nothing ahead of time: the VM compiles functions with BaselineJIT
+        // (see QuarterJIT.h) once they are hot.
         return true;
     }
 
     bool execute(QuarterLangRuntime& runtime) override {
-        // Kick off runtime, run code
-        // ...implementation...
+        // Kick off runtime, run code; tier-up happens inside VM::run.
         return true;
     }
 
@@ -607,39 +610,52 @@ public:
 #include <memory>
 #include <stack>
 #include <iostream>
+#include <stdexcept>
+#include "SymbolInterner.h"
+#include "AstArena.h"
 
 // ---- Symbol Representation ----
 enum class SymbolKind { Variable, Function, Unknown };
 
 struct Symbol {
-    std::string name;
+    SymbolId name;
     SymbolKind kind;
     int scopeLevel; // For debugging, diagnostics
+    uint32_t slot = 0;     // Variable: index into its frame's slot array
+                           // Function: index into ResolvedNames::functions
     // Add type, value, etc. as needed
 
-    Symbol(std::string n, SymbolKind k, int level)
-        : name(std::move(n)), kind(k), scopeLevel(level) {}
+    Symbol(SymbolId n, SymbolKind k, int level)
+        : name(n), kind(k), scopeLevel(level) {}
 };
 
 // ---- Scope Representation ----
+// One scope per runtime frame: the program, or one function body. Blocks
+// inside a function share its frame, as they do at run time.
 class Scope {
 public:
-    std::unordered_map<std::string, Symbol> symbols;
+    std::unordered_map<SymbolId, Symbol> symbols;
     std::shared_ptr<Scope> parent;
     int level;
+    uint32_t slotCount = 0; // frame size: variables declared so far
 
     Scope(std::shared_ptr<Scope> parentScope = nullptr, int lvl = 0)
         : parent(parentScope), level(lvl) {}
 
     bool addSymbol(const Symbol& sym) {
-        if (symbols.count(sym.name)) return false; // Already defined here
-        symbols[sym.name] = sym;
-        return true;
+        return symbols.emplace(sym.name, sym).second; // false if already defined here
     }
 
-    Symbol* resolve(const std::string& name) {
-        if (symbols.count(name)) return &symbols[name];
-        if (parent) return parent->resolve(name);
+    // `depth` receives how many scopes outward the name was found.
+    Symbol* resolve(SymbolId name, uint32_t* depth = nullptr) {
+        uint32_t hops = 0;
+        for (Scope* s = this; s; s = s->parent.get(), ++hops) {
+            auto it = s->symbols.find(name);
+            if (it != s->symbols.end()) {
+                if (depth) *depth = hops;
+                return &it->second;
+            }
+        }
         return nullptr;
     }
 };
@@ -663,61 +679,319 @@ public:
         }
     }
 
-    bool declare(const std::string& name, SymbolKind kind) {
+    Scope& scope() { return *currentScope; }
+
+    bool declare(SymbolId name, SymbolKind kind) {
         Symbol sym(name, kind, scopeDepth);
+        if (kind == SymbolKind::Variable) sym.slot = currentScope->slotCount;
         bool ok = currentScope->addSymbol(sym);
         if (!ok) {
-            std::cerr << "[Binder] Error: '" << name << "' already defined in this scope (Level " << scopeDepth << ")\n";
+            std::cerr << "[Binder] Error: '" << SymbolInterner::global().name(name)
+                      << "' already defined in this scope (Level " << scopeDepth << ")\n";
+        } else if (kind == SymbolKind::Variable) {
+            ++currentScope->slotCount;
         }
         return ok;
     }
 
-    Symbol* lookup(const std::string& name) {
-        return currentScope->resolve(name);
+    Symbol* lookup(SymbolId name, uint32_t* depth = nullptr) {
+        return currentScope->resolve(name, depth);
     }
 
     // ---- For AST integration ----
     // Walk over your AST, calling declare/lookup as you process variable/function definitions and references.
-    // Example stubs:
-    void bindVariable(const std::string& name) {
+    // Names come straight from Token::sym / the AST nodes; no string hashing here.
+    void bindVariable(SymbolId name) {
         declare(name, SymbolKind::Variable);
     }
 
-    void bindFunction(const std::string& name) {
+    void bindFunction(SymbolId name) {
         declare(name, SymbolKind::Function);
     }
 
-    void useIdentifier(const std::string& name) {
+    void useIdentifier(SymbolId name) {
         Symbol* sym = lookup(name);
         if (!sym) {
-            std::cerr << "[Binder] Error: Use of undefined identifier '" << name << "'\n";
+            std::cerr << "[Binder] Error: Use of undefined identifier '"
+                      << SymbolInterner::global().name(name) << "'\n";
         }
         // else: all good, can annotate AST node with symbol info if desired
     }
 };
 
+// ---- Resolution Pass ----
+// Gives every variable reference a (depth, slot) pair: `depth` frames out
+// along the lexical chain, then `slot` into that frame. Every function is
+// registered once, by node, in a function table, and calls are bound to
+// their entry. The runtime indexes frames directly and never looks a name up.
+
+struct VarSlot {
+    uint32_t depth = 0;
+    uint32_t slot = 0;
+};
+
+struct FunctionInfo {
+    NodeId def;          // the FuncDef node; nothing is copied out of the arena
+    NodeId body;
+    uint32_t params;     // they take the first slots of the frame
+    uint32_t frameSize;
+    uint32_t level;      // frames below the program's: 1 for a top-level function
+};
+
+// Functions the runtime provides. A Quarter function of the same name hides
+// one; only the tree walker runs them.
+enum class Builtin : uint8_t { None, ReadFile, WriteFile, WriteBytes };
+
+struct BuiltinInfo {
+    const char* name;
+    uint32_t params;
+};
+
+inline const BuiltinInfo& builtinInfo(Builtin b) {
+    static const BuiltinInfo table[] = {{"", 0}, {"read_file", 1}, {"write_file", 2}, {"write_bytes", 2}};
+    return table[static_cast<size_t>(b)];
+}
+
+// Side tables indexed by NodeId; entries for other node kinds are unused.
+struct ResolvedNames {
+    std::vector<VarSlot> slots;        // Val/Var/Assign/Ask/Identifier; Call: depth to the callee's defining frame
+    std::vector<uint32_t> callee;      // Call -> index into `functions`
+    std::vector<uint32_t> frameSize;   // Program/FuncDef -> slots its frame needs
+    std::vector<uint32_t> limit;       // Loop -> slot, in the current frame, holding its upper bound
+    std::vector<uint8_t> tailCall;     // Call -> 1 if it is a tail call: see Resolver
+    std::vector<Builtin> builtin;      // Call -> the builtin it names, if no function does
+    std::vector<FunctionInfo> functions;
+
+    const VarSlot& at(NodeId node) const { return slots[node]; }
+    const FunctionInfo& function(NodeId call) const { return functions[callee[call]]; }
+};
+
+// Function names are visible throughout the frame that defines them, so
+// calls may precede the definition and functions may recurse. Bodies are
+// resolved after the rest of their defining frame, so they see every
+// variable declared there. Redeclaring a name in one frame reuses its slot.
+//
+// `return f(...)` is marked a tail call, which the runtimes run in the
+// returning function's frame instead of a new one, unless f is defined in
+// that function: then the frame is f's parent and has to outlive the call.
+class Resolver {
+public:
+    // Throws std::runtime_error listing every unresolved name.
+    ResolvedNames resolve(const AstArena& tree, NodeId program) {
+        ast = &tree;
+        out = ResolvedNames{};
+        out.slots.resize(tree.size());
+        out.callee.assign(tree.size(), UINT32_MAX);
+        out.frameSize.assign(tree.size(), 0);
+        out.limit.assign(tree.size(), 0);
+        out.tailCall.assign(tree.size(), 0);
+        out.builtin.assign(tree.size(), Builtin::None);
+        errors.clear();
+        binder = Binder{};
+
+        resolveFrame(program, {}, program);
+        for (FunctionInfo& fn : out.functions) fn.frameSize = out.frameSize[fn.def];
+        if (!errors.empty()) {
+            std::string message = "Name resolution failed:";
+            for (const std::string& e : errors) message += "\n  " + e;
+            throw std::runtime_error(message);
+        }
+        return std::move(out);
+    }
+
+private:
+    const AstArena* ast = nullptr;
+    Binder binder;
+    ResolvedNames out;
+    std::vector<std::string> errors;
+    std::vector<NodeId> pendingBodies;  // FuncDefs of the frame being resolved
+
+    static std::string spell(SymbolId name) { return std::string(SymbolInterner::global().name(name)); }
+
+    static Builtin builtinNamed(SymbolId name) {
+        std::string_view spelled = SymbolInterner::global().name(name);
+        for (Builtin b : {Builtin::ReadFile, Builtin::WriteFile, Builtin::WriteBytes})
+            if (spelled == builtinInfo(b).name) return b;
+        return Builtin::None;
+    }
+
+    void error(NodeId node, const std::string& message) {
+        errors.push_back("line " + std::to_string(ast->line(node)) + ": " + message);
+    }
+
+    // `owner` is the Program or FuncDef node whose frame this is; `params`
+    // take the first slots; `body` is resolved in the frame.
+    void resolveFrame(NodeId owner, const std::vector<NodeId>& params, NodeId body) {
+        std::vector<NodeId> outerPending;
+        outerPending.swap(pendingBodies);
+
+        for (NodeId p : params) declareVariable(p);
+        hoistFunctions(body);
+        resolveNode(body);
+        // Nested bodies last, once every variable of this frame is known.
+        for (size_t i = 0; i < pendingBodies.size(); ++i) {
+            NodeId def = pendingBodies[i];
+            size_t count = ast->childCount(def);
+            std::vector<NodeId> defParams;
+            for (size_t k = 0; k + 1 < count; ++k) defParams.push_back(ast->child(def, k));
+            binder.enterScope();
+            resolveFrame(def, defParams, ast->child(def, count - 1));
+            binder.exitScope();
+        }
+        out.frameSize[owner] = binder.scope().slotCount;
+        pendingBodies.swap(outerPending);
+    }
+
+    // Declares every FuncDef of this frame up front (blocks share the frame).
+    void hoistFunctions(NodeId node) {
+        switch (ast->kind(node)) {
+            case NodeKind::FuncDef:
+                if (!binder.scope().symbols.count(ast->symbol(node))) {
+                    size_t count = ast->childCount(node);
+                    binder.declare(ast->symbol(node), SymbolKind::Function);
+                    binder.lookup(ast->symbol(node))->slot = static_cast<uint32_t>(out.functions.size());
+                    out.functions.push_back({node, ast->child(node, count - 1), static_cast<uint32_t>(count - 1), 0,
+                                             static_cast<uint32_t>(binder.scope().level + 1)});
+                } else {
+                    error(node, "Function '" + spell(ast->symbol(node)) + "' already defined.");
+                }
+                break;
+            case NodeKind::Program:
+            case NodeKind::Block:
+            case NodeKind::If:
+            case NodeKind::While:
+            case NodeKind::Loop:
+                for (NodeId child : ast->children(node)) hoistFunctions(child);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void declareVariable(NodeId node) {
+        SymbolId name = ast->symbol(node);
+        Scope& frame = binder.scope();
+        auto it = frame.symbols.find(name);
+        if (it == frame.symbols.end()) {
+            binder.declare(name, SymbolKind::Variable);
+            it = frame.symbols.find(name);
+        } else if (it->second.kind != SymbolKind::Variable) {
+            error(node, "'" + spell(name) + "' is already a function.");
+            return;
+        }
+        out.slots[node] = {0, it->second.slot};
+    }
+
+    // A slot no name can reach, for values the runtime keeps in the frame.
+    uint32_t hiddenSlot() { return binder.scope().slotCount++; }
+
+    void useVariable(NodeId node) {
+        uint32_t depth = 0;
+        Symbol* sym = binder.lookup(ast->symbol(node), &depth);
+        if (!sym || sym->kind != SymbolKind::Variable) {
+            error(node, "Variable '" + spell(ast->symbol(node)) + "' not defined.");
+            return;
+        }
+        out.slots[node] = {depth, sym->slot};
+    }
+
+    void resolveNode(NodeId node) {
+        switch (ast->kind(node)) {
+            case NodeKind::Val:
+            case NodeKind::Var:
+                resolveNode(ast->child(node, 0));  // `var x = x` reads the outer x
+                declareVariable(node);
+                break;
+            case NodeKind::Ask:
+                declareVariable(node);
+                break;
+            case NodeKind::Assign:
+                resolveNode(ast->child(node, 0));
+                useVariable(node);
+                break;
+            case NodeKind::Identifier:
+                useVariable(node);
+                break;
+            case NodeKind::Loop:
+                resolveNode(ast->child(node, 0));  // the bounds cannot see the counter
+                resolveNode(ast->child(node, 1));
+                if (ast->symbol(node) != sym::NONE) declareVariable(node);
+                else out.slots[node] = {0, hiddenSlot()};
+                out.limit[node] = hiddenSlot();
+                resolveNode(ast->child(node, 2));
+                break;
+            case NodeKind::FuncDef:
+                pendingBodies.push_back(node);
+                break;
+            case NodeKind::Call: {
+                for (NodeId arg : ast->children(node)) resolveNode(arg);
+                uint32_t depth = 0;
+                Symbol* sym = binder.lookup(ast->symbol(node), &depth);
+                size_t params = 0;
+                if (sym && sym->kind == SymbolKind::Function) {
+                    params = out.functions[sym->slot].params;
+                    out.slots[node] = {depth, 0};
+                    out.callee[node] = sym->slot;
+                } else if (Builtin b = builtinNamed(ast->symbol(node)); b != Builtin::None) {
+                    params = builtinInfo(b).params;
+                    out.builtin[node] = b;
+                } else {
+                    error(node, "Function '" + spell(ast->symbol(node)) + "' not defined.");
+                    break;
+                }
+                if (ast->childCount(node) != params) {
+                    error(node, "'" + spell(ast->symbol(node)) + "' takes " + std::to_string(params) +
+                                " argument(s), got " + std::to_string(ast->childCount(node)) + ".");
+                }
+                break;
+            }
+            case NodeKind::Thread: {
+                // A task has only the program's frame to run in.
+                NodeId call = ast->child(node, 0);
+                resolveNode(call);
+                if (out.callee[call] != UINT32_MAX && out.functions[out.callee[call]].level != 1)
+                    error(node, "'thread' needs a top-level function; '" + spell(ast->symbol(call)) + "' is nested.");
+                if (out.builtin[call] != Builtin::None)
+                    error(node, "'thread' needs a Quarter function; '" + spell(ast->symbol(call)) + "' is a builtin.");
+                break;
+            }
+            case NodeKind::Return:
+                if (binder.scope().level == 0) error(node, "'return' outside a function.");
+                for (NodeId child : ast->children(node)) resolveNode(child);
+                if (ast->childCount(node) && ast->kind(ast->child(node, 0)) == NodeKind::Call) {
+                    NodeId call = ast->child(node, 0);
+                    out.tailCall[call] = out.callee[call] != UINT32_MAX && out.slots[call].depth > 0;
+                }
+                break;
+            default:
+                for (NodeId child : ast->children(node)) resolveNode(child);
+                break;
+        }
+    }
+};
+
 // ====== QUARTERLANG READER: Core File Reader/Loader ======
 // Handles: File reading, string streaming, error management
-// Usage: QuarterReader qr("mycode.quarter"); std::string src = qr.getSource();
+// Usage: QuarterReader qr("mycode.quarter"); std::string_view src = qr.getSource();
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include "QuarterLang_SourceBuffer.h"
 
 class QuarterReader {
 public:
     // Constructor: Takes filename, attempts to read immediately
     explicit QuarterReader(const std::string& filename)
-        : source_(""), loaded_(false)
+        : loaded_(false)
     {
         loadFile(filename);
     }
 
-    // Fetches the source code as a string
-    const std::string& getSource() const {
-        return source_;
+    // Fetches the source code; the view lives as long as the reader
+    std::string_view getSource() const {
+        return source_.view();
     }
 
     // Checks if file loaded successfully
@@ -726,20 +1000,15 @@ public:
     }
 
 private:
-    std::string source_;
+    SourceBuffer source_;
     bool loaded_;
 
-    // Loads the file content into the source string
+    // Maps the file (or streams it, for pipes and "-") without copying it
     void loadFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::in | std::ios::binary);
-        if (!file) {
+        if (!source_.open(filename)) {
             loaded_ = false;
             throw std::runtime_error("QuarterReader: Unable to open file: " + filename);
         }
-
-        std::ostringstream ss;
-        ss << file.rdbuf();   // Slurp entire file
-        source_ = ss.str();
         loaded_ = true;
     }
 };
@@ -795,7 +1064,9 @@ public:
 #include <string>
 #include <unordered_map>
 #include <iostream>
+#include <type_traits>
 #include <variant>
+#include "QuarterOutput.h"
 
 // --- Typedefs for QuarterLang variable types ---
 using QuarterInt = int;
@@ -826,13 +1097,19 @@ public:
 
     // Output (say)
     void say(const QuarterValue& value) const {
-        std::visit([](auto&& val) {
-            std::cout << val << std::endl;
+        QuarterOutput& out = QuarterOutput::local();
+        std::visit([&out](auto&& val) {
+            using T = std::decay_t<decltype(val)>;
+            if constexpr (std::is_same_v<T, QuarterText>) out.write(val);
+            else if constexpr (std::is_same_v<T, QuarterDG>) out.writeGeneral(val);
+            else out.write(static_cast<int64_t>(val));
         }, value);
+        out.endLine();
     }
 
     // (OPTIONAL) Dump all variables for debug
     void dump() const {
+        QuarterOutput::local().flush();  // after what say() has buffered
         std::cout << "=== QuarterLang ENV ===" << std::endl;
         for (const auto& [name, value] : variables) {
             std::cout << name << " = ";
@@ -845,214 +1122,1368 @@ private:
     std::unordered_map<std::string, QuarterValue> variables;
 };
 
-// QuarterLang Runtime Engine — Core Implementation
-// Author: Violet Aura Creations (2025)
-
-#include <iostream>
+// NanBox.h
+// 8-byte runtime value shared by the tree walker and the VM. A double is
+// stored as itself; everything else hides in the payload of a quiet NaN
+// with the sign bit set, a pattern no arithmetic result produces once NaNs
+// are canonicalized:
+//
+//   0xFFF9 | 48-bit payload   none
+//   0xFFFA | 0 or 1           bool
+//   0xFFFB | 48-bit signed    int (results outside 48 bits become doubles)
+//   0xFFFC | 48-bit pointer   refcounted heap string, flat or a rope
+//   0xFFFD | length, bytes    short string, up to 5 bytes held in the word
+//   0xFFFE | 48-bit pointer   interned string, never freed
+//
+// Copying a number, bool, none, short or interned string is a register
+// move; copying a heap string bumps its refcount, never its characters.
+//
+// Every string of up to SHORT_MAX bytes is short, so a short string equals
+// another string exactly when their words are equal. String literals are
+// interned (intern()): evaluating one allocates nothing, and all threads
+// may share it. concat() copies results of up to FLAT_MAX bytes and makes
+// longer ones a rope node over its two halves, so a string grown piece by
+// piece in a loop costs linear time, not quadratic; asString() flattens a
+// rope in place the first time its characters are wanted. Refcounts are
+// not atomic and flattening writes to the string, so a heap string stays
+// on one thread; the walker gives threads flat copies.
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
-#include <memory>
-#include <variant>
-#include <functional>
-#include <stdexcept>
-#include <sstream>
-#include <stack>
 
-// === Value Representation ===
-enum class QType { NUMBER, STRING, BOOL, NONE };
-
-struct QValue {
-    QType type = QType::NONE;
-    double numValue = 0;
-    std::string strValue;
-    bool boolValue = false;
+// The VM's dispatch loop is one huge function, and GCC stops inlining into
+// it long before these one-liners; a call per push would cost more than the
+// boxing saves.
+#if defined(__GNUC__) || defined(__clang__)
+#define QTR_HOT inline __attribute__((always_inline))
+#define QTR_COLD __attribute__((noinline, cold))
+#else
+#define QTR_HOT inline
+#define QTR_COLD
+#endif
+
+// A short string's bytes are the low bytes of the word, read in place.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "NanBox keeps short strings in the word's memory order: little-endian targets only"
+#endif
+
+class NanBox {
+public:
+    static constexpr size_t SHORT_MAX = 5;
+    static constexpr size_t FLAT_MAX = 256;
+
+    QTR_HOT NanBox() : bits(TAG_NONE) {}
+    QTR_HOT NanBox(const NanBox& o) : bits(o.bits) { retain(); }
+    QTR_HOT NanBox(NanBox&& o) noexcept : bits(o.bits) { o.bits = TAG_NONE; }
+    QTR_HOT NanBox& operator=(const NanBox& o) {
+        o.retain();
+        release();
+        bits = o.bits;
+        return *this;
+    }
+    QTR_HOT NanBox& operator=(NanBox&& o) noexcept {
+        if (this != &o) {
+            release();
+            bits = o.bits;
+            o.bits = TAG_NONE;
+        }
+        return *this;
+    }
+    QTR_HOT ~NanBox() { release(); }
+
+    static NanBox none() { return NanBox(); }
+    QTR_HOT static NanBox number(double d) {
+        uint64_t b;
+        std::memcpy(&b, &d, sizeof b);
+        if (d != d) b = CANONICAL_NAN;  // keep NaNs out of the tagged space
+        return fromBits(b);
+    }
+    QTR_HOT static NanBox integer(int64_t i) {
+        if (i < INT_MIN48 || i > INT_MAX48) return number(static_cast<double>(i));
+        return fromBits(TAG_INT | (static_cast<uint64_t>(i) & PAYLOAD));
+    }
+    QTR_HOT static NanBox boolean(bool v) { return fromBits(TAG_BOOL | (v ? 1 : 0)); }
+    static NanBox string(std::string s) {
+        if (s.size() <= SHORT_MAX) return inlined(s);
+        return heap(new Str{1, s.size(), std::move(s), 0, 0});
+    }
+    // The one copy of `s` kept for the whole run, for literals and constants.
+    static NanBox intern(std::string_view s) {
+        if (s.size() <= SHORT_MAX) return inlined(s);
+        static std::mutex lock;
+        static auto& table = *new std::unordered_map<std::string_view, Str*>();  // never freed, like its entries
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = table.find(s);
+        Str* str = found != table.end() ? found->second : nullptr;
+        if (!str) {
+            str = new Str{0, s.size(), std::string(s), 0, 0};
+            table.emplace(str->chars, str);
+        }
+        return fromBits(TAG_INTERNED | (reinterpret_cast<uintptr_t>(str) & PAYLOAD));
+    }
+    // a followed by b; both must be strings.
+    static NanBox concat(const NanBox& a, const NanBox& b) {
+        size_t length = a.length() + b.length();
+        if (length == b.length()) return b;
+        if (length == a.length()) return a;
+        if (length <= FLAT_MAX) {  // neither is a rope
+            std::string chars;
+            chars.reserve(length);
+            chars += a.asString();
+            chars += b.asString();
+            return string(std::move(chars));
+        }
+        // A little more on the end of a rope: copy its last piece instead of
+        // nesting deeper, so the pieces grow towards FLAT_MAX.
+        if (a.isCounted() && a.str()->left) {
+            NanBox last = shared(a.str()->right);
+            if (last.length() + b.length() <= FLAT_MAX) return rope(shared(a.str()->left), concat(last, b));
+        }
+        return rope(a, b);
+    }
+
+    QTR_HOT bool isDouble() const { return (bits & BOXED) != BOXED; }
+    QTR_HOT bool isInt() const { return (bits & TAG_MASK) == TAG_INT; }
+    QTR_HOT bool isNumber() const { return isDouble() || isInt(); }
+    QTR_HOT bool isBool() const { return (bits & TAG_MASK) == TAG_BOOL; }
+    QTR_HOT bool isNone() const { return bits == TAG_NONE; }
+    QTR_HOT bool isString() const { return (bits & TAG_MASK) - TAG_STRING <= TAG_INTERNED - TAG_STRING; }
+    // A heap string: its copies share a refcount.
+    QTR_HOT bool isCounted() const { return (bits & TAG_MASK) == TAG_STRING; }
+
+    QTR_HOT double asDouble() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d;
+    }
+    QTR_HOT int64_t asInt() const { return static_cast<int64_t>(bits << 16) >> 16; }  // sign-extend
+    QTR_HOT bool asBool() const { return (bits & 1) != 0; }
+    // Flattens a rope. A short string's view points into this NanBox, so it
+    // lasts only as long as the NanBox does.
+    QTR_HOT std::string_view asString() const {
+        if ((bits & TAG_MASK) == TAG_SHORT) return {reinterpret_cast<const char*>(&bits), shortLength(bits)};
+        Str* s = str();
+        if (s->left) flatten(s);
+        return s->chars;
+    }
+    // In bytes, without flattening.
+    QTR_HOT size_t length() const { return (bits & TAG_MASK) == TAG_SHORT ? shortLength(bits) : str()->length; }
+    // Both must be strings.
+    static bool sameString(const NanBox& a, const NanBox& b) {
+        if (a.bits == b.bits) return true;
+        uint64_t ta = a.bits & TAG_MASK, tb = b.bits & TAG_MASK;
+        if (ta == TAG_SHORT || tb == TAG_SHORT) return false;     // the other is longer
+        if (ta == TAG_INTERNED && tb == TAG_INTERNED) return false;  // one entry per text
+        return a.length() == b.length() && a.asString() == b.asString();
+    }
+    // Int or double, as a double.
+    QTR_HOT double toDouble() const { return isInt() ? static_cast<double>(asInt()) : asDouble(); }
+
+    // A rope becomes flat now rather than when it is next read.
+    void flatten() const {
+        if (isCounted() && str()->left) flatten(str());
+    }
+
+    // The word itself, for code that moves values as raw bits (the JIT's
+    // handlers). adopt() takes over whatever reference the word carries.
+    QTR_HOT uint64_t raw() const { return bits; }
+    QTR_HOT static NanBox adopt(uint64_t b) { return fromBits(b); }
 
-    QValue() : type(QType::NONE) {}
-    QValue(double v) : type(QType::NUMBER), numValue(v) {}
-    QValue(const std::string& v) : type(QType::STRING), strValue(v) {}
-    QValue(bool v) : type(QType::BOOL), boolValue(v) {}
+private:
+    friend class BaselineJIT;  // emits the tag tests and refcount bumps inline
+
+    // Flat: `chars`, with no halves. Rope: `length` bytes, made of `left` then
+    // `right` (NanBox words, each holding a reference) until flattened.
+    struct Str {
+        uint32_t refs;  // unused when interned
+        size_t length;
+        std::string chars;
+        uint64_t left, right;
+    };
 
-    std::string toString() const {
-        switch (type) {
-            case QType::NUMBER: return std::to_string(numValue);
-            case QType::STRING: return strValue;
-            case QType::BOOL:   return boolValue ? "true" : "false";
-            default: return "none";
+    static constexpr uint64_t BOXED = 0xFFF8000000000000ull;   // sign + exponent + quiet bit
+    static constexpr uint64_t TAG_MASK = 0xFFFF000000000000ull;
+    static constexpr uint64_t PAYLOAD = 0x0000FFFFFFFFFFFFull;
+    static constexpr uint64_t TAG_NONE = 0xFFF9000000000000ull;
+    static constexpr uint64_t TAG_BOOL = 0xFFFA000000000000ull;
+    static constexpr uint64_t TAG_INT = 0xFFFB000000000000ull;
+    static constexpr uint64_t TAG_STRING = 0xFFFC000000000000ull;
+    static constexpr uint64_t TAG_SHORT = 0xFFFD000000000000ull;
+    static constexpr uint64_t TAG_INTERNED = 0xFFFE000000000000ull;
+    static constexpr uint64_t CANONICAL_NAN = 0x7FF8000000000000ull;
+    static constexpr int64_t INT_MAX48 = (int64_t(1) << 47) - 1;
+    static constexpr int64_t INT_MIN48 = -(int64_t(1) << 47);
+
+    uint64_t bits;
+
+    QTR_HOT static NanBox fromBits(uint64_t b) {
+        NanBox v;
+        v.bits = b;
+        return v;
+    }
+    static NanBox heap(Str* s) {
+        // User-space pointers fit in 48 bits on every 64-bit target we build for.
+        return fromBits(TAG_STRING | (reinterpret_cast<uintptr_t>(s) & PAYLOAD));
+    }
+    // Bytes in bits 0-39, length in bits 40-47.
+    static NanBox inlined(std::string_view s) {
+        uint64_t b = 0;
+        if (!s.empty()) std::memcpy(&b, s.data(), s.size());
+        return fromBits(TAG_SHORT | static_cast<uint64_t>(s.size()) << 40 | b);
+    }
+    QTR_HOT static size_t shortLength(uint64_t b) { return (b >> 40) & 0xFF; }
+    // A new reference to the string a rope half names.
+    static NanBox shared(uint64_t b) {
+        NanBox v = fromBits(b);
+        v.retain();
+        return v;
+    }
+    static NanBox rope(NanBox a, NanBox b) {
+        Str* s = new Str{1, a.length() + b.length(), {}, a.bits, b.bits};
+        a.bits = b.bits = TAG_NONE;  // their references now belong to s
+        return heap(s);
+    }
+
+    QTR_HOT static Str* strAt(uint64_t b) { return reinterpret_cast<Str*>(static_cast<uintptr_t>(b & PAYLOAD)); }
+    QTR_HOT Str* str() const { return strAt(bits); }
+    QTR_HOT void retain() const {
+        if (isCounted()) ++str()->refs;
+    }
+    // The tag test stays inline in every copy; only heap strings pay for a call.
+    QTR_HOT void release() {
+        if (isCounted()) drop(str());
+    }
+    QTR_COLD static void drop(Str* s) {
+        if (--s->refs) return;
+        if (!s->left) {
+            delete s;
+            return;
+        }
+        // A rope is as deep as the loop that built it was long: take it
+        // apart with a worklist rather than recursion.
+        std::vector<Str*> doomed{s};
+        while (!doomed.empty()) {
+            Str* d = doomed.back();
+            doomed.pop_back();
+            for (uint64_t half : {d->left, d->right}) {
+                if ((half & TAG_MASK) == TAG_STRING && --strAt(half)->refs == 0) doomed.push_back(strAt(half));
+            }
+            delete d;
         }
     }
-};
+    QTR_COLD static void flatten(Str* s) {
+        std::string chars;
+        chars.reserve(s->length);
+        std::vector<uint64_t> pending{s->right, s->left};
+        while (!pending.empty()) {
+            uint64_t b = pending.back();
+            pending.pop_back();
+            if ((b & TAG_MASK) == TAG_SHORT) {
+                chars.append(reinterpret_cast<const char*>(&b), shortLength(b));
+                continue;
+            }
+            Str* piece = strAt(b);
+            if (piece->left) {
+                pending.push_back(piece->right);
+                pending.push_back(piece->left);
+            } else {
+                chars += piece->chars;
+            }
+        }
+        s->chars = std::move(chars);
+        NanBox left = fromBits(s->left), right = fromBits(s->right);  // released on return
+        s->left = s->right = 0;
+    }
+};
+
+static_assert(sizeof(NanBox) == 8, "NanBox must stay one machine word");
+
+// TaskScheduler.h
+// Runs lightweight tasks on a fixed set of worker threads, one per core,
+// so a program may have thousands of tasks in flight without an OS thread
+// for each. Every worker owns a deque: it pushes the tasks it spawns at the
+// back and takes its own work from the back too (newest first, still warm
+// in cache), while idle workers steal from the front of someone else's
+// deque (oldest first, usually the largest piece of work left). Threads
+// that are not workers, such as the one running the main program, share
+// one more deque.
+//
+// A task runs to completion on whichever thread took it. A TaskGroup
+// counts the tasks spawned into it; wait() keeps the waiting thread busy
+// running queued tasks until its group is done, so waiting never ties up
+// a worker and nested waits cannot deadlock. The first exception a task of
+// the group threw is rethrown by wait(). A group may also wait for work done
+// outside the scheduler, such as I/O: hold() counts it in and release()
+// counts it out, from whichever thread saw it finish.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-// === Variable Environment ===
-using QEnv = std::unordered_map<std::string, QValue>;
+class TaskScheduler;
 
-// === AST Node Types (Simplified) ===
-enum class QNodeType { PROGRAM, VAL, VAR, ASSIGN, SAY, ASK, IF, LOOP, FUNC_DEF, FUNC_CALL, BLOCK };
+class TaskGroup {
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
 
-// === AST Node Definition ===
-struct QNode {
-    QNodeType type;
-    std::string name;
-    std::vector<std::shared_ptr<QNode>> children;
-    QValue value;
-    std::vector<std::string> params; // for func_def
-    // Extra fields can be added as needed
+    bool done() const { return pending.load() == 0; }
 
-    QNode(QNodeType t) : type(t) {}
+private:
+    friend class TaskScheduler;
+    std::atomic<size_t> pending{0};
+    std::mutex lock;
+    std::exception_ptr error;  // the first one, under `lock`
 };
 
-// === Runtime Context / Call Stack Frame ===
-struct QFrame {
-    QEnv vars;
-    std::unordered_map<std::string, std::shared_ptr<QNode>> functions;
-    QFrame* parent = nullptr;
+class TaskScheduler {
+public:
+    // The process-wide scheduler; its workers start on first use.
+    static TaskScheduler& global() {
+        static TaskScheduler instance;
+        return instance;
+    }
+
+    explicit TaskScheduler(unsigned workers = std::thread::hardware_concurrency())
+        : workerCount(std::max(1u, workers)) {
+        for (unsigned i = 0; i <= workerCount; ++i) deques.push_back(std::make_unique<Deque>());
+        threads.reserve(workerCount);
+        for (unsigned i = 0; i < workerCount; ++i) threads.emplace_back([this, i] { work(i); });
+    }
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Every group must have been waited for.
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) t.join();
+    }
+
+    unsigned workers() const { return workerCount; }
 
-    QValue getVar(const std::string& name) {
-        if (vars.count(name)) return vars[name];
-        if (parent) return parent->getVar(name);
-        throw std::runtime_error("Variable '" + name + "' not defined.");
+    void spawn(TaskGroup& group, std::function<void()> run) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        deques[self()]->push({std::move(run), &group});
+        queued.fetch_add(1);
+        if (sleeping.load() > 0) {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            wake.notify_one();
+        }
+    }
+
+    void hold(TaskGroup& group) { group.pending.fetch_add(1, std::memory_order_relaxed); }
+    void release(TaskGroup& group, std::exception_ptr error = nullptr) {
+        if (error) {
+            std::lock_guard<std::mutex> guard(group.lock);
+            if (!group.error) group.error = error;
+        }
+        if (group.pending.fetch_sub(1) == 1 && sleeping.load() > 0) {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            wake.notify_all();
+        }
     }
-    void setVar(const std::string& name, const QValue& val) {
-        if (vars.count(name)) vars[name] = val;
-        else if (parent) parent->setVar(name, val);
-        else throw std::runtime_error("Variable '" + name + "' not defined.");
+
+    // Returns once every task spawned into `group` has finished, running
+    // queued tasks meanwhile; rethrows the first exception one of them threw.
+    void wait(TaskGroup& group) {
+        size_t me = self();
+        while (!group.done()) {
+            Task task;
+            if (take(me, task)) {
+                execute(task);
+                continue;
+            }
+            // Nothing to help with: sleep until a task is queued or the
+            // group's last one finishes.
+            sleeping.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> guard(sleepLock);
+                wake.wait(guard, [&] { return group.done() || queued.load() > 0; });
+            }
+            sleeping.fetch_sub(1);
+        }
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> guard(group.lock);
+            std::swap(error, group.error);
+        }
+        if (error) std::rethrow_exception(error);
     }
-    void defineVar(const std::string& name, const QValue& val) {
-        vars[name] = val;
+
+private:
+    struct Task {
+        std::function<void()> run;
+        TaskGroup* group = nullptr;
+    };
+
+    class Deque {
+    public:
+        void push(Task task) {
+            std::lock_guard<std::mutex> guard(lock);
+            items.push_back(std::move(task));
+        }
+        bool pop(Task& out) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (items.empty()) return false;
+            out = std::move(items.back());
+            items.pop_back();
+            return true;
+        }
+        bool steal(Task& out) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (items.empty()) return false;
+            out = std::move(items.front());
+            items.pop_front();
+            return true;
+        }
+
+    private:
+        std::deque<Task> items;
+        std::mutex lock;
+    };
+
+    unsigned workerCount;
+    std::vector<std::unique_ptr<Deque>> deques;  // one per worker, then the shared one
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued{0};    // tasks in any deque
+    std::atomic<size_t> sleeping{0};  // threads that may be blocked on `wake`
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping = false;            // under sleepLock
+
+    // This thread's deque: its own if it is one of our workers.
+    size_t self() const {
+        return current.owner == this ? current.index : workerCount;
+    }
+    struct Identity {
+        const TaskScheduler* owner;
+        size_t index;
+    };
+    static inline thread_local Identity current;  // zero until work() sets it
+
+    bool take(size_t me, Task& out) {
+        if (queued.load() == 0) return false;
+        if (deques[me]->pop(out)) {
+            queued.fetch_sub(1);
+            return true;
+        }
+        for (size_t k = 1; k < deques.size(); ++k) {
+            if (deques[(me + k) % deques.size()]->steal(out)) {
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
     }
-    void defineFunc(const std::string& name, std::shared_ptr<QNode> def) {
-        functions[name] = def;
+
+    void execute(Task& task) {
+        std::exception_ptr error;
+        try {
+            task.run();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        task.run = nullptr;  // whatever it captured goes before the group is done
+        release(*task.group, error);
     }
-    std::shared_ptr<QNode> getFunc(const std::string& name) {
-        if (functions.count(name)) return functions[name];
-        if (parent) return parent->getFunc(name);
-        throw std::runtime_error("Function '" + name + "' not defined.");
+
+    void work(size_t index) {
+        current = {this, index};
+        for (;;) {
+            Task task;
+            if (take(index, task)) {
+                execute(task);
+                continue;
+            }
+            sleeping.fetch_add(1);
+            std::unique_lock<std::mutex> guard(sleepLock);
+            wake.wait(guard, [&] { return stopping || queued.load() > 0; });
+            sleeping.fetch_sub(1);
+            if (stopping) return;
+        }
     }
 };
 
-// === Interpreter / Runtime Engine ===
-class QuarterRuntime {
+// Pipe.h
+// `pipe write: "log.txt"` sends a program's output to a file without a
+// system call per line. Lines go into a bounded ring and a writer thread,
+// one per open file, takes out everything that is waiting and hands it to
+// the kernel in a single writev. A thread that logs faster than the disk
+// keeps up therefore gets ever larger batches instead of ever more calls.
+//
+// PipeRing is the bounded multi-producer, single-consumer queue from
+// Dmitry Vyukov's design: each cell has a sequence number saying whose turn
+// it is, so producers claim cells with one compare-and-swap on the tail and
+// never take a lock. With a single producer that CAS always succeeds at
+// the first try. When the ring is full, writers wait for the drain rather
+// than grow it.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+template <typename T>
+class PipeRing {
 public:
-    QuarterRuntime(std::shared_ptr<QNode> program)
-        : programNode(program), globalFrame(new QFrame{}) {}
+    // `capacity` is rounded up to a power of two.
+    explicit PipeRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    PipeRing(const PipeRing&) = delete;
+    PipeRing& operator=(const PipeRing&) = delete;
+
+    // Any thread. Takes `value` only if there was room.
+    bool push(T& value) {
+        size_t at = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[at & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t turn = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(at);
+            if (turn == 0) {
+                if (tail.compare_exchange_weak(at, at + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(at + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (turn < 0) {
+                return false;  // the consumer has not freed this cell yet
+            } else {
+                at = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
 
-    void run() {
-        execNode(programNode.get(), globalFrame.get());
+    // The consumer thread only, like empty().
+    bool pop(T& out) {
+        Cell& cell = cells[head & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        out = std::move(cell.value);
+        cell.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+    bool empty() const {
+        return cells[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
     }
 
 private:
-    std::shared_ptr<QNode> programNode;
-    std::unique_ptr<QFrame> globalFrame;
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};  // next cell a producer claims
+    alignas(64) size_t head = 0;              // next cell the consumer reads
+};
 
-    QValue execNode(QNode* node, QFrame* frame) {
-        switch (node->type) {
-            case QNodeType::PROGRAM:
-                for (auto& child : node->children) execNode(child.get(), frame);
-                break;
+// A file opened by `pipe`. Whoever drops the last reference waits for
+// everything written so far to reach the file.
+class FileSink {
+public:
+    static constexpr size_t CAPACITY = 4096;  // lines in flight before writers wait
 
-            case QNodeType::VAL:
-            case QNodeType::VAR: {
-                QValue val = node->value;
-                frame->defineVar(node->name, val);
-                break;
-            }
-            case QNodeType::ASSIGN: {
-                QValue val = evalExpr(node->children[0].get(), frame);
-                frame->setVar(node->name, val);
-                break;
-            }
-            case QNodeType::SAY: {
-                QValue val = evalExpr(node->children[0].get(), frame);
-                std::cout << val.toString() << std::endl;
-                break;
-            }
-            case QNodeType::ASK: {
-                std::string input;
-                std::getline(std::cin, input);
-                frame->defineVar(node->name, QValue(input));
-                break;
-            }
-            case QNodeType::IF: {
-                QValue cond = evalExpr(node->children[0].get(), frame);
-                if (cond.boolValue) execNode(node->children[1].get(), frame);
-                else if (node->children.size() > 2)
-                    execNode(node->children[2].get(), frame); // else branch
-                break;
+    // Throws std::runtime_error if the file cannot be opened.
+    FileSink(std::string file, bool append) : path(std::move(file)), ring(CAPACITY) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+        if (fd < 0) throw std::runtime_error("Cannot open '" + path + "' for pipe: " + std::strerror(errno));
+        writer = std::thread([this] { drain(); });
+    }
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    ~FileSink() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            closing = true;
+        }
+        wake.notify_one();
+        writer.join();
+        ::close(fd);
+    }
+
+    // Any thread. Lines from one thread reach the file in order. Throws
+    // if an earlier batch could not be written.
+    void write(std::string line) {
+        if (int error = failure.load(std::memory_order_relaxed))
+            throw std::runtime_error("Writing pipe '" + path + "' failed: " + std::strerror(error));
+        while (!ring.push(line)) {
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        wakeWriter();
+    }
+
+private:
+    std::string path;
+    int fd = -1;
+    PipeRing<std::string> ring;
+    std::thread writer;
+    std::atomic<int> failure{0};       // errno of the first failed write
+    std::atomic<bool> sleeping{false};  // the writer may be blocked on `wake`
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool closing = false;               // under sleepLock
+
+    // Only the first writer to find it asleep wakes it; the rest of a burst
+    // costs no system call at all.
+    void wakeWriter() {
+        // Pairs with the fence in drain(): either it sees our line, or we
+        // see it asleep.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!sleeping.load(std::memory_order_relaxed) || !sleeping.exchange(false)) return;
+        std::lock_guard<std::mutex> guard(sleepLock);
+        wake.notify_one();
+    }
+
+    void drain() {
+        const size_t batchLimit = std::min<size_t>(IOV_MAX, 1024);
+        std::vector<std::string> batch(batchLimit);
+        std::vector<iovec> pieces(batchLimit);
+        bool last = false;
+        for (;;) {
+            size_t count = 0;
+            while (count < batchLimit && ring.pop(batch[count])) ++count;
+            if (count) {
+                flush(batch.data(), pieces.data(), count);
+                continue;
             }
-            case QNodeType::LOOP: {
-                while (evalExpr(node->children[0].get(), frame).boolValue) {
-                    execNode(node->children[1].get(), frame);
-                }
-                break;
+            if (last) return;
+            std::unique_lock<std::mutex> guard(sleepLock);
+            if (closing) {
+                last = true;  // one more pass catches the final lines
+                continue;
             }
-            case QNodeType::FUNC_DEF: {
-                frame->defineFunc(node->name, std::make_shared<QNode>(*node));
-                break;
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring.empty()) wake.wait(guard);
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Writes lines[0..count) in as few calls as the kernel allows, then
+    // frees them. After a failure the rest is dropped.
+    void flush(std::string* lines, iovec* pieces, size_t count) {
+        for (size_t i = 0; i < count; ++i) pieces[i] = {lines[i].data(), lines[i].size()};
+        iovec* next = pieces;
+        size_t left = count;
+        while (left && !failure.load(std::memory_order_relaxed)) {
+            ssize_t written = ::writev(fd, next, static_cast<int>(left));
+            if (written < 0) {
+                if (errno != EINTR) failure.store(errno);
+                continue;
             }
-            case QNodeType::FUNC_CALL: {
-                auto funcNode = frame->getFunc(node->name);
-                QFrame localFrame;
-                localFrame.parent = frame;
-                // assign params
-                for (size_t i = 0; i < funcNode->params.size(); ++i) {
-                    QValue argVal = evalExpr(node->children[i].get(), frame);
-                    localFrame.defineVar(funcNode->params[i], argVal);
-                }
-                return execNode(funcNode->children[0].get(), &localFrame);
+            size_t done = static_cast<size_t>(written);
+            while (left && done >= next->iov_len) {
+                done -= next->iov_len;
+                ++next;
+                --left;
             }
-            case QNodeType::BLOCK: {
-                for (auto& child : node->children) execNode(child.get(), frame);
-                break;
+            if (left) {
+                next->iov_base = static_cast<char*>(next->iov_base) + done;
+                next->iov_len -= done;
             }
-            default:
-                throw std::runtime_error("Unknown node type in runtime.");
         }
-        return QValue();
+        for (size_t i = 0; i < count; ++i) lines[i] = std::string();
     }
+};
 
-    // === Expression Evaluator ===
-    QValue evalExpr(QNode* node, QFrame* frame) {
-        // For demo: numbers, variables, string literals, bools
-        if (node->type == QNodeType::VAL || node->type == QNodeType::VAR) {
-            return frame->getVar(node->name);
+// QuarterOutput.h
+// Where `say` writes when it is not piped. Every thread fills a buffer of
+// its own and hands it to stdout in one call when it is nearly full, when
+// the program reads input or ends, or on flush(); a line costs a memcpy,
+// with no lock and no system call. Only whole lines are handed over before
+// the end, so lines from different threads never mix. Buffers go through
+// stdio rather than straight to the descriptor, which keeps them in order
+// with whatever else the process printed with std::cout or printf.
+//
+// Numbers are formatted with std::to_chars into the buffer itself, with
+// the same text printf gives for the format named.
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class QuarterOutput {
+public:
+    static constexpr size_t CAPACITY = 64 * 1024;
+
+    // This thread's buffer; what is left in it is written when the thread
+    // exits.
+    static QuarterOutput& local() {
+        static thread_local QuarterOutput out;
+        return out;
+    }
+
+    QuarterOutput() : buffer(new char[CAPACITY]) {}
+    QuarterOutput(const QuarterOutput&) = delete;
+    QuarterOutput& operator=(const QuarterOutput&) = delete;
+    ~QuarterOutput() { flush(); }
+
+    void write(std::string_view text) {
+        if (used + text.size() > CAPACITY) {
+            flushLines();
+            if (used + text.size() > CAPACITY) {
+                flush();  // a line longer than the buffer goes out as it is
+                std::fwrite(text.data(), 1, text.size(), stdout);
+                return;
+            }
         }
-        // Extend: arithmetic, comparisons, etc.
-        return node->value;
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+    }
+    void write(int64_t value) {
+        reserve(24);
+        used = std::to_chars(buffer.get() + used, buffer.get() + CAPACITY, value).ptr - buffer.get();
+    }
+    // Quarter's one text form of a number: "%f", as std::to_string prints
+    // doubles. Every engine prints and concatenates numbers through these
+    // two, so a program's output does not depend on the engine.
+    static std::string fixed(double value) {
+        char text[MAX_FIXED];
+        return std::string(text, std::to_chars(text, text + MAX_FIXED, value, std::chars_format::fixed, 6).ptr);
+    }
+    void writeFixed(double value) {
+        reserve(MAX_FIXED);
+        used = std::to_chars(buffer.get() + used, buffer.get() + CAPACITY, value, std::chars_format::fixed, 6).ptr -
+               buffer.get();
+    }
+    // Like "%g", as iostreams print doubles by default.
+    void writeGeneral(double value) {
+        reserve(32);
+        used = std::to_chars(buffer.get() + used, buffer.get() + CAPACITY, value, std::chars_format::general, 6).ptr -
+               buffer.get();
+    }
+    void endLine() {
+        reserve(1);
+        buffer[used++] = '\n';
+        lineStart = used;
     }
-};
 
-// === Demo: Build and Run a Simple Quarter Program ===
-std::shared_ptr<QNode> demoQuarterProgram() {
-    // star
-    //   val x = 10
-    //   var y = "hello"
-    //   say y
-    // end
+    // Everything so far, including a line not yet ended.
+    void flush() {
+        if (used) std::fwrite(buffer.get(), 1, used, stdout);
+        used = lineStart = 0;
+        std::fflush(stdout);
+    }
 
-    auto program = std::make_shared<QNode>(QNodeType::PROGRAM);
-    auto valX = std::make_shared<QNode>(QNodeType::VAL);
-    valX->name = "x";
-    valX->value = QValue(10);
+private:
+    static constexpr size_t MAX_FIXED = 320;  // -1e308 is 309 digits, then ".000000"
 
-    auto varY = std::make_shared<QNode>(QNodeType::VAR);
-    varY->name = "y";
-    varY->value = QValue("hello");
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+    size_t lineStart = 0;  // where the line being written began
 
-    auto sayY = std::make_shared<QNode>(QNodeType::SAY);
-    auto yExpr = std::make_shared<QNode>(QNodeType::VAR);
-    yExpr->name = "y";
-    sayY->children.push_back(yExpr);
+    void reserve(size_t bytes) {
+        if (used + bytes > CAPACITY) flushLines();
+        if (used + bytes > CAPACITY) flush();
+    }
+    // Hands over the complete lines and keeps the one being written.
+    void flushLines() {
+        if (!lineStart) return;
+        std::fwrite(buffer.get(), 1, lineStart, stdout);
+        std::fflush(stdout);
+        std::memmove(buffer.get(), buffer.get() + lineStart, used - lineStart);
+        used -= lineStart;
+        lineStart = 0;
+    }
+};
 
-    program->children = {valX, varY, sayY};
-    return program;
-}
+// QuarterLang Runtime Engine — Core Implementation
+// Author: Violet Aura Creations (2025)
 
-int main() {
-    try {
-        auto prog = demoQuarterProgram();
-        QuarterRuntime runtime(prog);
-        runtime.run();
-    } catch (const std::exception& ex) {
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <variant>
+#include <functional>
+#include <stdexcept>
+#include <sstream>
+#include <stack>
+#include <atomic>
+#include <mutex>
+#include "AstArena.h"
+#include "NanBox.h"
+#include "QuarterLangBinder.hpp"
+#include "Pipe.h"
+#include "QuarterLang_AsyncIO.h"
+#include "QuarterOutput.h"
+#include "TaskScheduler.h"
+
+// === Value Representation ===
+// One NanBox word (see NanBox.h). The walker keeps every number a double.
+using QValue = NanBox;
+
+inline std::string toString(const QValue& v) {
+    if (v.isNumber()) return QuarterOutput::fixed(v.toDouble());
+    if (v.isString()) return std::string(v.asString());
+    if (v.isBool())   return v.asBool() ? "true" : "false";
+    return "none";
+}
+// v as a string value: a string as it is, anything else through toString.
+inline QValue toText(const QValue& v) {
+    return v.isString() ? v : NanBox::string(toString(v));
+}
+// toString(v), written straight into `out`.
+inline void print(QuarterOutput& out, const QValue& v) {
+    if (v.isNumber()) out.writeFixed(v.toDouble());
+    else if (v.isString()) out.write(v.asString());
+    else if (v.isBool()) out.write(v.asBool() ? "true" : "false");
+    else out.write("none");
+}
+
+// === AST: the shared AstArena (see AstArena.h) ===
+
+// === Runtime Context / Call Stack ===
+// Every frame's slots are one window of a single slot stack: a call takes
+// the next frameSize slots and its return hands them back, so once the
+// stack has grown to the program's deepest call, calls allocate nothing.
+// Frames name each other by index because the stack may move as it grows.
+// `parent` is the lexically enclosing frame, so a resolved (depth, slot) is
+// `depth` hops and one index, with no hashing. A tail call reuses its
+// caller's frame and window, so tail recursion runs in constant space.
+// Frame 0 is the program's; its slots are the globals, kept apart from the
+// slot stack so that threads can share them.
+struct QFrame {
+    uint32_t base;    // first slot in the slot stack
+    uint32_t parent;  // index in the frame stack
+    std::unique_ptr<TaskGroup> tasks;  // threads it started and has not joined
+};
+
+// === Threads ===
+// `thread f(args)` runs the call as a TaskScheduler task, on a runtime of
+// its own: its own slot stack and frames, sharing only the globals. A frame
+// joins the threads it started at `await` and again before it returns, and
+// the first error one of them raised is raised there.
+//
+// NanBox reference counts are not atomic, so no heap string may be
+// reachable from two threads. Arguments are copied into the task. While any
+// task is running, globals are read and written under a lock; a task reads a
+// copy and stores a copy, and what it overwrites is only freed once no task
+// is left, since the main thread may still hold it. Reading a rope flattens
+// it in place, so the globals hold no ropes while tasks run: they are
+// flattened when the first task starts and as the main thread stores them.
+//
+// `pipe write: file` (or `append:`) sends the `say`s that follow to a
+// FileSink. The pipe belongs to the runtime that opened it; a thread starts
+// with its parent's, and the file is complete once the program has ended.
+
+// === Files ===
+// read_file, write_file and write_bytes go through AsyncIO. A write is
+// started and left running: the frame joins it like a thread, at `await` or
+// on its way out, and its error is raised there. read_file waits for its
+// data, but the waiting thread runs queued tasks meanwhile, so threads that
+// each read a file have all their reads in flight at once. AsyncIO keeps
+// operations on one path in order, so a read sees an earlier write.
+
+// === Interpreter / Runtime Engine ===
+class QuarterRuntime {
+public:
+    // Every Quarter call is several nested C++ calls; this keeps the native
+    // stack well inside 8 MB even in unoptimized and sanitizer builds. Tail
+    // calls do not count.
+    static constexpr size_t MAX_CALL_DEPTH = 1000;
+
+    // Resolves names up front; throws std::runtime_error if any do not.
+    QuarterRuntime(const AstArena& tree, NodeId program)
+        : QuarterRuntime(tree, program, std::make_shared<Shared>(Resolver().resolve(tree, program)), false) {
+        shared->globals.resize(names.frameSize[program]);
+        shared->literals.resize(tree.size());
+        for (NodeId node = 0; node < tree.size(); ++node) {
+            if (tree.kind(node) == NodeKind::StringLiteral) shared->literals[node] = NanBox::intern(tree.text(node));
+        }
+    }
+
+    void run() {
+        try {
+            execNode(programNode, 0);
+            join(0);
+        } catch (...) {
+            abandon();
+            pipe.reset();
+            QuarterOutput::local().flush();
+            throw;
+        }
+        pipe.reset();  // waits until the file has it all
+        QuarterOutput::local().flush();
+    }
+
+private:
+    struct Shared {
+        explicit Shared(ResolvedNames resolved) : names(std::move(resolved)) {}
+        ResolvedNames names;
+        std::vector<QValue> literals;   // StringLiteral -> its interned text
+        std::vector<QValue> globals;
+        std::mutex lock;                // globals and retired, while tasks run
+        std::vector<QValue> retired;    // strings tasks overwrote in globals
+        std::atomic<size_t> tasks{0};   // started and not finished, program-wide
+    };
+
+    const AstArena& ast;
+    NodeId programNode;
+    std::shared_ptr<Shared> shared;
+    const ResolvedNames& names;
+    bool isTask;
+    std::shared_ptr<FileSink> pipe;  // where `say` writes, if not stdout
+    std::vector<QValue> slotStack;
+    std::vector<QFrame> frames;
+    bool returning = false;  // a `return` is unwinding to its call
+    QValue returnValue;
+    NodeId tailCall = NO_NODE;   // set instead of returnValue by a tail call
+    uint32_t tailParent = 0;     // its callee's parent frame
+
+    QuarterRuntime(const AstArena& tree, NodeId program, std::shared_ptr<Shared> state, bool task)
+        : ast(tree), programNode(program), shared(std::move(state)), names(shared->names), isTask(task) {
+        slotStack.reserve(task ? 64 : 1024);
+        frames.reserve(task ? 16 : 256);
+        frames.push_back({0, 0, nullptr});
+    }
+
+    uint32_t up(uint32_t frame, uint32_t depth) const {
+        while (depth--) frame = frames[frame].parent;
+        return frame;
+    }
+    // Short and interned strings are safe to share; heap ones are copied.
+    static QValue isolate(const QValue& v) {
+        return v.isCounted() ? NanBox::string(std::string(v.asString())) : v;
+    }
+
+    QValue load(uint32_t frame, const VarSlot& v) {
+        frame = up(frame, v.depth);
+        if (frame) return slotStack[frames[frame].base + v.slot];
+        if (!isTask && shared->tasks.load() == 0) return shared->globals[v.slot];
+        std::lock_guard<std::mutex> guard(shared->lock);
+        return isTask ? isolate(shared->globals[v.slot]) : shared->globals[v.slot];
+    }
+    void store(uint32_t frame, const VarSlot& v, QValue value) {
+        frame = up(frame, v.depth);
+        if (frame) {
+            slotStack[frames[frame].base + v.slot] = std::move(value);
+            return;
+        }
+        if (!isTask && shared->tasks.load() == 0) {
+            shared->globals[v.slot] = std::move(value);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(shared->lock);
+        QValue& global = shared->globals[v.slot];
+        if (!isTask) {
+            value.flatten();
+            global = std::move(value);
+            return;
+        }
+        if (global.isCounted()) shared->retired.push_back(std::move(global));
+        global = isolate(value);
+    }
+
+    void spawn(uint32_t frame, uint32_t callee, std::vector<QValue> args) {
+        std::unique_ptr<TaskGroup>& group = frames[frame].tasks;
+        if (!group) group = std::make_unique<TaskGroup>();
+        if (shared->tasks.load() == 0) {
+            for (const QValue& global : shared->globals) global.flatten();
+        }
+        shared->tasks.fetch_add(1);
+        TaskScheduler::global().spawn(*group, [state = shared, &tree = ast, program = programNode, callee,
+                                               args = std::move(args), sink = pipe]() mutable {
+            struct Finished {
+                Shared& state;
+                ~Finished() {
+                    QuarterOutput::local().flush();  // the worker's buffer, before anyone joins
+                    state.tasks.fetch_sub(1);
+                }
+            } finished{*state};
+            QuarterRuntime task(tree, program, state, true);
+            task.pipe = std::move(sink);
+            task.runTask(callee, std::move(args));
+        });
+    }
+    void runTask(uint32_t callee, std::vector<QValue> args) {
+        const FunctionInfo& fn = names.functions[callee];
+        try {
+            slotStack.resize(fn.frameSize);
+            std::move(args.begin(), args.end(), slotStack.begin());
+            invoke(fn, 0, 0);
+        } catch (...) {
+            abandon();
+            throw;
+        }
+    }
+    void join(uint32_t frame) {
+        std::unique_ptr<TaskGroup>& group = frames[frame].tasks;
+        if (!group) return;
+        TaskScheduler::global().wait(*group);
+        group.reset();
+        if (!isTask && shared->tasks.load() == 0) shared->retired.clear();
+    }
+    // On an error: threads still running were started by frames that are
+    // gone, so they are waited for here and their own errors dropped.
+    void abandon() {
+        for (QFrame& f : frames) {
+            if (!f.tasks) continue;
+            try {
+                TaskScheduler::global().wait(*f.tasks);
+            } catch (...) {
+            }
+            f.tasks.reset();
+        }
+    }
+
+    void execNode(NodeId node, uint32_t frame) {
+        switch (ast.kind(node)) {
+            case NodeKind::Program:
+            case NodeKind::Block:
+                for (NodeId child : ast.children(node)) {
+                    execNode(child, frame);
+                    if (returning) return;
+                }
+                break;
+
+            case NodeKind::Val:
+            case NodeKind::Var:
+            case NodeKind::Assign: {
+                QValue val = evalExpr(ast.child(node, 0), frame);
+                store(frame, names.at(node), std::move(val));
+                break;
+            }
+            case NodeKind::Say: {
+                QValue val = evalExpr(ast.child(node, 0), frame);
+                if (pipe) {
+                    pipe->write(toString(val) + "\n");
+                } else {
+                    QuarterOutput& out = QuarterOutput::local();
+                    print(out, val);
+                    out.endLine();
+                }
+                break;
+            }
+            case NodeKind::Pipe: {
+                static const SymbolId append = SymbolInterner::global().intern("append");
+                QValue file = evalExpr(ast.child(node, 0), frame);
+                if (!file.isString())
+                    throw std::runtime_error("Pipe target must be a file name at line " + std::to_string(ast.line(node)));
+                pipe = std::make_shared<FileSink>(std::string(file.asString()), ast.symbol(node) == append);
+                break;
+            }
+            case NodeKind::Ask: {
+                QuarterOutput::local().flush();  // whatever prompted for it shows first
+                std::string input;
+                std::getline(std::cin, input);
+                store(frame, names.at(node), NanBox::string(std::move(input)));
+                break;
+            }
+            case NodeKind::If: {
+                QValue cond = evalExpr(ast.child(node, 0), frame);
+                if (truthy(cond)) execNode(ast.child(node, 1), frame);
+                else if (ast.childCount(node) > 2)
+                    execNode(ast.child(node, 2), frame); // else branch
+                break;
+            }
+            case NodeKind::While: {
+                while (truthy(evalExpr(ast.child(node, 0), frame))) {
+                    execNode(ast.child(node, 1), frame);
+                    if (returning) return;
+                }
+                break;
+            }
+            case NodeKind::Loop: {
+                QValue from = evalExpr(ast.child(node, 0), frame);
+                QValue to = evalExpr(ast.child(node, 1), frame);
+                if (!from.isNumber() || !to.isNumber())
+                    throw std::runtime_error("Loop bounds must be numbers at line " + std::to_string(ast.line(node)));
+                const VarSlot& counter = names.at(node);
+                double last = to.toDouble();
+                store(frame, counter, from);
+                // The counter is read again each time: the body may assign it.
+                for (;;) {
+                    QValue i = load(frame, counter);
+                    if (!i.isNumber())
+                        throw std::runtime_error("Loop counter must stay a number at line " + std::to_string(ast.line(node)));
+                    if (i.toDouble() > last) break;
+                    execNode(ast.child(node, 2), frame);
+                    if (returning) return;
+                    QValue next = load(frame, counter);
+                    if (next.isNumber()) store(frame, counter, NanBox::number(next.toDouble() + 1));
+                }
+                break;
+            }
+            case NodeKind::FuncDef:
+                break;  // registered in the function table by the Resolver
+            case NodeKind::Call:
+                call(node, frame);
+                break;
+            case NodeKind::Thread: {
+                NodeId callee = ast.child(node, 0);
+                std::vector<QValue> args;
+                for (NodeId arg : ast.children(callee)) args.push_back(isolate(evalExpr(arg, frame)));
+                spawn(frame, names.callee[callee], std::move(args));
+                break;
+            }
+            case NodeKind::Await:
+                join(frame);
+                break;
+            case NodeKind::Return: {
+                NodeId value = ast.childCount(node) ? ast.child(node, 0) : NO_NODE;
+                if (value != NO_NODE && names.tailCall[value]) {
+                    // The arguments wait on top of the slot stack; call()
+                    // moves them into this frame once the body has unwound.
+                    for (NodeId arg : ast.children(value)) {
+                        QValue v = evalExpr(arg, frame);
+                        slotStack.push_back(std::move(v));
+                    }
+                    tailCall = value;
+                    tailParent = up(frame, names.at(value).depth);
+                } else {
+                    returnValue = value != NO_NODE ? evalExpr(value, frame) : QValue();
+                }
+                returning = true;
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown node type in runtime.");
+        }
+    }
+
+    QValue call(NodeId node, uint32_t frame) {
+        if (names.builtin[node] != Builtin::None) return callBuiltin(node, frame);
+        const FunctionInfo& fn = names.function(node);
+        if (frames.size() >= MAX_CALL_DEPTH)
+            throw std::runtime_error("Call depth limit exceeded at line " + std::to_string(ast.line(node)));
+        uint32_t parent = up(frame, names.at(node).depth);
+        uint32_t base = static_cast<uint32_t>(slotStack.size());
+        slotStack.resize(base + fn.frameSize);
+        // Arguments are evaluated in the caller's frame; any calls they make
+        // stack above this window and are gone again before the next one.
+        for (uint32_t i = 0; i < fn.params; ++i) {
+            QValue arg = evalExpr(ast.child(node, i), frame);
+            slotStack[base + i] = std::move(arg);
+        }
+        return invoke(fn, base, parent);
+    }
+
+    QValue callBuiltin(NodeId node, uint32_t frame) {
+        Builtin which = names.builtin[node];
+        QValue path = evalExpr(ast.child(node, 0), frame);
+        if (!path.isString())
+            throw std::runtime_error(std::string(builtinInfo(which).name) + " needs a file name at line " +
+                                     std::to_string(ast.line(node)));
+        TaskScheduler& scheduler = TaskScheduler::global();
+        if (which == Builtin::ReadFile) {
+            TaskGroup reading;
+            std::string data;
+            scheduler.hold(reading);
+            AsyncIO::global().read(std::string(path.asString()), [&](std::string bytes, std::exception_ptr error) {
+                data = std::move(bytes);
+                scheduler.release(reading, error);
+            });
+            scheduler.wait(reading);
+            return NanBox::string(std::move(data));
+        }
+        std::string data = toString(evalExpr(ast.child(node, 1), frame));
+        std::unique_ptr<TaskGroup>& group = frames[frame].tasks;
+        if (!group) group = std::make_unique<TaskGroup>();
+        scheduler.hold(*group);
+        AsyncIO::global().write(std::string(path.asString()), std::move(data), false,
+                                [&scheduler, &pending = *group](std::exception_ptr error) {
+                                    scheduler.release(pending, error);
+                                });
+        return QValue();
+    }
+
+    // Runs `fn` in a new frame whose arguments are already in place at
+    // `base`, and any tail calls it makes in the same frame.
+    QValue invoke(const FunctionInfo& fn, uint32_t base, uint32_t parent) {
+        frames.push_back({base, parent, nullptr});
+        uint32_t self = static_cast<uint32_t>(frames.size() - 1);
+        execNode(fn.body, self);
+        while (tailCall != NO_NODE) {
+            join(self);
+            const FunctionInfo& next = names.function(tailCall);
+            size_t args = slotStack.size() - next.params;
+            for (uint32_t i = 0; i < next.params; ++i)
+                slotStack[base + i] = std::move(slotStack[args + i]);
+            slotStack.resize(base + next.params);  // nothing of the old frame survives
+            slotStack.resize(base + next.frameSize);
+            frames[self].parent = tailParent;
+            tailCall = NO_NODE;
+            returning = false;
+            execNode(next.body, self);
+        }
+        join(self);
+        frames.pop_back();
+        slotStack.resize(base);  // capacity stays for the next call
+        returning = false;
+        return std::move(returnValue);
+    }
+
+    // === Expression Evaluator ===
+    QValue evalExpr(NodeId node, uint32_t frame) {
+        // For demo: numbers, variables, string literals, bools
+        switch (ast.kind(node)) {
+            case NodeKind::Identifier: {
+                QValue v = load(frame, names.at(node));
+                if (v.isNone())  // read before its declaration ran
+                    throw std::runtime_error("Variable '" + std::string(SymbolInterner::global().name(ast.symbol(node))) +
+                                             "' has no value at line " + std::to_string(ast.line(node)) + ".");
+                return v;
+            }
+            case NodeKind::IntLiteral:    return NanBox::number(static_cast<double>(ast.intValue(node)));
+            case NodeKind::FloatLiteral:  return NanBox::number(ast.floatValue(node));
+            case NodeKind::StringLiteral: return shared->literals[node];
+            case NodeKind::BoolLiteral:   return NanBox::boolean(ast.boolValue(node));
+            case NodeKind::BinaryOp:      return evalBinary(node, frame);
+            case NodeKind::UnaryOp: {
+                QValue v = evalExpr(ast.child(node, 0), frame);
+                if (ast.op(node) == AstOp::Not) return NanBox::boolean(!truthy(v));
+                if (!v.isNumber()) throw std::runtime_error("Operand of '-' must be a number.");
+                return NanBox::number(-v.toDouble());
+            }
+            case NodeKind::Interpolate: {
+                // Short parts are gathered flat; a long string is joined on
+                // whole, so "{report}..." in a loop grows a rope.
+                QValue text = NanBox::string({});
+                std::string out;
+                for (NodeId part : ast.children(node)) {
+                    QValue v = evalExpr(part, frame);
+                    if (v.isString() && v.length() > NanBox::FLAT_MAX) {
+                        text = NanBox::concat(NanBox::concat(text, NanBox::string(std::move(out))), v);
+                        out.clear();
+                    } else if (v.isString()) {
+                        out += v.asString();
+                    } else {
+                        out += toString(v);
+                    }
+                }
+                return NanBox::concat(text, NanBox::string(std::move(out)));
+            }
+            case NodeKind::Call:          return call(node, frame);
+            default: break;
+        }
+        return QValue();
+    }
+
+    QValue evalBinary(NodeId node, uint32_t frame) {
+        AstOp op = ast.op(node);
+        QValue l = evalExpr(ast.child(node, 0), frame);
+        // and/or short-circuit
+        if (op == AstOp::And && !truthy(l)) return NanBox::boolean(false);
+        if (op == AstOp::Or && truthy(l)) return NanBox::boolean(true);
+        QValue r = evalExpr(ast.child(node, 1), frame);
+        if (op == AstOp::And || op == AstOp::Or) return NanBox::boolean(truthy(r));
+
+        if (l.isNumber() && r.isNumber()) {
+            double a = l.toDouble(), b = r.toDouble();
+            switch (op) {
+                case AstOp::Add: return NanBox::number(a + b);
+                case AstOp::Sub: return NanBox::number(a - b);
+                case AstOp::Mul: return NanBox::number(a * b);
+                case AstOp::Div:
+                    if (b == 0) throw std::runtime_error("Division by zero.");
+                    return NanBox::number(a / b);
+                case AstOp::Mod:
+                    if (b == 0) throw std::runtime_error("Division by zero.");
+                    return NanBox::number(std::fmod(a, b));
+                case AstOp::Lt: return NanBox::boolean(a < b);
+                case AstOp::Le: return NanBox::boolean(a <= b);
+                case AstOp::Gt: return NanBox::boolean(a > b);
+                case AstOp::Ge: return NanBox::boolean(a >= b);
+                default: break;
+            }
+        }
+        if (op == AstOp::Add && (l.isString() || r.isString()))
+            return NanBox::concat(toText(l), toText(r));
+        if (op == AstOp::Eq) return NanBox::boolean(equal(l, r));
+        if (op == AstOp::Ne) return NanBox::boolean(!equal(l, r));
+        if (l.isString() && r.isString()) {
+            switch (op) {
+                case AstOp::Lt: return NanBox::boolean(l.asString() < r.asString());
+                case AstOp::Le: return NanBox::boolean(l.asString() <= r.asString());
+                case AstOp::Gt: return NanBox::boolean(l.asString() > r.asString());
+                case AstOp::Ge: return NanBox::boolean(l.asString() >= r.asString());
+                default: break;
+            }
+        }
+        throw std::runtime_error("Invalid operands to '" + std::string(opSpelling(op)) +
+                                 "' at line " + std::to_string(ast.line(node)));
+    }
+
+    static bool truthy(const QValue& v) {
+        if (v.isNumber()) return v.toDouble() != 0;
+        if (v.isString()) return v.length() != 0;
+        if (v.isBool())   return v.asBool();
+        return false;
+    }
+    static bool equal(const QValue& l, const QValue& r) {
+        if (l.isNumber() && r.isNumber()) return l.toDouble() == r.toDouble();
+        if (l.isString() && r.isString()) return NanBox::sameString(l, r);
+        if (l.isBool() && r.isBool())     return l.asBool() == r.asBool();
+        return l.isNone() && r.isNone();
+    }
+};
+
+// === Demo: Build and Run a Simple Quarter Program ===
+NodeId demoQuarterProgram(AstArena& ast) {
+    // star
+    //   val x = 10
+    //   var y = "hello"
+    //   say y
+    // end
+
+    SymbolInterner& names = SymbolInterner::global();
+    NodeId valX = ast.named(NodeKind::Val, names.intern("x"), 2, {ast.intLiteral(10, 2)});
+    NodeId varY = ast.named(NodeKind::Var, names.intern("y"), 3, {ast.stringLiteral("hello", 3)});
+    NodeId sayY = ast.add(NodeKind::Say, 4, {ast.named(NodeKind::Identifier, names.intern("y"), 4)});
+
+    return ast.root = ast.add(NodeKind::Program, 1, {valX, varY, sayY});
+}
+
+int main() {
+    try {
+        AstArena ast;
+        NodeId prog = demoQuarterProgram(ast);
+        QuarterRuntime runtime(ast, prog);
+        runtime.run();
+    } catch (const std::exception& ex) {
         std::cerr << "[QuarterLang Runtime Error] " << ex.what() << std::endl;
         return 1;
     }
@@ -1061,23 +2492,23 @@ int main() {
 
 // quarter_runner.cpp
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
+#include "QuarterLang_SourceBuffer.h"
 
 // Forward declaration for QuarterLang Interpreter (assume available in your project)
 class QuarterInterpreter {
 public:
     // Returns exit code
-    int run(const std::string& source, const std::vector<std::string>& args);
+    int run(std::string_view source, const std::vector<std::string>& args);
 };
 
-// Utility: Read entire file into string
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::in);
-    if (!file) throw std::runtime_error("Error: Could not open file '" + filename + "'");
-    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+// Utility: Map the script (or stream it, for pipes and "-")
+SourceBuffer readFile(const std::string& filename) {
+    SourceBuffer contents;
+    if (!contents.open(filename)) throw std::runtime_error("Error: Could not open file '" + filename + "'");
     return contents;
 }
 
@@ -1100,11 +2531,11 @@ int main(int argc, char* argv[]) {
         for (int i = 2; i < argc; ++i)
             scriptArgs.emplace_back(argv[i]);
 
-        std::string source = readFile(filename);
+        SourceBuffer source = readFile(filename);
 
         // Run QuarterLang interpreter/VM
         QuarterInterpreter interpreter;
-        int exitCode = interpreter.run(source, scriptArgs);
+        int exitCode = interpreter.run(source.view(), scriptArgs);
         return exitCode;
 
     } catch (const std::exception& ex) {
@@ -1116,11 +2547,12 @@ int main(int argc, char* argv[]) {
 // quarter_interpreter.cpp
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class QuarterInterpreter {
 public:
-    int run(const std::string& source, const std::vector<std::string>& args) {
+    int run(std::string_view source, const std::vector<std::string>& args) {
         std::cout << "[QuarterLang RUNNER]\n";
         std::cout << "Received Source (" << source.size() << " chars)\n";
         std::cout << "Arguments: ";
@@ -1293,6 +2725,7 @@ private:
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include "QuarterOutput.h"
 
 class QuarterIO {
 public:
@@ -1303,11 +2736,14 @@ public:
 
     // say "some text"
     void say(const std::string& text) {
-        std::cout << text << std::endl;
+        QuarterOutput& out = QuarterOutput::local();
+        out.write(text);
+        out.endLine();
     }
 
     // ask varName "Prompt text"
     void ask(const std::string& varName, const std::string& prompt) {
+        QuarterOutput::local().flush();
         std::cout << prompt;
         std::string input;
         std::getline(std::cin, input);
@@ -1410,52 +2846,118 @@ int main() {
 // Reads a .quarter file, processes, and runs it.
 
 #include <iostream>
-#include <fstream>
 #include <string>
 
 // Include your QuarterLang headers
+#include "QuarterLang_SourceBuffer.h"
 #include "Lexer.h"
 #include "Parser.h"
-#include "AST.h"
-#include "CodeGenerator.h"
+#include "AstArena.h"
+#include "Bytecode.h"
+#include "Superinstructions.h"
 #include "VM.h"
+#include "RegisterVM.h"
+#include "Runtime.h"
+
+// --profile runs the unfused program interpreted and reports, on stderr,
+// its dispatch count, the count fusion would leave, and the hottest opcode
+// sequences (the candidates for new superinstructions).
+static void reportProfile(const BytecodeProgram& bytecode, const std::vector<uint64_t>& runs) {
+    uint64_t before = 0;
+    for (uint64_t n : runs) before += n;
+    uint64_t after = before - Superinstructions::savedDispatches(bytecode, runs);
+    std::cerr << "dispatches: " << before << " unfused, " << after << " fused";
+    if (before) std::cerr << " (" << (100.0 * (before - after) / before) << "% fewer)";
+    std::cerr << "\nhottest sequences:\n";
+    for (const Superinstructions::Sequence& seq : Superinstructions::hottest(bytecode, runs)) {
+        std::cerr << "  " << seq.runs << "  ";
+        for (OpCode op : seq.ops) std::cerr << " " << opName(op);
+        std::cerr << "\n";
+    }
+}
+
+// --vm picks the engine: the stack VM, the register VM, or the tree walker
+// (QuarterRuntime). Only the walker runs `thread`, `await`, `pipe` and the
+// file builtins (read_file, write_file, write_bytes); the VMs reject them
+// when compiling. Without --vm, the stack VM runs the program unless it
+// uses one of those, and the walker runs it if it does.
+enum class Engine { Auto, Stack, Register, Walk };
 
 int main(int argc, char* argv[]) {
+    bool jit = true, fuse = true, profile = false;
+    Engine engine = Engine::Auto;
+    for (; argc > 1 && argv[1][0] == '-' && argv[1][1] == '-'; --argc, ++argv) {
+        std::string flag = argv[1];
+        if (flag == "--no-jit") jit = false;
+        else if (flag == "--no-fuse") fuse = false;
+        else if (flag == "--profile") profile = true;
+        else if (flag == "--vm=register") engine = Engine::Register;
+        else if (flag == "--vm=stack") engine = Engine::Stack;
+        else if (flag == "--vm=walk") engine = Engine::Walk;
+        else break;
+    }
     if (argc < 2) {
-        std::cerr << "Usage: quarter <source_file.quarter>" << std::endl;
+        std::cerr << "Usage: quarter [--vm=stack|register|walk] [--no-jit] [--no-fuse] [--profile] <source_file.quarter>"
+                  << std::endl;
         return 1;
     }
 
     std::string filename = argv[1];
-    std::ifstream file(filename);
-    if (!file) {
+    // Map the source; tokens are views into it, so it must outlive the pipeline
+    SourceBuffer source;
+    if (!source.open(filename)) {
         std::cerr << "Error: Cannot open file '" << filename << "'" << std::endl;
         return 1;
     }
 
-    // Read source code into a string
-    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-
     // === PHASE 1: Lexing ===
-    Lexer lexer(source);
+    Lexer lexer(source.view());
     std::vector<Token> tokens = lexer.tokenize();
 
     // === PHASE 2: Parsing ===
-    Parser parser(tokens);
-    std::shared_ptr<ASTNode> program = parser.parse();
+    AstArena ast;
+    ErrorHandler errors;  // prints each syntax error as it is found
+    Parser parser(tokens, ast, &errors, filename);
+    NodeId program = parser.parse();
 
-    if (!program) {
-        std::cerr << "Parse Error. Exiting." << std::endl;
+    if (errors.hasErrors()) {
+        std::cerr << errors.errorCount() << " error(s). Exiting." << std::endl;
         return 1;
     }
 
-    // === PHASE 3: Code Generation ===
-    CodeGenerator codegen;
-    auto ir = codegen.generate(program);
-
-    // === PHASE 4: Execution (VM) ===
-    VM vm;
-    vm.run(ir);
+    try {
+        // === PHASE 3: Code Generation ===
+        // --no-jit, --no-fuse and --profile apply to the stack VM only.
+        if (engine == Engine::Walk) {
+            // Runs the tree as parsed, with no code generation
+            QuarterRuntime(ast, program).run();
+            return 0;
+        }
+        if (engine == Engine::Register) {
+            // Three-address form, interpreted only
+            RegisterVM().run(RegisterCompiler().compile(ast, program));
+            return 0;
+        }
+        BytecodeProgram bytecode;
+        try {
+            bytecode = BytecodeCompiler().compile(ast, program);
+        } catch (const WalkerOnlyError&) {
+            if (engine != Engine::Auto) throw;
+            QuarterRuntime(ast, program).run();
+            return 0;
+        }
+        if (fuse && !profile) Superinstructions::fuse(bytecode);
+
+        // === PHASE 4: Execution (VM; hot functions tier up to native code) ===
+        VM vm;
+        vm.setJit(jit);
+        vm.setProfile(profile);
+        vm.run(bytecode);
+        if (profile) reportProfile(bytecode, vm.dispatches());
+    } catch (const std::exception& e) {
+        std::cerr << "[QuarterLang ERROR] " << e.what() << std::endl;
+        return 1;
+    }
 
     // Success
     return 0;
@@ -1466,32 +2968,17 @@ int main(int argc, char* argv[]) {
 // ========================
 
 #pragma once
-#include <memory>
+#include <cstdint>
 #include <vector>
-#include <string>
 #include <unordered_map>
-#include <iostream>
-#include <variant>
-#include <optional>
-
-// --- AST Node Definitions (You should replace/extend these with your own) ---
-
-enum class NodeKind { Program, Block, VarDecl, Assign, BinaryOp, Literal, Identifier, If, While, Call, Return };
-
-struct ASTNode;
-using AST = std::shared_ptr<ASTNode>;
+#include <unordered_set>
+#include "AstArena.h"
 
-struct ASTNode {
-    NodeKind kind;
-    std::vector<AST> children;
-    std::string name;        // Used for variables, function names, etc.
-    std::string op;          // For binary operators ("+", "-", etc.)
-    std::variant<int, double, std::string> value; // For literals
-    // ...other fields as needed (types, etc.)
-    ASTNode(NodeKind k) : kind(k) {}
-};
+// --- AST: the shared AstArena (see AstArena.h) ---
 
-using SymbolTable = std::unordered_map<std::string, std::variant<int, double, std::string>>;
+// Constant bindings seen so far, one scope per block, innermost last:
+// name -> literal node, or NO_NODE where the name is bound but not constant.
+using SymbolTable = std::vector<std::unordered_map<SymbolId, NodeId>>;
 
 // --- Optimizer Class ---
 
@@ -1499,114 +2986,200 @@ class QuarterOptimizer {
 public:
     QuarterOptimizer() = default;
 
-    // Entrypoint: optimize whole AST in-place
-    AST optimize(const AST& root) {
-        SymbolTable globals;
-        return optimizeNode(root, globals);
+    // Entrypoint: returns the optimized root. Rewritten nodes are appended to
+    // the same arena and unchanged subtrees are shared with the input.
+    NodeId optimize(AstArena& tree, NodeId root) {
+        ast = &tree;
+        reassigned.clear();
+        for (NodeId node = 0; node < tree.size(); ++node) {
+            if (tree.kind(node) == NodeKind::FuncDef) collectBound(tree.child(node, tree.childCount(node) - 1), reassigned);
+        }
+        SymbolTable symbols(1);
+        return optimizeNode(root, symbols);
     }
 
 private:
-    // Recursively optimize nodes
-    AST optimizeNode(const AST& node, SymbolTable& symbols) {
-        switch (node->kind) {
+    AstArena* ast = nullptr;
+    // Names a function body binds: any call may change them, so they are
+    // never constants.
+    std::unordered_set<SymbolId> reassigned;
+
+    // Blocks share their frame's slots (see Resolver), so a name bound in a
+    // block that may or may not run is not constant after it, whatever it
+    // was before: leaving the block forgets it in the enclosing scope too.
+    static NodeId lookup(const SymbolTable& symbols, SymbolId name) {
+        for (auto scope = symbols.rbegin(); scope != symbols.rend(); ++scope) {
+            auto it = scope->find(name);
+            if (it != scope->end()) return it->second;
+        }
+        return NO_NODE;
+    }
+    static void exitBlock(SymbolTable& symbols) {
+        std::unordered_map<SymbolId, NodeId> inner = std::move(symbols.back());
+        symbols.pop_back();
+        for (const auto& bound : inner) symbols.back()[bound.first] = NO_NODE;
+    }
+    // Every name `node` or its descendants bind.
+    void collectBound(NodeId node, std::unordered_set<SymbolId>& names) const {
+        switch (ast->kind(node)) {
+            case NodeKind::Val:
+            case NodeKind::Var:
+            case NodeKind::Assign:
+            case NodeKind::Ask:
+            case NodeKind::Loop:
+                names.insert(ast->symbol(node));
+                break;
+            default:
+                break;
+        }
+        for (NodeId child : ast->children(node)) collectBound(child, names);
+    }
+    // A loop's condition and body run again after its body: nothing the body
+    // binds is constant in either.
+    void forgetBound(NodeId body, SymbolTable& symbols) const {
+        std::unordered_set<SymbolId> names;
+        collectBound(body, names);
+        for (SymbolId name : names) symbols.back()[name] = NO_NODE;
+    }
+
+    // Recursively optimize nodes; NO_NODE means "removed"
+    NodeId optimizeNode(NodeId node, SymbolTable& symbols) {
+        AstArena& a = *ast;
+        int line = a.line(node);
+        switch (a.kind(node)) {
             case NodeKind::Program:
             case NodeKind::Block: {
-                auto newNode = std::make_shared<ASTNode>(node->kind);
-                for (const auto& child : node->children) {
-                    auto optChild = optimizeNode(child, symbols);
-                    if (optChild) newNode->children.push_back(optChild);
+                bool block = a.kind(node) == NodeKind::Block;
+                if (block) symbols.emplace_back();
+                std::vector<NodeId> kids;
+                kids.reserve(a.childCount(node));
+                for (NodeId child : a.children(node)) {
+                    NodeId optChild = optimizeNode(child, symbols);
+                    if (optChild != NO_NODE) kids.push_back(optChild);
                 }
-                return newNode;
+                if (block) exitBlock(symbols);
+                return a.add(a.kind(node), line, kids);
             }
-            case NodeKind::VarDecl:
+            case NodeKind::Val:
+            case NodeKind::Var:
             case NodeKind::Assign: {
-                auto newNode = std::make_shared<ASTNode>(node->kind);
-                newNode->name = node->name;
-                auto rhs = optimizeNode(node->children[0], symbols);
-                newNode->children.push_back(rhs);
-                // Track assignment for constant propagation
-                if (rhs->kind == NodeKind::Literal) {
-                    symbols[newNode->name] = rhs->value;
-                }
-                return newNode;
+                NodeId rhs = optimizeNode(a.child(node, 0), symbols);
+                // Track assignment for constant propagation. Only `val` is
+                // immutable; a `var` may be reassigned later (or in a loop).
+                bool constant = a.kind(node) == NodeKind::Val && a.isLiteral(rhs) && !reassigned.count(a.symbol(node));
+                symbols.back()[a.symbol(node)] = constant ? rhs : NO_NODE;
+                return a.named(a.kind(node), a.symbol(node), line, {rhs});
             }
+            case NodeKind::Say: {
+                return a.add(NodeKind::Say, line, {optimizeNode(a.child(node, 0), symbols)});
+            }
+            case NodeKind::Ask:
+                symbols.back()[a.symbol(node)] = NO_NODE;
+                return node;
             case NodeKind::BinaryOp: {
                 // Try constant folding
-                auto left = optimizeNode(node->children[0], symbols);
-                auto right = optimizeNode(node->children[1], symbols);
-                if (left->kind == NodeKind::Literal && right->kind == NodeKind::Literal) {
-                    return foldConstants(node->op, left->value, right->value);
+                NodeId left = optimizeNode(a.child(node, 0), symbols);
+                NodeId right = optimizeNode(a.child(node, 1), symbols);
+                AstOp op = a.op(node);
+                if (a.isLiteral(left) && a.isLiteral(right)) {
+                    NodeId folded = foldConstants(op, left, right, line);
+                    if (folded != NO_NODE) return folded;
                 }
-                // x + 0 or 0 + x optimization
-                if (node->op == "+" || node->op == "-") {
-                    if (isLiteralZero(left)) return right;
-                    if (isLiteralZero(right) && node->op == "+") return left;
+                // false and x, true or x: the right side is never evaluated
+                if ((op == AstOp::And || op == AstOp::Or) && a.isLiteral(left)) {
+                    bool lv = isTrue(left);
+                    if (lv == (op == AstOp::Or)) return a.boolLiteral(lv, line);
                 }
-                // x * 1 or 1 * x, x * 0, 0 * x
-                if (node->op == "*") {
-                    if (isLiteralOne(left)) return right;
-                    if (isLiteralOne(right)) return left;
-                    if (isLiteralZero(left) || isLiteralZero(right)) return makeLiteral(0);
+                // x + 0, 0 + x, x - 0, x * 1, 1 * x, for a number x only: a
+                // string x concatenates or raises, and a call must still run.
+                // x * 0 is left alone: a float x gives 0.0, -0.0 or NaN.
+                if (op == AstOp::Add || op == AstOp::Sub) {
+                    if (isLiteralZero(left) && op == AstOp::Add && isPureNumber(right)) return right;
+                    if (isLiteralZero(right) && isPureNumber(left)) return left;
                 }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::BinaryOp);
-                newNode->op = node->op;
-                newNode->children = {left, right};
-                return newNode;
+                if (op == AstOp::Mul) {
+                    if (isLiteralOne(left) && isPureNumber(right)) return right;
+                    if (isLiteralOne(right) && isPureNumber(left)) return left;
+                }
+                return a.binary(op, left, right, line);
+            }
+            case NodeKind::UnaryOp: {
+                NodeId operand = optimizeNode(a.child(node, 0), symbols);
+                AstOp op = a.op(node);
+                if (op == AstOp::Not && a.isLiteral(operand)) return a.boolLiteral(!isTrue(operand), line);
+                if (op == AstOp::Neg && a.kind(operand) == NodeKind::IntLiteral && a.intValue(operand) != INT64_MIN)
+                    return a.intLiteral(-a.intValue(operand), line);
+                if (op == AstOp::Neg && a.kind(operand) == NodeKind::FloatLiteral)
+                    return a.floatLiteral(-a.floatValue(operand), line);
+                return a.unary(op, operand, line);
             }
-            case NodeKind::Literal: {
+            case NodeKind::Interpolate: {
+                std::vector<NodeId> parts;
+                parts.reserve(a.childCount(node));
+                for (NodeId part : a.children(node))
+                    parts.push_back(optimizeNode(part, symbols));
+                return a.add(NodeKind::Interpolate, line, parts);
+            }
+            case NodeKind::IntLiteral:
+            case NodeKind::FloatLiteral:
+            case NodeKind::StringLiteral:
+            case NodeKind::BoolLiteral: {
                 return node;
             }
             case NodeKind::Identifier: {
                 // Constant propagation
-                auto it = symbols.find(node->name);
-                if (it != symbols.end()) {
-                    return makeLiteral(it->second);
-                }
-                return node;
+                NodeId value = lookup(symbols, a.symbol(node));
+                return value != NO_NODE ? value : node;
             }
             case NodeKind::If: {
-                auto cond = optimizeNode(node->children[0], symbols);
+                NodeId cond = optimizeNode(a.child(node, 0), symbols);
                 // Dead code elimination for constant condition
-                if (cond->kind == NodeKind::Literal) {
-                    if (isTrue(cond->value)) {
-                        return optimizeNode(node->children[1], symbols); // Then branch
-                    } else if (node->children.size() > 2) {
-                        return optimizeNode(node->children[2], symbols); // Else branch
+                if (a.isLiteral(cond)) {
+                    if (isTrue(cond)) {
+                        return optimizeNode(a.child(node, 1), symbols); // Then branch
+                    } else if (a.childCount(node) > 2) {
+                        return optimizeNode(a.child(node, 2), symbols); // Else branch
                     } else {
-                        return nullptr;
+                        return NO_NODE;
                     }
                 }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::If);
-                newNode->children.push_back(cond);
-                for (size_t i = 1; i < node->children.size(); ++i) {
-                    auto optBranch = optimizeNode(node->children[i], symbols);
-                    if (optBranch) newNode->children.push_back(optBranch);
+                std::vector<NodeId> kids{cond};
+                for (size_t i = 1; i < a.childCount(node); ++i) {
+                    NodeId optBranch = optimizeNode(a.child(node, i), symbols);
+                    if (optBranch != NO_NODE) kids.push_back(optBranch);
                 }
-                return newNode;
+                return a.add(NodeKind::If, line, kids);
             }
             case NodeKind::While: {
-                auto cond = optimizeNode(node->children[0], symbols);
-                if (cond->kind == NodeKind::Literal && !isTrue(cond->value)) {
+                forgetBound(a.child(node, 1), symbols);
+                NodeId cond = optimizeNode(a.child(node, 0), symbols);
+                if (a.isLiteral(cond) && !isTrue(cond)) {
                     // while (false): Remove entire loop
-                    return nullptr;
+                    return NO_NODE;
                 }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::While);
-                newNode->children.push_back(cond);
-                auto body = optimizeNode(node->children[1], symbols);
-                if (body) newNode->children.push_back(body);
-                return newNode;
+                NodeId body = optimizeNode(a.child(node, 1), symbols);
+                if (body == NO_NODE) body = a.add(NodeKind::Block, line);
+                return a.add(NodeKind::While, line, {cond, body});
+            }
+            case NodeKind::Loop: {
+                NodeId from = optimizeNode(a.child(node, 0), symbols);
+                NodeId to = optimizeNode(a.child(node, 1), symbols);
+                symbols.back()[a.symbol(node)] = NO_NODE;  // the counter changes every pass
+                forgetBound(a.child(node, 2), symbols);
+                NodeId body = optimizeNode(a.child(node, 2), symbols);
+                if (body == NO_NODE) body = a.add(NodeKind::Block, line);
+                return a.named(NodeKind::Loop, a.symbol(node), line, {from, to, body});
             }
             case NodeKind::Call: {
-                auto newNode = std::make_shared<ASTNode>(NodeKind::Call);
-                newNode->name = node->name;
-                for (const auto& arg : node->children)
-                    newNode->children.push_back(optimizeNode(arg, symbols));
-                return newNode;
+                std::vector<NodeId> args;
+                args.reserve(a.childCount(node));
+                for (NodeId arg : a.children(node))
+                    args.push_back(optimizeNode(arg, symbols));
+                return a.named(NodeKind::Call, a.symbol(node), line, args);
             }
             case NodeKind::Return: {
-                auto newNode = std::make_shared<ASTNode>(NodeKind::Return);
-                newNode->children.push_back(optimizeNode(node->children[0], symbols));
-                return newNode;
+                if (a.childCount(node) == 0) return node;
+                return a.add(NodeKind::Return, line, {optimizeNode(a.child(node, 0), symbols)});
             }
             default:
                 return node;
@@ -1614,57 +3187,100 @@ private:
     }
 
     // --- Optimization helpers ---
-    AST foldConstants(const std::string& op, const std::variant<int, double, std::string>& l, const std::variant<int, double, std::string>& r) {
-        // Only int/double folding (string folding can be implemented similarly)
-        if (l.index() == 0 && r.index() == 0) { // int
-            int lv = std::get<int>(l), rv = std::get<int>(r);
-            if (op == "+") return makeLiteral(lv + rv);
-            if (op == "-") return makeLiteral(lv - rv);
-            if (op == "*") return makeLiteral(lv * rv);
-            if (op == "/") return makeLiteral(rv != 0 ? lv / rv : 0); // div by 0 is UB
-        }
-        if (l.index() == 1 && r.index() == 1) { // double
-            double lv = std::get<double>(l), rv = std::get<double>(r);
-            if (op == "+") return makeLiteral(lv + rv);
-            if (op == "-") return makeLiteral(lv - rv);
-            if (op == "*") return makeLiteral(lv * rv);
-            if (op == "/") return makeLiteral(rv != 0 ? lv / rv : 0.0);
-        }
-        // ...add more folding as needed
-        return nullptr;
+    NodeId foldConstants(AstOp op, NodeId l, NodeId r, int line) {
+        AstArena& a = *ast;
+        if (op == AstOp::And) return a.boolLiteral(isTrue(l) && isTrue(r), line);
+        if (op == AstOp::Or) return a.boolLiteral(isTrue(l) || isTrue(r), line);
+        // Only int/double folding (string folding can be implemented similarly).
+        // A folded program must do what the unfolded one does, so anything the
+        // runtime would reject or that overflows int64 is left to the runtime.
+        if (a.kind(l) == NodeKind::IntLiteral && a.kind(r) == NodeKind::IntLiteral) {
+            int64_t lv = a.intValue(l), rv = a.intValue(r), result;
+            switch (op) {
+                case AstOp::Add: return __builtin_add_overflow(lv, rv, &result) ? NO_NODE : a.intLiteral(result, line);
+                case AstOp::Sub: return __builtin_sub_overflow(lv, rv, &result) ? NO_NODE : a.intLiteral(result, line);
+                case AstOp::Mul: return __builtin_mul_overflow(lv, rv, &result) ? NO_NODE : a.intLiteral(result, line);
+                case AstOp::Div: return rv != 0 ? a.floatLiteral(double(lv) / double(rv), line) : NO_NODE;
+                case AstOp::Mod: return rv != 0 && rv != -1 ? a.intLiteral(lv % rv, line) : NO_NODE;
+                default: return foldCompare(op, lv, rv, line);
+            }
+        }
+        if (isNumber(l) && isNumber(r)) {
+            // Mixed int/float promotes to float
+            double lv = numberValue(l), rv = numberValue(r);
+            switch (op) {
+                case AstOp::Add: return a.floatLiteral(lv + rv, line);
+                case AstOp::Sub: return a.floatLiteral(lv - rv, line);
+                case AstOp::Mul: return a.floatLiteral(lv * rv, line);
+                case AstOp::Div: return rv != 0 ? a.floatLiteral(lv / rv, line) : NO_NODE;
+                case AstOp::Mod: return NO_NODE;
+                default: return foldCompare(op, lv, rv, line);
+            }
+        }
+        if (a.kind(l) == NodeKind::StringLiteral && a.kind(r) == NodeKind::StringLiteral)
+            return foldCompare(op, a.text(l), a.text(r), line);
+        if (a.kind(l) == NodeKind::BoolLiteral && a.kind(r) == NodeKind::BoolLiteral &&
+            (op == AstOp::Eq || op == AstOp::Ne))
+            return foldCompare(op, a.boolValue(l), a.boolValue(r), line);
+        return NO_NODE;
     }
-    static bool isLiteralZero(const AST& n) {
-        if (n->kind != NodeKind::Literal) return false;
-        if (n->value.index() == 0) return std::get<int>(n->value) == 0;
-        if (n->value.index() == 1) return std::get<double>(n->value) == 0.0;
-        return false;
+    template <typename T>
+    NodeId foldCompare(AstOp op, const T& lv, const T& rv, int line) {
+        switch (op) {
+            case AstOp::Eq: return ast->boolLiteral(lv == rv, line);
+            case AstOp::Ne: return ast->boolLiteral(lv != rv, line);
+            case AstOp::Lt: return ast->boolLiteral(lv < rv, line);
+            case AstOp::Le: return ast->boolLiteral(lv <= rv, line);
+            case AstOp::Gt: return ast->boolLiteral(lv > rv, line);
+            case AstOp::Ge: return ast->boolLiteral(lv >= rv, line);
+            default: return NO_NODE;
+        }
     }
-    static bool isLiteralOne(const AST& n) {
-        if (n->kind != NodeKind::Literal) return false;
-        if (n->value.index() == 0) return std::get<int>(n->value) == 1;
-        if (n->value.index() == 1) return std::get<double>(n->value) == 1.0;
-        return false;
+    bool isNumber(NodeId n) const {
+        return ast->kind(n) == NodeKind::IntLiteral || ast->kind(n) == NodeKind::FloatLiteral;
+    }
+    double numberValue(NodeId n) const {
+        if (ast->kind(n) == NodeKind::IntLiteral) return static_cast<double>(ast->intValue(n));
+        return ast->floatValue(n);
+    }
+    // A number, and evaluating it has no effect and cannot raise. Names may
+    // hold any type, and / and % raise on a zero divisor.
+    bool isPureNumber(NodeId n) const {
+        switch (ast->kind(n)) {
+            case NodeKind::IntLiteral:
+            case NodeKind::FloatLiteral: return true;
+            case NodeKind::UnaryOp:      return ast->op(n) == AstOp::Neg && isPureNumber(ast->child(n, 0));
+            case NodeKind::BinaryOp: {
+                AstOp op = ast->op(n);
+                return (op == AstOp::Add || op == AstOp::Sub || op == AstOp::Mul) &&
+                       isPureNumber(ast->child(n, 0)) && isPureNumber(ast->child(n, 1));
+            }
+            default: return false;
+        }
     }
-    static bool isTrue(const std::variant<int, double, std::string>& v) {
-        if (v.index() == 0) return std::get<int>(v) != 0;
-        if (v.index() == 1) return std::get<double>(v) != 0.0;
-        if (v.index() == 2) return !std::get<std::string>(v).empty();
+    bool isLiteralZero(NodeId n) const {
+        if (ast->kind(n) == NodeKind::IntLiteral) return ast->intValue(n) == 0;
+        if (ast->kind(n) == NodeKind::FloatLiteral) return ast->floatValue(n) == 0.0;
         return false;
     }
-    static AST makeLiteral(const std::variant<int, double, std::string>& v) {
-        auto n = std::make_shared<ASTNode>(NodeKind::Literal);
-        n->value = v;
-        return n;
+    bool isLiteralOne(NodeId n) const {
+        if (ast->kind(n) == NodeKind::IntLiteral) return ast->intValue(n) == 1;
+        if (ast->kind(n) == NodeKind::FloatLiteral) return ast->floatValue(n) == 1.0;
+        return false;
     }
-    static AST makeLiteral(int v) {
-        auto n = std::make_shared<ASTNode>(NodeKind::Literal);
-        n->value = v;
-        return n;
+    bool isTrue(NodeId n) const {
+        switch (ast->kind(n)) {
+            case NodeKind::IntLiteral:    return ast->intValue(n) != 0;
+            case NodeKind::FloatLiteral:  return ast->floatValue(n) != 0.0;
+            case NodeKind::StringLiteral: return !ast->text(n).empty();
+            case NodeKind::BoolLiteral:   return ast->boolValue(n);
+            default: return false;
+        }
     }
 };
 
 // --- Usage ---
-// auto optimizedRoot = QuarterOptimizer().optimize(parsedAST);
+// NodeId optimizedRoot = QuarterOptimizer().optimize(arena, arena.root);
 
 // TLCM.hpp
 #pragma once
@@ -1790,251 +3406,46 @@ tlcm.linkAndPatch();
 // Print symbol table for diagnostics
 tlcm.printSymbols();
 
-// ========================
-// QuarterLang Optimizer.hpp
-// ========================
+enum class QOp {
+    Q_MOV,      // mov reg, value
+    Q_ADD,      // add reg, value
+    Q_SAY,      // print reg or string
+    Q_EXIT,     // exit program
+    // ...expand as needed
+};
+struct QInstr {
+    QOp op;
+    int reg;
+    int value;
+    std::string str;
+};
 
-#pragma once
-#include <memory>
+#include <fstream>
 #include <vector>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
-#include <iostream>
-#include <variant>
-#include <optional>
-
-// --- AST Node Definitions (You should replace/extend these with your own) ---
-
-enum class NodeKind { Program, Block, VarDecl, Assign, BinaryOp, Literal, Identifier, If, While, Call, Return };
-
-struct ASTNode;
-using AST = std::shared_ptr<ASTNode>;
+#include <cstring>
 
-struct ASTNode {
-    NodeKind kind;
-    std::vector<AST> children;
-    std::string name;        // Used for variables, function names, etc.
-    std::string op;          // For binary operators ("+", "-", etc.)
-    std::variant<int, double, std::string> value; // For literals
-    // ...other fields as needed (types, etc.)
-    ASTNode(NodeKind k) : kind(k) {}
+// Minimal IR definition (expand as needed)
+enum class QOp { Q_SAY, Q_EXIT };
+struct QInstr {
+    QOp op;
+    std::string str; // Only needed for Q_SAY
 };
 
-using SymbolTable = std::unordered_map<std::string, std::variant<int, double, std::string>>;
-
-// --- Optimizer Class ---
+// Util: Write raw bytes to buffer/file
+void write_bytes(std::vector<uint8_t>& buf, const void* src, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(src);
+    buf.insert(buf.end(), b, b + n);
+}
 
-class QuarterOptimizer {
-public:
-    QuarterOptimizer() = default;
+// Emit minimal 64-bit Windows PE executable with a hardcoded string
+void emit_win64_pe(const std::vector<QInstr>& program, const std::string& outfile) {
+    std::vector<uint8_t> bin;
 
-    // Entrypoint: optimize whole AST in-place
-    AST optimize(const AST& root) {
-        SymbolTable globals;
-        return optimizeNode(root, globals);
-    }
-
-private:
-    // Recursively optimize nodes
-    AST optimizeNode(const AST& node, SymbolTable& symbols) {
-        switch (node->kind) {
-            case NodeKind::Program:
-            case NodeKind::Block: {
-                auto newNode = std::make_shared<ASTNode>(node->kind);
-                for (const auto& child : node->children) {
-                    auto optChild = optimizeNode(child, symbols);
-                    if (optChild) newNode->children.push_back(optChild);
-                }
-                return newNode;
-            }
-            case NodeKind::VarDecl:
-            case NodeKind::Assign: {
-                auto newNode = std::make_shared<ASTNode>(node->kind);
-                newNode->name = node->name;
-                auto rhs = optimizeNode(node->children[0], symbols);
-                newNode->children.push_back(rhs);
-                // Track assignment for constant propagation
-                if (rhs->kind == NodeKind::Literal) {
-                    symbols[newNode->name] = rhs->value;
-                }
-                return newNode;
-            }
-            case NodeKind::BinaryOp: {
-                // Try constant folding
-                auto left = optimizeNode(node->children[0], symbols);
-                auto right = optimizeNode(node->children[1], symbols);
-                if (left->kind == NodeKind::Literal && right->kind == NodeKind::Literal) {
-                    return foldConstants(node->op, left->value, right->value);
-                }
-                // x + 0 or 0 + x optimization
-                if (node->op == "+" || node->op == "-") {
-                    if (isLiteralZero(left)) return right;
-                    if (isLiteralZero(right) && node->op == "+") return left;
-                }
-                // x * 1 or 1 * x, x * 0, 0 * x
-                if (node->op == "*") {
-                    if (isLiteralOne(left)) return right;
-                    if (isLiteralOne(right)) return left;
-                    if (isLiteralZero(left) || isLiteralZero(right)) return makeLiteral(0);
-                }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::BinaryOp);
-                newNode->op = node->op;
-                newNode->children = {left, right};
-                return newNode;
-            }
-            case NodeKind::Literal: {
-                return node;
-            }
-            case NodeKind::Identifier: {
-                // Constant propagation
-                auto it = symbols.find(node->name);
-                if (it != symbols.end()) {
-                    return makeLiteral(it->second);
-                }
-                return node;
-            }
-            case NodeKind::If: {
-                auto cond = optimizeNode(node->children[0], symbols);
-                // Dead code elimination for constant condition
-                if (cond->kind == NodeKind::Literal) {
-                    if (isTrue(cond->value)) {
-                        return optimizeNode(node->children[1], symbols); // Then branch
-                    } else if (node->children.size() > 2) {
-                        return optimizeNode(node->children[2], symbols); // Else branch
-                    } else {
-                        return nullptr;
-                    }
-                }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::If);
-                newNode->children.push_back(cond);
-                for (size_t i = 1; i < node->children.size(); ++i) {
-                    auto optBranch = optimizeNode(node->children[i], symbols);
-                    if (optBranch) newNode->children.push_back(optBranch);
-                }
-                return newNode;
-            }
-            case NodeKind::While: {
-                auto cond = optimizeNode(node->children[0], symbols);
-                if (cond->kind == NodeKind::Literal && !isTrue(cond->value)) {
-                    // while (false): Remove entire loop
-                    return nullptr;
-                }
-                auto newNode = std::make_shared<ASTNode>(NodeKind::While);
-                newNode->children.push_back(cond);
-                auto body = optimizeNode(node->children[1], symbols);
-                if (body) newNode->children.push_back(body);
-                return newNode;
-            }
-            case NodeKind::Call: {
-                auto newNode = std::make_shared<ASTNode>(NodeKind::Call);
-                newNode->name = node->name;
-                for (const auto& arg : node->children)
-                    newNode->children.push_back(optimizeNode(arg, symbols));
-                return newNode;
-            }
-            case NodeKind::Return: {
-                auto newNode = std::make_shared<ASTNode>(NodeKind::Return);
-                newNode->children.push_back(optimizeNode(node->children[0], symbols));
-                return newNode;
-            }
-            default:
-                return node;
-        }
-    }
-
-    // --- Optimization helpers ---
-    AST foldConstants(const std::string& op, const std::variant<int, double, std::string>& l, const std::variant<int, double, std::string>& r) {
-        // Only int/double folding (string folding can be implemented similarly)
-        if (l.index() == 0 && r.index() == 0) { // int
-            int lv = std::get<int>(l), rv = std::get<int>(r);
-            if (op == "+") return makeLiteral(lv + rv);
-            if (op == "-") return makeLiteral(lv - rv);
-            if (op == "*") return makeLiteral(lv * rv);
-            if (op == "/") return makeLiteral(rv != 0 ? lv / rv : 0); // div by 0 is UB
-        }
-        if (l.index() == 1 && r.index() == 1) { // double
-            double lv = std::get<double>(l), rv = std::get<double>(r);
-            if (op == "+") return makeLiteral(lv + rv);
-            if (op == "-") return makeLiteral(lv - rv);
-            if (op == "*") return makeLiteral(lv * rv);
-            if (op == "/") return makeLiteral(rv != 0 ? lv / rv : 0.0);
-        }
-        // ...add more folding as needed
-        return nullptr;
-    }
-    static bool isLiteralZero(const AST& n) {
-        if (n->kind != NodeKind::Literal) return false;
-        if (n->value.index() == 0) return std::get<int>(n->value) == 0;
-        if (n->value.index() == 1) return std::get<double>(n->value) == 0.0;
-        return false;
-    }
-    static bool isLiteralOne(const AST& n) {
-        if (n->kind != NodeKind::Literal) return false;
-        if (n->value.index() == 0) return std::get<int>(n->value) == 1;
-        if (n->value.index() == 1) return std::get<double>(n->value) == 1.0;
-        return false;
-    }
-    static bool isTrue(const std::variant<int, double, std::string>& v) {
-        if (v.index() == 0) return std::get<int>(v) != 0;
-        if (v.index() == 1) return std::get<double>(v) != 0.0;
-        if (v.index() == 2) return !std::get<std::string>(v).empty();
-        return false;
-    }
-    static AST makeLiteral(const std::variant<int, double, std::string>& v) {
-        auto n = std::make_shared<ASTNode>(NodeKind::Literal);
-        n->value = v;
-        return n;
-    }
-    static AST makeLiteral(int v) {
-        auto n = std::make_shared<ASTNode>(NodeKind::Literal);
-        n->value = v;
-        return n;
-    }
-};
-
-// --- Usage ---
-// auto optimizedRoot = QuarterOptimizer().optimize(parsedAST);
-
-enum class QOp {
-    Q_MOV,      // mov reg, value
-    Q_ADD,      // add reg, value
-    Q_SAY,      // print reg or string
-    Q_EXIT,     // exit program
-    // ...expand as needed
-};
-struct QInstr {
-    QOp op;
-    int reg;
-    int value;
-    std::string str;
-};
-
-#include <fstream>
-#include <vector>
-#include <cstdint>
-#include <string>
-#include <cstring>
-
-// Minimal IR definition (expand as needed)
-enum class QOp { Q_SAY, Q_EXIT };
-struct QInstr {
-    QOp op;
-    std::string str; // Only needed for Q_SAY
-};
-
-// Util: Write raw bytes to buffer/file
-void write_bytes(std::vector<uint8_t>& buf, const void* src, size_t n) {
-    const uint8_t* b = static_cast<const uint8_t*>(src);
-    buf.insert(buf.end(), b, b + n);
-}
-
-// Emit minimal 64-bit Windows PE executable with a hardcoded string
-void emit_win64_pe(const std::vector<QInstr>& program, const std::string& outfile) {
-    std::vector<uint8_t> bin;
-
-    // --- Minimal PE Header + .text section ---
-    // This is a "naked" PE with just enough for Hello World.
-    // For clarity, we use a fixed shell and patch the message in.
+    // --- Minimal PE Header + .text section ---
+    // This is a "naked" PE with just enough for Hello World.
+    // For clarity, we use a fixed shell and patch the message in.
 
     // (PE shell is public domain: https://github.com/corkami/pocs/blob/master/PE/minshell.asm)
     const uint8_t pe_template[] = {
@@ -2080,58 +3491,10 @@ int main() {
     return 0;
 }
 
-// AST Node Definitions (minimal for demo)
+// QuarterCodeGen: emits C++ from the shared AstArena (see AstArena.h)
 #include <string>
 #include <vector>
-#include <memory>
-
-enum class NodeKind { PROGRAM, VAR_DECL, ASSIGN, NUMBER, IDENT, BIN_OP, SAY, BLOCK };
-
-struct ASTNode {
-    NodeKind kind;
-    virtual ~ASTNode() = default;
-};
-
-using ASTPtr = std::shared_ptr<ASTNode>;
-
-struct NumberNode : ASTNode {
-    int value;
-    NumberNode(int v) : value(v) { kind = NodeKind::NUMBER; }
-};
-
-struct IdentNode : ASTNode {
-    std::string name;
-    IdentNode(const std::string& n) : name(n) { kind = NodeKind::IDENT; }
-};
-
-struct BinOpNode : ASTNode {
-    std::string op;
-    ASTPtr left, right;
-    BinOpNode(const std::string& o, ASTPtr l, ASTPtr r)
-        : op(o), left(l), right(r) { kind = NodeKind::BIN_OP; }
-};
-
-struct VarDeclNode : ASTNode {
-    std::string name;
-    ASTPtr value;
-    VarDeclNode(const std::string& n, ASTPtr v) : name(n), value(v) { kind = NodeKind::VAR_DECL; }
-};
-
-struct AssignNode : ASTNode {
-    std::string name;
-    ASTPtr value;
-    AssignNode(const std::string& n, ASTPtr v) : name(n), value(v) { kind = NodeKind::ASSIGN; }
-};
-
-struct SayNode : ASTNode {
-    ASTPtr expr;
-    SayNode(ASTPtr e) : expr(e) { kind = NodeKind::SAY; }
-};
-
-struct BlockNode : ASTNode {
-    std::vector<ASTPtr> stmts;
-    BlockNode(const std::vector<ASTPtr>& s) : stmts(s) { kind = NodeKind::BLOCK; }
-};
+#include "AstArena.h"
 
 #include <iostream>
 #include <sstream>
@@ -2140,58 +3503,87 @@ class QuarterCodeGen {
 public:
     QuarterCodeGen() {}
 
-    std::string generate(const ASTPtr& node) {
+    std::string generate(const AstArena& tree, NodeId node) {
         std::ostringstream out;
+        ast = &tree;
         emit(node, out, 0);
         return out.str();
     }
 
 private:
-    void emit(const ASTPtr& node, std::ostringstream& out, int indent) {
-        if (!node) return;
-        switch (node->kind) {
-        case NodeKind::BLOCK:
-            for (const auto& stmt : static_cast<BlockNode*>(node.get())->stmts) {
+    const AstArena* ast = nullptr;
+
+    static std::string_view name(SymbolId id) { return SymbolInterner::global().name(id); }
+
+    void emit(NodeId node, std::ostringstream& out, int indent) {
+        if (node == NO_NODE) return;
+        const AstArena& a = *ast;
+        switch (a.kind(node)) {
+        case NodeKind::Program:
+        case NodeKind::Block:
+            for (NodeId stmt : a.children(node)) {
                 emit(stmt, out, indent);
             }
             break;
-        case NodeKind::VAR_DECL: {
-            auto* n = static_cast<VarDeclNode*>(node.get());
-            out << std::string(indent, ' ') << "int " << n->name << " = ";
-            emit(n->value, out, 0);
+        case NodeKind::Val:
+        case NodeKind::Var: {
+            out << std::string(indent, ' ') << "int " << name(a.symbol(node)) << " = ";
+            emit(a.child(node, 0), out, 0);
             out << ";\n";
             break;
         }
-        case NodeKind::ASSIGN: {
-            auto* n = static_cast<AssignNode*>(node.get());
-            out << std::string(indent, ' ') << n->name << " = ";
-            emit(n->value, out, 0);
+        case NodeKind::Assign: {
+            out << std::string(indent, ' ') << name(a.symbol(node)) << " = ";
+            emit(a.child(node, 0), out, 0);
             out << ";\n";
             break;
         }
-        case NodeKind::NUMBER: {
-            auto* n = static_cast<NumberNode*>(node.get());
-            out << n->value;
+        case NodeKind::IntLiteral: {
+            out << a.intValue(node);
             break;
         }
-        case NodeKind::IDENT: {
-            auto* n = static_cast<IdentNode*>(node.get());
-            out << n->name;
+        case NodeKind::Identifier: {
+            out << name(a.symbol(node));
             break;
         }
-        case NodeKind::BIN_OP: {
-            auto* n = static_cast<BinOpNode*>(node.get());
+        case NodeKind::BinaryOp: {
             out << "(";
-            emit(n->left, out, 0);
-            out << " " << n->op << " ";
-            emit(n->right, out, 0);
+            emit(a.child(node, 0), out, 0);
+            out << " " << opSpelling(a.op(node)) << " ";
+            emit(a.child(node, 1), out, 0);
             out << ")";
             break;
         }
-        case NodeKind::SAY: {
-            auto* n = static_cast<SayNode*>(node.get());
+        case NodeKind::UnaryOp: {
+            out << "(" << opSpelling(a.op(node)) << (a.op(node) == AstOp::Not ? " " : "");
+            emit(a.child(node, 0), out, 0);
+            out << ")";
+            break;
+        }
+        case NodeKind::FloatLiteral: {
+            out << a.floatValue(node);
+            break;
+        }
+        case NodeKind::StringLiteral: {
+            out << '"' << a.text(node) << '"';
+            break;
+        }
+        case NodeKind::BoolLiteral: {
+            out << (a.boolValue(node) ? "true" : "false");
+            break;
+        }
+        case NodeKind::Call: {
+            out << name(a.symbol(node)) << "(";
+            for (size_t i = 0; i < a.childCount(node); ++i) {
+                if (i) out << ", ";
+                emit(a.child(node, i), out, 0);
+            }
+            out << ")";
+            break;
+        }
+        case NodeKind::Say: {
             out << std::string(indent, ' ') << "std::cout << ";
-            emit(n->expr, out, 0);
+            emit(a.child(node, 0), out, 0);
             out << " << std::endl;\n";
             break;
         }
@@ -2209,17 +3601,19 @@ int main() {
     //   say x
     // end
 
-    ASTPtr program = std::make_shared<BlockNode>(std::vector<ASTPtr>{
-        std::make_shared<VarDeclNode>("x", std::make_shared<NumberNode>(5)),
-        std::make_shared<AssignNode>("x", std::make_shared<BinOpNode>("+",
-            std::make_shared<IdentNode>("x"),
-            std::make_shared<NumberNode>(2)
-        )),
-        std::make_shared<SayNode>(std::make_shared<IdentNode>("x"))
+    AstArena ast;
+    SymbolId x = SymbolInterner::global().intern("x");
+    NodeId program = ast.add(NodeKind::Block, 1, {
+        ast.named(NodeKind::Val, x, 2, {ast.intLiteral(5, 2)}),
+        ast.named(NodeKind::Assign, x, 3, {ast.binary(AstOp::Add,
+            ast.named(NodeKind::Identifier, x, 3),
+            ast.intLiteral(2, 3), 3
+        )}),
+        ast.add(NodeKind::Say, 4, {ast.named(NodeKind::Identifier, x, 4)})
     });
 
     QuarterCodeGen codegen;
-    std::string output = codegen.generate(program);
+    std::string output = codegen.generate(ast, program);
 
     std::cout << "// QuarterLang Generated C++\n";
     std::cout << "#include <iostream>\n\nint main() {\n";
@@ -2232,7 +3626,15 @@ int main() {
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 #include <variant>
+#include "AstArena.h"
 
 // === Define OpCodes === //
 enum class OpCode : uint8_t {
@@ -2247,44 +3649,2755 @@ enum class OpCode : uint8_t {
     DIV        = 0x08,
     JUMP       = 0x09,
     JUMP_IF_FALSE = 0x0A,
+    MOD        = 0x0B,
+    EQ         = 0x0C,
+    NE         = 0x0D,
+    LT         = 0x0E,
+    LE         = 0x0F,
+    GT         = 0x10,
+    GE         = 0x11,
+    NEG        = 0x12,
+    NOT        = 0x13,
+    POP        = 0x14,
+    LOAD_LOCAL = 0x15,
+    SET_LOCAL  = 0x16,
+    CALL       = 0x17,
+    RETURN     = 0x18,
+    RETURN_NONE = 0x19,
+    // Superinstructions: only Superinstructions::fuse emits these.
+    INC_VAR    = 0x1A,  // slot, constant: variable += constant
+    INC_LOCAL  = 0x1B,  // slot, constant: local += constant
+    EQ_JUMP_IF_FALSE = 0x1C,  // compare the top two, jump unless it holds;
+    NE_JUMP_IF_FALSE = 0x1D,  // same order as EQ..GE
+    LT_JUMP_IF_FALSE = 0x1E,
+    LE_JUMP_IF_FALSE = 0x1F,
+    GT_JUMP_IF_FALSE = 0x20,
+    GE_JUMP_IF_FALSE = 0x21,
+    TAIL_CALL  = 0x22,  // function: CALL then RETURN, in the returning frame
     END        = 0xFF
 };
 
-// === Bytecode Value Type (int, double, string) === //
-using QValue = std::variant<int, double, std::string>;
+// === Bytecode Value Type (int, double, string, bool) === //
+using BytecodeValue = std::variant<int64_t, double, std::string, bool>;
+
+inline const char* opName(OpCode op) {
+    switch (op) {
+        case OpCode::NOP:           return "NOP";
+        case OpCode::LOAD_CONST:    return "LOAD_CONST";
+        case OpCode::LOAD_VAR:      return "LOAD_VAR";
+        case OpCode::SET_VAR:       return "SET_VAR";
+        case OpCode::SAY:           return "SAY";
+        case OpCode::ADD:           return "ADD";
+        case OpCode::SUB:           return "SUB";
+        case OpCode::MUL:           return "MUL";
+        case OpCode::DIV:           return "DIV";
+        case OpCode::JUMP:          return "JUMP";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::MOD:           return "MOD";
+        case OpCode::EQ:            return "EQ";
+        case OpCode::NE:            return "NE";
+        case OpCode::LT:            return "LT";
+        case OpCode::LE:            return "LE";
+        case OpCode::GT:            return "GT";
+        case OpCode::GE:            return "GE";
+        case OpCode::NEG:           return "NEG";
+        case OpCode::NOT:           return "NOT";
+        case OpCode::POP:           return "POP";
+        case OpCode::LOAD_LOCAL:    return "LOAD_LOCAL";
+        case OpCode::SET_LOCAL:     return "SET_LOCAL";
+        case OpCode::CALL:          return "CALL";
+        case OpCode::RETURN:        return "RETURN";
+        case OpCode::RETURN_NONE:   return "RETURN_NONE";
+        case OpCode::INC_VAR:       return "INC_VAR";
+        case OpCode::INC_LOCAL:     return "INC_LOCAL";
+        case OpCode::EQ_JUMP_IF_FALSE: return "EQ_JUMP_IF_FALSE";
+        case OpCode::NE_JUMP_IF_FALSE: return "NE_JUMP_IF_FALSE";
+        case OpCode::LT_JUMP_IF_FALSE: return "LT_JUMP_IF_FALSE";
+        case OpCode::LE_JUMP_IF_FALSE: return "LE_JUMP_IF_FALSE";
+        case OpCode::GT_JUMP_IF_FALSE: return "GT_JUMP_IF_FALSE";
+        case OpCode::GE_JUMP_IF_FALSE: return "GE_JUMP_IF_FALSE";
+        case OpCode::TAIL_CALL:     return "TAIL_CALL";
+        case OpCode::END:           return "END";
+    }
+    return nullptr;
+}
+
+// How many 32-bit operands follow the opcode: a constant index, a variable
+// or local slot, a function index or a jump target (byte offset into the
+// code stream). Only INC_VAR and INC_LOCAL take two, a slot then a constant.
+inline int operandCount(OpCode op) {
+    switch (op) {
+        case OpCode::LOAD_CONST:
+        case OpCode::LOAD_VAR:
+        case OpCode::SET_VAR:
+        case OpCode::LOAD_LOCAL:
+        case OpCode::SET_LOCAL:
+        case OpCode::CALL:
+        case OpCode::TAIL_CALL:
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::EQ_JUMP_IF_FALSE:
+        case OpCode::NE_JUMP_IF_FALSE:
+        case OpCode::LT_JUMP_IF_FALSE:
+        case OpCode::LE_JUMP_IF_FALSE:
+        case OpCode::GT_JUMP_IF_FALSE:
+        case OpCode::GE_JUMP_IF_FALSE:
+            return 1;
+        case OpCode::INC_VAR:
+        case OpCode::INC_LOCAL:
+            return 2;
+        default:
+            return 0;
+    }
+}
+inline bool hasOperand(OpCode op) { return operandCount(op) != 0; }
+
+// Opcodes whose (first) operand is a jump target.
+inline bool isJump(OpCode op) {
+    return op == OpCode::JUMP || op == OpCode::JUMP_IF_FALSE ||
+           (op >= OpCode::EQ_JUMP_IF_FALSE && op <= OpCode::GE_JUMP_IF_FALSE);
+}
+
+// === Quarter Bytecode Program === //
+// `code` is one packed stream: an opcode byte, then its uint32 operands
+// (see operandCount) in host byte order, unaligned. Literals live only in
+// the constant pool. The main code comes first and ends in END; each
+// function's body follows in `functions` order.
+struct BytecodeProgram {
+    static constexpr size_t OPERAND_SIZE = sizeof(uint32_t);
+
+    struct Function {
+        std::string name;
+        uint32_t entry;                   // offset of its first instruction
+        uint32_t params;                  // arguments arrive in the first slots
+        uint32_t frameSize;               // params plus locals
+        std::vector<std::string> locals;  // slot names, for the disassembler
+    };
+
+    std::vector<BytecodeValue> constants;   // Pool of constants
+    std::vector<std::string> variables;     // Variable names table (for mapping indices)
+    std::vector<Function> functions;        // CALL operands index this
+    std::vector<uint8_t> code;              // The packed bytecode stream
+
+    struct Decoded {
+        OpCode op;
+        uint32_t operand;   // 0 when the opcode has none
+        uint32_t operand2;  // 0 unless the opcode takes two
+        size_t next;        // offset of the following instruction
+    };
+
+    // Both return the offset of the emitted instruction.
+    size_t emit(OpCode op) {
+        size_t at = code.size();
+        code.push_back(static_cast<uint8_t>(op));
+        return at;
+    }
+    size_t emit(OpCode op, uint32_t operand) {
+        size_t at = emit(op);
+        code.resize(at + 1 + OPERAND_SIZE);
+        std::memcpy(&code[at + 1], &operand, OPERAND_SIZE);
+        return at;
+    }
+    size_t emit(OpCode op, uint32_t operand, uint32_t operand2) {
+        size_t at = emit(op, operand);
+        code.resize(at + 1 + 2 * OPERAND_SIZE);
+        std::memcpy(&code[at + 1 + OPERAND_SIZE], &operand2, OPERAND_SIZE);
+        return at;
+    }
+    void setOperand(size_t at, uint32_t operand) {
+        std::memcpy(&code[at + 1], &operand, OPERAND_SIZE);
+    }
+
+    static uint32_t readOperand(const uint8_t* at) {
+        uint32_t v;
+        std::memcpy(&v, at, OPERAND_SIZE);
+        return v;
+    }
+
+    Decoded decode(size_t at) const {
+        if (at >= code.size())
+            throw std::runtime_error("Bytecode: offset " + std::to_string(at) + " is past the end");
+        OpCode op = static_cast<OpCode>(code[at]);
+        if (!opName(op))
+            throw std::runtime_error("Bytecode: bad opcode " + std::to_string(code[at]) + " at " + std::to_string(at));
+        int count = operandCount(op);
+        if (count == 0) return {op, 0, 0, at + 1};
+        if (at + 1 + count * OPERAND_SIZE > code.size())
+            throw std::runtime_error("Bytecode: truncated operand at " + std::to_string(at));
+        uint32_t second = count == 2 ? readOperand(&code[at + 1 + OPERAND_SIZE]) : 0;
+        return {op, readOperand(&code[at + 1]), second, at + 1 + count * OPERAND_SIZE};
+    }
+
+    // One instruction per line: offset, mnemonic, operand, and what the
+    // operand refers to. Each function body starts with a header line.
+    void disassemble(std::ostream& out = std::cout) const {
+        const Function* fn = nullptr;
+        size_t nextFn = 0;
+        for (size_t at = 0; at < code.size();) {
+            Decoded d = decode(at);
+            if (nextFn < functions.size() && functions[nextFn].entry == at) {
+                fn = &functions[nextFn++];
+                out << "\n" << fn->name << "(" << fn->params << " param(s), " << fn->frameSize << " slot(s)):\n";
+            }
+            out << std::setw(6) << std::setfill('0') << at << std::setfill(' ') << "  ";
+            if (!hasOperand(d.op)) {
+                out << opName(d.op);
+            } else if (operandCount(d.op) == 2) {
+                out << std::left << std::setw(18) << opName(d.op) << std::right << d.operand << ", " << d.operand2;
+                const std::string* name = nullptr;
+                if (d.op == OpCode::INC_VAR && d.operand < variables.size()) name = &variables[d.operand];
+                else if (d.op == OpCode::INC_LOCAL && fn && d.operand < fn->locals.size()) name = &fn->locals[d.operand];
+                if (name && d.operand2 < constants.size())
+                    out << "  ; " << *name << " += " << describe(constants[d.operand2]);
+            } else {
+                out << std::left << std::setw(18) << opName(d.op) << std::right << d.operand;
+                if (d.op == OpCode::LOAD_CONST && d.operand < constants.size())
+                    out << "  ; " << describe(constants[d.operand]);
+                else if ((d.op == OpCode::LOAD_VAR || d.op == OpCode::SET_VAR) && d.operand < variables.size())
+                    out << "  ; " << variables[d.operand];
+                else if ((d.op == OpCode::LOAD_LOCAL || d.op == OpCode::SET_LOCAL) && fn && d.operand < fn->locals.size())
+                    out << "  ; " << fn->locals[d.operand];
+                else if ((d.op == OpCode::CALL || d.op == OpCode::TAIL_CALL) && d.operand < functions.size())
+                    out << "  ; " << functions[d.operand].name;
+            }
+            out << "\n";
+            at = d.next;
+        }
+    }
+
+private:
+    static std::string describe(const BytecodeValue& v) {
+        switch (v.index()) {
+            case 0: return std::to_string(std::get<int64_t>(v));
+            case 1: {
+                std::ostringstream out;
+                out << std::get<double>(v);
+                return out.str();
+            }
+            case 2: return "\"" + std::get<std::string>(v) + "\"";
+            default: return std::get<bool>(v) ? "true" : "false";
+        }
+    }
+};
+
+// Thrown, when compiling, for what only the tree walker runs: thread,
+// await, pipe and the file builtins.
+struct WalkerOnlyError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// === Bytecode Compiler: AstArena -> BytecodeProgram === //
+// Names are resolved first (see Resolver). The program's own variables
+// become global slots indexed in `variables`; a function's parameters and
+// locals become slots of its frame. Nothing is looked up by name at run
+// time. The VM has no closures, so a function reading a variable of an
+// enclosing function is rejected.
+class BytecodeCompiler {
+public:
+    // Throws std::runtime_error for unresolved names and for constructs the
+    // VM does not run (WalkerOnlyError for those the walker does).
+    BytecodeProgram compile(const AstArena& tree, NodeId root) {
+        ast = &tree;
+        names = Resolver().resolve(tree, root);
+        program = BytecodeProgram{};
+        program.variables.resize(names.frameSize[root]);
+        constantIndex.clear();
+        level = 0;
+        compileNode(root);
+        program.emit(OpCode::END);
+        // Each body ends in RETURN_NONE, so none can run into the next.
+        for (const FunctionInfo& fn : names.functions) {
+            current = program.functions.size();
+            program.functions.push_back({spell(fn.def), here(), fn.params, fn.frameSize,
+                                         std::vector<std::string>(fn.frameSize)});
+            level = fn.level;
+            compileNode(fn.body);
+            program.emit(OpCode::RETURN_NONE);
+        }
+        return std::move(program);
+    }
+
+private:
+    const AstArena* ast = nullptr;
+    ResolvedNames names;
+    BytecodeProgram program;
+    std::map<BytecodeValue, uint32_t> constantIndex;
+    uint32_t level = 0;   // frames below the program's: 0 while compiling the main code
+    size_t current = 0;   // function being compiled, when level > 0
+
+    uint32_t here() const { return static_cast<uint32_t>(program.code.size()); }
+    size_t emitJump(OpCode op) { return program.emit(op, 0); }
+    void patch(size_t jump) { program.setOperand(jump, here()); }
+
+    std::string spell(NodeId node) const { return std::string(SymbolInterner::global().name(ast->symbol(node))); }
+
+    // A resolved (depth, slot) that reaches the program's frame is a global;
+    // depth 0 inside a function is one of its own slots.
+    void emitVariable(NodeId node, OpCode global, OpCode local) {
+        emitSlot(names.at(node), spell(node), node, global, local);
+    }
+    void emitSlot(const VarSlot& v, const std::string& name, NodeId node, OpCode global, OpCode local) {
+        if (v.depth == level) {
+            program.variables[v.slot] = name;
+            program.emit(global, v.slot);
+        } else if (v.depth == 0) {
+            program.functions[current].locals[v.slot] = name;
+            program.emit(local, v.slot);
+        } else {
+            throw std::runtime_error("Bytecode: '" + name + "' belongs to an enclosing function at line " +
+                                     std::to_string(ast->line(node)) + "; closures are not supported");
+        }
+    }
+    void emitConst(BytecodeValue v) {
+        auto [it, fresh] = constantIndex.try_emplace(v, static_cast<uint32_t>(program.constants.size()));
+        if (fresh) program.constants.push_back(std::move(v));
+        program.emit(OpCode::LOAD_CONST, it->second);
+    }
+
+    void compileNode(NodeId node) {
+        const AstArena& a = *ast;
+        switch (a.kind(node)) {
+            case NodeKind::Program:
+            case NodeKind::Block:
+                for (NodeId child : a.children(node)) compileNode(child);
+                break;
+            case NodeKind::Val:
+            case NodeKind::Var:
+            case NodeKind::Assign:
+                compileExpr(a.child(node, 0));
+                emitVariable(node, OpCode::SET_VAR, OpCode::SET_LOCAL);
+                break;
+            case NodeKind::Say:
+                compileExpr(a.child(node, 0));
+                program.emit(OpCode::SAY);
+                break;
+            case NodeKind::If: {
+                compileExpr(a.child(node, 0));
+                size_t toElse = emitJump(OpCode::JUMP_IF_FALSE);
+                compileNode(a.child(node, 1));
+                if (a.childCount(node) > 2) {
+                    size_t toEnd = emitJump(OpCode::JUMP);
+                    patch(toElse);
+                    compileNode(a.child(node, 2));
+                    patch(toEnd);
+                } else {
+                    patch(toElse);
+                }
+                break;
+            }
+            case NodeKind::While: {
+                uint32_t top = here();
+                compileExpr(a.child(node, 0));
+                size_t toExit = emitJump(OpCode::JUMP_IF_FALSE);
+                compileNode(a.child(node, 1));
+                program.emit(OpCode::JUMP, top);
+                patch(toExit);
+                break;
+            }
+            case NodeKind::Loop: {
+                // counter = from; limit = to; while counter <= limit: body; counter = counter + 1
+                VarSlot counter = names.at(node), limit{0, names.limit[node]};
+                std::string counterName = a.symbol(node) != sym::NONE ? spell(node) : "(loop)";
+                auto emitCounter = [&](OpCode global, OpCode local) { emitSlot(counter, counterName, node, global, local); };
+                auto emitLimit = [&](OpCode global, OpCode local) { emitSlot(limit, "(limit)", node, global, local); };
+                compileExpr(a.child(node, 0));  // both bounds before the counter changes
+                compileExpr(a.child(node, 1));
+                emitLimit(OpCode::SET_VAR, OpCode::SET_LOCAL);
+                emitCounter(OpCode::SET_VAR, OpCode::SET_LOCAL);
+                uint32_t top = here();
+                emitCounter(OpCode::LOAD_VAR, OpCode::LOAD_LOCAL);
+                emitLimit(OpCode::LOAD_VAR, OpCode::LOAD_LOCAL);
+                program.emit(OpCode::LE);
+                size_t toExit = emitJump(OpCode::JUMP_IF_FALSE);
+                compileNode(a.child(node, 2));
+                emitCounter(OpCode::LOAD_VAR, OpCode::LOAD_LOCAL);
+                emitConst(int64_t(1));
+                program.emit(OpCode::ADD);
+                emitCounter(OpCode::SET_VAR, OpCode::SET_LOCAL);
+                program.emit(OpCode::JUMP, top);
+                patch(toExit);
+                break;
+            }
+            case NodeKind::FuncDef:
+                break;  // compiled after the main code, from the function table
+            case NodeKind::Call:
+                compileExpr(node);
+                program.emit(OpCode::POP);
+                break;
+            case NodeKind::Return:
+                if (a.childCount(node) == 0) {
+                    program.emit(OpCode::RETURN_NONE);
+                } else if (names.tailCall[a.child(node, 0)]) {
+                    NodeId call = a.child(node, 0);
+                    for (NodeId arg : a.children(call)) compileExpr(arg);
+                    program.emit(OpCode::TAIL_CALL, names.callee[call]);
+                } else {
+                    compileExpr(a.child(node, 0));
+                    program.emit(OpCode::RETURN);
+                }
+                break;
+            case NodeKind::Thread:
+            case NodeKind::Await:
+                throw WalkerOnlyError("Bytecode: 'thread' and 'await' need the tree walker (--vm=walk) at line " +
+                                      std::to_string(a.line(node)));
+            case NodeKind::Pipe:
+                throw WalkerOnlyError("Bytecode: 'pipe' needs the tree walker (--vm=walk) at line " +
+                                      std::to_string(a.line(node)));
+            default:
+                throw std::runtime_error("Bytecode: unsupported statement at line " + std::to_string(a.line(node)));
+        }
+    }
+
+    void compileExpr(NodeId node) {
+        const AstArena& a = *ast;
+        switch (a.kind(node)) {
+            case NodeKind::IntLiteral:    emitConst(a.intValue(node)); break;
+            case NodeKind::FloatLiteral:  emitConst(a.floatValue(node)); break;
+            case NodeKind::StringLiteral: emitConst(std::string(a.text(node))); break;
+            case NodeKind::BoolLiteral:   emitConst(a.boolValue(node)); break;
+            case NodeKind::Identifier:
+                emitVariable(node, OpCode::LOAD_VAR, OpCode::LOAD_LOCAL);
+                break;
+            case NodeKind::Call:
+                if (names.builtin[node] != Builtin::None)
+                    throw WalkerOnlyError("Bytecode: '" + std::string(builtinInfo(names.builtin[node]).name) +
+                                          "' needs the tree walker (--vm=walk) at line " + std::to_string(a.line(node)));
+                // Arguments land in order on the stack; they become the
+                // callee's first slots where they lie.
+                for (NodeId arg : a.children(node)) compileExpr(arg);
+                program.emit(OpCode::CALL, names.callee[node]);
+                break;
+            case NodeKind::UnaryOp:
+                compileExpr(a.child(node, 0));
+                program.emit(a.op(node) == AstOp::Not ? OpCode::NOT : OpCode::NEG);
+                break;
+            case NodeKind::BinaryOp:
+                compileBinary(node);
+                break;
+            case NodeKind::Interpolate:
+                // "" + part + part ...: ADD concatenates once either side is text
+                emitConst(std::string());
+                for (NodeId part : a.children(node)) {
+                    compileExpr(part);
+                    program.emit(OpCode::ADD);
+                }
+                break;
+            default:
+                throw std::runtime_error("Bytecode: unsupported expression at line " + std::to_string(a.line(node)));
+        }
+    }
+
+    void compileBinary(NodeId node) {
+        const AstArena& a = *ast;
+        AstOp op = a.op(node);
+        if (op == AstOp::And || op == AstOp::Or) {
+            // Short-circuit; the result is always a bool.
+            compileExpr(a.child(node, 0));
+            size_t shortCut = emitJump(OpCode::JUMP_IF_FALSE);
+            if (op == AstOp::Or) {
+                emitConst(true);                       // left was truthy
+                size_t toEnd = emitJump(OpCode::JUMP);
+                patch(shortCut);
+                compileExpr(a.child(node, 1));
+                program.emit(OpCode::NOT);
+                program.emit(OpCode::NOT);
+                patch(toEnd);
+            } else {
+                compileExpr(a.child(node, 1));
+                program.emit(OpCode::NOT);
+                program.emit(OpCode::NOT);
+                size_t toEnd = emitJump(OpCode::JUMP);
+                patch(shortCut);
+                emitConst(false);                      // left was falsy
+                patch(toEnd);
+            }
+            return;
+        }
+        compileExpr(a.child(node, 0));
+        compileExpr(a.child(node, 1));
+        static const OpCode lowered[] = {
+            OpCode::ADD, OpCode::SUB, OpCode::MUL, OpCode::DIV, OpCode::MOD,
+            OpCode::EQ, OpCode::NE, OpCode::LT, OpCode::LE, OpCode::GT, OpCode::GE
+        };
+        program.emit(lowered[static_cast<size_t>(op)]);
+    }
+};
+
+// Superinstructions.h
+// Peephole pass over a compiled BytecodeProgram: sequences the compiler
+// emits over and over become one fused opcode, so the VM dispatches once
+// where it dispatched two or four times. The fused set came from hottest()
+// over VM profiles of loop-heavy scripts, where counter updates
+// (LOAD_VAR LOAD_CONST ADD SET_VAR, what `i = i + 1` and every `loop`
+// step lower to) and compare-then-branch (every loop and `while` test)
+// lead by a wide margin.
+//
+// Nothing is fused across a jump target or a function entry, so every
+// target survives the rewrite and the instructions of one fused group
+// always run the same number of times. That is what lets
+// savedDispatches() tell, from an unfused profile, how many dispatches
+// fusion saves.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "Bytecode.h"
+
+class Superinstructions {
+public:
+    // One instruction of the sequence a fused opcode stands for.
+    struct Step {
+        OpCode op;
+        uint32_t operand;
+    };
+    struct Sequence {
+        std::vector<OpCode> ops;
+        uint64_t runs;  // times the whole sequence ran
+    };
+
+    // Rewrites `program` in place; returns how many instructions went.
+    static size_t fuse(BytecodeProgram& program) {
+        std::vector<Instruction> in = decodeAll(program);
+        std::vector<bool> leader = leaders(program, in);
+        BytecodeProgram out;
+        std::vector<uint32_t> moved(program.code.size() + 1, 0);  // old offset -> new
+        size_t removed = 0;
+        for (size_t i = 0; i < in.size();) {
+            moved[in[i].at] = static_cast<uint32_t>(out.code.size());
+            Match m = match(in, leader, i);
+            if (m.length) {
+                if (operandCount(m.op) == 2) out.emit(m.op, m.operand, m.operand2);
+                else out.emit(m.op, m.operand);
+                removed += m.length - 1;
+                i += m.length;
+                continue;
+            }
+            const BytecodeProgram::Decoded& d = in[i].d;
+            switch (operandCount(d.op)) {
+                case 0: out.emit(d.op); break;
+                case 1: out.emit(d.op, d.operand); break;
+                default: out.emit(d.op, d.operand, d.operand2); break;
+            }
+            ++i;
+        }
+        for (size_t at = 0; at < out.code.size();) {
+            BytecodeProgram::Decoded d = out.decode(at);
+            if (isJump(d.op)) out.setOperand(at, moved[d.operand]);
+            at = d.next;
+        }
+        for (BytecodeProgram::Function& f : program.functions) f.entry = moved[f.entry];
+        program.code = std::move(out.code);
+        return removed;
+    }
+
+    // The instructions `d` stands for, in order, written to `steps`; returns
+    // how many. An unfused instruction stands for itself.
+    static size_t expand(const BytecodeProgram::Decoded& d, Step steps[4]) {
+        switch (d.op) {
+            case OpCode::INC_VAR:
+            case OpCode::INC_LOCAL: {
+                bool global = d.op == OpCode::INC_VAR;
+                steps[0] = {global ? OpCode::LOAD_VAR : OpCode::LOAD_LOCAL, d.operand};
+                steps[1] = {OpCode::LOAD_CONST, d.operand2};
+                steps[2] = {OpCode::ADD, 0};
+                steps[3] = {global ? OpCode::SET_VAR : OpCode::SET_LOCAL, d.operand};
+                return 4;
+            }
+            case OpCode::EQ_JUMP_IF_FALSE:
+            case OpCode::NE_JUMP_IF_FALSE:
+            case OpCode::LT_JUMP_IF_FALSE:
+            case OpCode::LE_JUMP_IF_FALSE:
+            case OpCode::GT_JUMP_IF_FALSE:
+            case OpCode::GE_JUMP_IF_FALSE:
+                steps[0] = {comparison(d.op), 0};
+                steps[1] = {OpCode::JUMP_IF_FALSE, d.operand};
+                return 2;
+            default:
+                steps[0] = {d.op, d.operand};
+                return 1;
+        }
+    }
+
+    // The comparison a compare-and-branch opcode makes.
+    static OpCode comparison(OpCode fused) {
+        return static_cast<OpCode>(static_cast<uint8_t>(OpCode::EQ) +
+                                   (static_cast<uint8_t>(fused) - static_cast<uint8_t>(OpCode::EQ_JUMP_IF_FALSE)));
+    }
+
+    // Dispatches fuse() would save, given `runs`, a VM::dispatches()
+    // profile of the unfused program: the fused program's count is the
+    // unfused total minus this.
+    static uint64_t savedDispatches(const BytecodeProgram& program, const std::vector<uint64_t>& runs) {
+        std::vector<Instruction> in = decodeAll(program);
+        std::vector<bool> leader = leaders(program, in);
+        uint64_t saved = 0;
+        for (size_t i = 0; i < in.size();) {
+            Match m = match(in, leader, i);
+            if (m.length) {
+                saved += runs[in[i].at] * (m.length - 1);
+                i += m.length;
+            } else {
+                ++i;
+            }
+        }
+        return saved;
+    }
+
+    // The `top` most-run straight-line sequences of 2 to `longest` opcodes,
+    // from the same kind of profile: the candidates for a new fused opcode.
+    static std::vector<Sequence> hottest(const BytecodeProgram& program, const std::vector<uint64_t>& runs,
+                                         size_t longest = 4, size_t top = 10) {
+        std::vector<Instruction> in = decodeAll(program);
+        std::vector<bool> leader = leaders(program, in);
+        std::map<std::vector<OpCode>, uint64_t> counts;
+        for (size_t i = 0; i < in.size(); ++i) {
+            uint64_t n = runs[in[i].at];
+            if (!n) continue;
+            std::vector<OpCode> ops{in[i].d.op};
+            for (size_t k = i + 1; k < in.size() && ops.size() < longest; ++k) {
+                if (leader[in[k].at] || endsBlock(in[k - 1].d.op)) break;
+                ops.push_back(in[k].d.op);
+                counts[ops] += n;
+            }
+        }
+        std::vector<Sequence> ranked;
+        for (auto& [ops, n] : counts) ranked.push_back({ops, n});
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const Sequence& a, const Sequence& b) { return a.runs > b.runs; });
+        if (ranked.size() > top) ranked.resize(top);
+        return ranked;
+    }
+
+private:
+    struct Instruction {
+        size_t at;
+        BytecodeProgram::Decoded d;
+    };
+    struct Match {
+        OpCode op;
+        size_t length;  // instructions replaced; 0 for no match
+        uint32_t operand, operand2;
+    };
+
+    static std::vector<Instruction> decodeAll(const BytecodeProgram& program) {
+        std::vector<Instruction> in;
+        for (size_t at = 0; at < program.code.size();) {
+            in.push_back({at, program.decode(at)});
+            at = in.back().d.next;
+        }
+        return in;
+    }
+
+    // Offsets something other than the previous instruction can reach.
+    static std::vector<bool> leaders(const BytecodeProgram& program, const std::vector<Instruction>& in) {
+        std::vector<bool> leader(program.code.size() + 1, false);
+        leader[0] = true;
+        for (const Instruction& i : in)
+            if (isJump(i.d.op) && i.d.operand < leader.size()) leader[i.d.operand] = true;
+        for (const BytecodeProgram::Function& f : program.functions)
+            if (f.entry < leader.size()) leader[f.entry] = true;
+        return leader;
+    }
+
+    static bool endsBlock(OpCode op) {
+        return isJump(op) || op == OpCode::RETURN || op == OpCode::RETURN_NONE || op == OpCode::TAIL_CALL ||
+               op == OpCode::END;
+    }
+
+    static Match match(const std::vector<Instruction>& in, const std::vector<bool>& leader, size_t i) {
+        // The k-th opcode from i, or NOP (never part of a pattern) if that
+        // would reach past the end or into another block.
+        auto op = [&](size_t k) {
+            if (i + k >= in.size() || (k && leader[in[i + k].at])) return OpCode::NOP;
+            return in[i + k].d.op;
+        };
+        OpCode first = op(0);
+        if ((first == OpCode::LOAD_VAR || first == OpCode::LOAD_LOCAL) && op(1) == OpCode::LOAD_CONST &&
+            op(2) == OpCode::ADD) {
+            OpCode set = first == OpCode::LOAD_VAR ? OpCode::SET_VAR : OpCode::SET_LOCAL;
+            if (op(3) == set && in[i + 3].d.operand == in[i].d.operand)
+                return {first == OpCode::LOAD_VAR ? OpCode::INC_VAR : OpCode::INC_LOCAL, 4,
+                        in[i].d.operand, in[i + 1].d.operand};
+        }
+        if (first >= OpCode::EQ && first <= OpCode::GE && op(1) == OpCode::JUMP_IF_FALSE) {
+            OpCode fused = static_cast<OpCode>(static_cast<uint8_t>(OpCode::EQ_JUMP_IF_FALSE) +
+                                               (static_cast<uint8_t>(first) - static_cast<uint8_t>(OpCode::EQ)));
+            return {fused, 2, in[i + 1].d.operand, 0};
+        }
+        return {OpCode::NOP, 0, 0, 0};
+    }
+};
+
+// QuarterJIT.h
+// Baseline JIT for the bytecode VM. One region's bytecode (a function, or
+// the main code) becomes x86-64 instruction by instruction, with no analysis beyond what VM::load has
+// already verified. Frames keep the interpreter's layout (the same operand
+// stack, the same slots), so compiled and interpreted code call each other
+// freely and no value is ever converted. Variable moves, int arithmetic and
+// comparisons, and branches are inlined; everything else, and the slow
+// path of those, calls the VM's generic handler for the opcode. Handlers
+// report an error by returning null and leaving the message in the VM:
+// generated code has no unwind info, so nothing may throw through it.
+// Because the layouts match, an interpreted activation can also move into
+// compiled code mid-run: every loop header gets a second entry point that
+// takes the interpreter's fp and sp as they are (on-stack replacement).
+// TAIL_CALL pops the native frame and jumps to the callee, which returns
+// straight to this code's caller.
+//
+// While generated code runs: rbx = sp, r12 = fp, r13 = the VM, r14 = the
+// globals. All four are callee-saved, so handler calls leave them alone.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "Bytecode.h"
+#include "NanBox.h"
+#include "Superinstructions.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define QTR_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+class VM;
+using JitStub = NanBox* (*)(VM* vm, NanBox* sp, uint32_t operand);
+using JitEntry = NanBox* (*)(VM* vm, NanBox* fp, NanBox* sp, NanBox* globals);
+
+// Entry into a compiled region at the loop whose header is bytecode offset
+// `header`, with the operand stack as the interpreter left it there.
+struct OsrEntry {
+    uint32_t header;
+    JitEntry entry;
+};
+
+// What generated code calls back into. A stub returns the new sp, or null
+// on error.
+struct JitRuntime {
+    JitStub ops[256] = {};                               // generic handler per opcode
+    void (*release)(uint64_t bits) = nullptr;            // drops one string reference
+    int (*truthy)(uint64_t bits) = nullptr;              // tests a popped value, dropping it
+    NanBox* (*leave)(NanBox* fp, NanBox* sp) = nullptr;  // RETURN: result to fp[0]
+    // TAIL_CALL: moves the arguments to fp and returns the entry to jump to.
+    JitEntry (*tail)(VM* vm, NanBox* fp, NanBox* sp, uint32_t index) = nullptr;
+};
+
+// Just the encodings the baseline JIT needs. Memory operands are always
+// [base + disp32].
+class X64Assembler {
+public:
+    enum Reg : uint8_t { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+    enum Cond : uint8_t { E = 0x4, NE = 0x5, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF };
+
+    std::vector<uint8_t> code;
+
+    size_t size() const { return code.size(); }
+
+    void push(Reg r) { rexB(r); byte(0x50 | (r & 7)); }
+    void pop(Reg r) { rexB(r); byte(0x58 | (r & 7)); }
+    void ret() { byte(0xC3); }
+    void mov(Reg dst, Reg src) { rr(0x89, src, dst); }
+    void movImm(Reg dst, uint64_t imm) {
+        byte(0x48 | (dst >> 3));
+        byte(0xB8 | (dst & 7));
+        raw(imm, 8);
+    }
+    void movImm32(Reg dst, uint32_t imm) {  // zero-extends
+        rexB(dst);
+        byte(0xB8 | (dst & 7));
+        raw(imm, 4);
+    }
+    void load(Reg dst, Reg base, int32_t disp) { mem(0x8B, dst, base, disp); }
+    void store(Reg base, int32_t disp, Reg src) { mem(0x89, src, base, disp); }
+    void add(Reg dst, Reg src) { rr(0x01, src, dst); }
+    void sub(Reg dst, Reg src) { rr(0x29, src, dst); }
+    void andReg(Reg dst, Reg src) { rr(0x21, src, dst); }
+    void orReg(Reg dst, Reg src) { rr(0x09, src, dst); }
+    void cmp(Reg a, Reg b) { rr(0x39, b, a); }  // flags of a - b
+    void test32(Reg a, Reg b) {
+        if ((a | b) & 8) byte(0x40 | ((b >> 3) << 2) | (a >> 3));
+        byte(0x85);
+        byte(0xC0 | ((b & 7) << 3) | (a & 7));
+    }
+    void addImm(Reg r, int32_t imm) { aluImm(0, r, imm); }
+    void subImm(Reg r, int32_t imm) { aluImm(5, r, imm); }
+    void cmpImm(Reg r, int32_t imm) { aluImm(7, r, imm); }
+    void shl(Reg r, uint8_t n) { shift(4, r, n); }
+    void shr(Reg r, uint8_t n) { shift(5, r, n); }
+    void sar(Reg r, uint8_t n) { shift(7, r, n); }
+    void setccEax(Cond c) {  // eax = condition ? 1 : 0
+        byte(0x0F); byte(0x90 | c); byte(0xC0);  // setcc al
+        byte(0x0F); byte(0xB6); byte(0xC0);      // movzx eax, al
+    }
+    void incDword(Reg base) {  // add dword [base], 1; no SIB or disp, so not rsp/rbp/r12/r13
+        rexB(base);
+        byte(0x83); byte(base & 7); byte(1);
+    }
+    void call(Reg r) {
+        rexB(r);
+        byte(0xFF); byte(0xD0 | (r & 7));
+    }
+    void jmp(Reg r) {
+        rexB(r);
+        byte(0xFF); byte(0xE0 | (r & 7));
+    }
+
+    // Branches to targets not emitted yet return the rel32 to patch().
+    size_t jmp() { byte(0xE9); return hole(); }
+    size_t jcc(Cond c) { byte(0x0F); byte(0x80 | c); return hole(); }
+    void patch(size_t at, size_t target) {
+        int32_t rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+        std::memcpy(&code[at], &rel, 4);
+    }
+    // Short forward branch over a few bytes, closed by bind8().
+    size_t jcc8(Cond c) { byte(0x70 | c); byte(0); return code.size() - 1; }
+    void bind8(size_t at) { code[at] = static_cast<uint8_t>(code.size() - (at + 1)); }
+
+private:
+    void byte(uint8_t b) { code.push_back(b); }
+    void raw(uint64_t v, int n) {
+        for (int i = 0; i < n; ++i) byte(static_cast<uint8_t>(v >> (8 * i)));
+    }
+    size_t hole() { raw(0, 4); return code.size() - 4; }
+    void rexB(Reg r) { if (r & 8) byte(0x41); }
+    void rr(uint8_t opcode, Reg reg, Reg rm) {
+        byte(0x48 | ((reg >> 3) << 2) | (rm >> 3));
+        byte(opcode);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+    void mem(uint8_t opcode, Reg reg, Reg base, int32_t disp) {
+        byte(0x48 | ((reg >> 3) << 2) | (base >> 3));
+        byte(opcode);
+        byte(0x80 | ((reg & 7) << 3) | (base & 7));  // mod 10: [base + disp32]
+        if ((base & 7) == RSP) byte(0x24);           // rsp and r12 need a SIB byte
+        raw(static_cast<uint32_t>(disp), 4);
+    }
+    void aluImm(uint8_t ext, Reg r, int32_t imm) {
+        byte(0x48 | (r >> 3));
+        byte(0x81);
+        byte(0xC0 | (ext << 3) | (r & 7));
+        raw(static_cast<uint32_t>(imm), 4);
+    }
+    void shift(uint8_t ext, Reg r, uint8_t n) {
+        byte(0x48 | (r >> 3));
+        byte(0xC1);
+        byte(0xC0 | (ext << 3) | (r & 7));
+        byte(n);
+    }
+};
+
+class BaselineJIT {
+public:
+    BaselineJIT() = default;
+    BaselineJIT(const BaselineJIT&) = delete;
+    BaselineJIT& operator=(const BaselineJIT&) = delete;
+    ~BaselineJIT() { reset(); }
+
+    // Compiles the region whose bytecode is code[begin, end), with
+    // `constants` as the VM's boxed pool, and returns the entry at `begin`.
+    // A function returns the caller's sp at RETURN; the main code returns
+    // its sp at END, leaving the clearing to the VM. `loops`, if given,
+    // receives an entry per backward jump target. Null when there is no
+    // native backend for this platform or no executable memory to be had;
+    // the caller then keeps interpreting.
+    JitEntry compile(const BytecodeProgram& program, size_t begin, size_t end,
+                     const NanBox* constants, const JitRuntime& rt,
+                     std::vector<OsrEntry>* loops = nullptr) {
+#ifdef QTR_JIT
+        using A = X64Assembler;
+        constexpr int32_t SLOT = sizeof(NanBox);
+        A a;
+
+        // Five pushes on top of the return address leave rsp 16-byte
+        // aligned for every call below.
+        auto prologue = [&] {
+            a.push(A::RBP);
+            a.mov(A::RBP, A::RSP);
+            a.push(A::RBX);
+            a.push(A::R12);
+            a.push(A::R13);
+            a.push(A::R14);
+            a.mov(A::R13, A::RDI);
+            a.mov(A::R12, A::RSI);
+            a.mov(A::RBX, A::RDX);
+            a.mov(A::R14, A::RCX);
+        };
+        prologue();
+
+        auto restore = [&] {
+            a.pop(A::R14);
+            a.pop(A::R13);
+            a.pop(A::R12);
+            a.pop(A::RBX);
+            a.pop(A::RBP);
+        };
+        auto epilogue = [&] {
+            restore();
+            a.ret();
+        };
+
+        // Out-of-line paths, emitted after the body.
+        struct Slow {
+            std::vector<size_t> from;  // rel32s that branch here
+            OpCode op;
+            uint32_t operand;
+            size_t resume;             // native offset to continue at
+        };
+        std::vector<Slow> slow;
+        std::vector<uint32_t> native(end - begin);        // native offset per instruction
+        std::vector<std::pair<size_t, uint32_t>> jumps;    // rel32, bytecode target
+        std::vector<size_t> failures;                      // rel32s to the error exit
+        std::vector<uint32_t> headers;                     // backward jump targets
+        bool ok = true;
+
+        auto callStub = [&](OpCode op, uint32_t operand) {
+            JitStub stub = rt.ops[static_cast<uint8_t>(op)];
+            if (!stub) ok = false;
+            a.mov(A::RDI, A::R13);
+            a.mov(A::RSI, A::RBX);
+            a.movImm32(A::RDX, operand);
+            a.movImm(A::RAX, reinterpret_cast<uint64_t>(stub));
+            a.call(A::RAX);
+            a.cmpImm(A::RAX, 0);
+            failures.push_back(a.jcc(A::E));
+            a.mov(A::RBX, A::RAX);
+        };
+        auto isTag = [&](A::Reg value, uint64_t tag) {  // clobbers rdx
+            a.mov(A::RDX, value);
+            a.shr(A::RDX, 48);
+            a.cmpImm(A::RDX, static_cast<int32_t>(tag >> 48));
+        };
+        auto pushValue = [&](A::Reg base, int32_t disp) {  // copies a slot onto the stack
+            a.load(A::RAX, base, disp);
+            a.store(A::RBX, 0, A::RAX);
+            a.addImm(A::RBX, SLOT);
+            isTag(A::RAX, NanBox::TAG_STRING);
+            size_t skip = a.jcc8(A::NE);
+            a.mov(A::RCX, A::RAX);
+            a.shl(A::RCX, 16);
+            a.shr(A::RCX, 16);
+            a.incDword(A::RCX);  // Str::refs is the first member
+            a.bind8(skip);
+        };
+        auto releaseRdi = [&] {
+            isTag(A::RDI, NanBox::TAG_STRING);
+            size_t skip = a.jcc8(A::NE);
+            a.movImm(A::RAX, reinterpret_cast<uint64_t>(rt.release));
+            a.call(A::RAX);
+            a.bind8(skip);
+        };
+        auto popToRdi = [&] {  // leaves none behind, as the interpreter does
+            a.subImm(A::RBX, SLOT);
+            a.load(A::RDI, A::RBX, 0);
+            a.movImm(A::RDX, NanBox::TAG_NONE);
+            a.store(A::RBX, 0, A::RDX);
+        };
+        // Both operands ints: rax and rcx hold them sign-extended.
+        auto intOperands = [&](Slow& s) {
+            a.load(A::RAX, A::RBX, -2 * SLOT);
+            a.load(A::RCX, A::RBX, -SLOT);
+            isTag(A::RAX, NanBox::TAG_INT);
+            s.from.push_back(a.jcc(A::NE));
+            isTag(A::RCX, NanBox::TAG_INT);
+            s.from.push_back(a.jcc(A::NE));
+            a.shl(A::RAX, 16);
+            a.sar(A::RAX, 16);
+            a.shl(A::RCX, 16);
+            a.sar(A::RCX, 16);
+        };
+        auto replaceOperands = [&] {  // rax is the boxed result
+            a.store(A::RBX, -2 * SLOT, A::RAX);
+            a.subImm(A::RBX, SLOT);
+            a.movImm(A::RDX, NanBox::TAG_NONE);
+            a.store(A::RBX, 0, A::RDX);
+        };
+        auto leave = [&] {
+            a.mov(A::RDI, A::R12);
+            a.mov(A::RSI, A::RBX);
+            a.movImm(A::RAX, reinterpret_cast<uint64_t>(rt.leave));
+            a.call(A::RAX);
+            epilogue();
+        };
+
+        for (size_t at = begin; at < end && ok;) {
+            BytecodeProgram::Decoded d = program.decode(at);
+            native[at - begin] = static_cast<uint32_t>(a.size());
+            // A fused opcode is emitted as the sequence it stands for.
+            Superinstructions::Step steps[4];
+            size_t count = Superinstructions::expand(d, steps);
+            for (size_t k = 0; k < count && ok; ++k) {
+                const Superinstructions::Step& step = steps[k];
+                switch (step.op) {
+                    case OpCode::NOP:
+                        break;
+                    case OpCode::LOAD_CONST: {
+                        uint64_t bits = constants[step.operand].bits;
+                        a.movImm(A::RAX, bits);
+                        a.store(A::RBX, 0, A::RAX);
+                        a.addImm(A::RBX, SLOT);
+                        if (constants[step.operand].isCounted()) {
+                            a.movImm(A::RCX, bits & NanBox::PAYLOAD);
+                            a.incDword(A::RCX);
+                        }
+                        break;
+                    }
+                    case OpCode::LOAD_VAR:
+                        pushValue(A::R14, static_cast<int32_t>(step.operand) * SLOT);
+                        break;
+                    case OpCode::LOAD_LOCAL:
+                        pushValue(A::R12, static_cast<int32_t>(step.operand) * SLOT);
+                        break;
+                    case OpCode::SET_VAR:
+                    case OpCode::SET_LOCAL: {
+                        A::Reg base = step.op == OpCode::SET_VAR ? A::R14 : A::R12;
+                        int32_t disp = static_cast<int32_t>(step.operand) * SLOT;
+                        popToRdi();
+                        a.mov(A::RAX, A::RDI);
+                        a.load(A::RDI, base, disp);  // the old value, released below
+                        a.store(base, disp, A::RAX);
+                        releaseRdi();
+                        break;
+                    }
+                    case OpCode::POP:
+                        popToRdi();
+                        releaseRdi();
+                        break;
+                    case OpCode::ADD:
+                    case OpCode::SUB: {
+                        slow.push_back({{}, step.op, 0, 0});
+                        intOperands(slow.back());
+                        if (step.op == OpCode::ADD) a.add(A::RAX, A::RCX);
+                        else a.sub(A::RAX, A::RCX);
+                        // Outside 48 bits the generic path makes it a double.
+                        a.mov(A::RDX, A::RAX);
+                        a.shl(A::RDX, 16);
+                        a.sar(A::RDX, 16);
+                        a.cmp(A::RDX, A::RAX);
+                        slow.back().from.push_back(a.jcc(A::NE));
+                        a.movImm(A::RDX, NanBox::PAYLOAD);
+                        a.andReg(A::RAX, A::RDX);
+                        a.movImm(A::RDX, NanBox::TAG_INT);
+                        a.orReg(A::RAX, A::RDX);
+                        replaceOperands();
+                        slow.back().resume = a.size();
+                        break;
+                    }
+                    case OpCode::EQ:
+                    case OpCode::NE:
+                    case OpCode::LT:
+                    case OpCode::LE:
+                    case OpCode::GT:
+                    case OpCode::GE: {
+                        static const A::Cond conditions[] = {A::E, A::NE, A::L, A::LE, A::G, A::GE};
+                        slow.push_back({{}, step.op, 0, 0});
+                        intOperands(slow.back());
+                        a.cmp(A::RAX, A::RCX);
+                        a.setccEax(conditions[static_cast<uint8_t>(step.op) - static_cast<uint8_t>(OpCode::EQ)]);
+                        a.movImm(A::RDX, NanBox::TAG_BOOL);
+                        a.orReg(A::RAX, A::RDX);
+                        replaceOperands();
+                        slow.back().resume = a.size();
+                        break;
+                    }
+                    case OpCode::JUMP:
+                        if (step.operand < at) headers.push_back(step.operand);
+                        jumps.push_back({a.jmp(), step.operand});
+                        break;
+                    case OpCode::JUMP_IF_FALSE: {
+                        // Bools inline; anything else asks rt.truthy.
+                        popToRdi();
+                        a.movImm(A::RAX, NanBox::boolean(false).bits);
+                        a.cmp(A::RDI, A::RAX);
+                        jumps.push_back({a.jcc(A::E), step.operand});
+                        a.movImm(A::RAX, NanBox::boolean(true).bits);
+                        a.cmp(A::RDI, A::RAX);
+                        slow.push_back({{a.jcc(A::NE)}, step.op, step.operand, 0});
+                        slow.back().resume = a.size();
+                        break;
+                    }
+                    case OpCode::RETURN:
+                        leave();
+                        break;
+                    case OpCode::RETURN_NONE:
+                        a.addImm(A::RBX, SLOT);  // the slot at sp is none: that is the result
+                        leave();
+                        break;
+                    case OpCode::TAIL_CALL: {
+                        // The callee gets this frame's fp and return address.
+                        if (!rt.tail) ok = false;
+                        a.mov(A::RDI, A::R13);
+                        a.mov(A::RSI, A::R12);
+                        a.mov(A::RDX, A::RBX);
+                        a.movImm32(A::RCX, step.operand);
+                        a.movImm(A::RAX, reinterpret_cast<uint64_t>(rt.tail));
+                        a.call(A::RAX);
+                        a.cmpImm(A::RAX, 0);
+                        failures.push_back(a.jcc(A::E));
+                        a.mov(A::RDI, A::R13);
+                        a.mov(A::RSI, A::R12);
+                        a.mov(A::RDX, A::R12);
+                        a.addImm(A::RDX, static_cast<int32_t>(program.functions[step.operand].frameSize) * SLOT);
+                        a.mov(A::RCX, A::R14);
+                        restore();
+                        a.jmp(A::RAX);
+                        break;
+                    }
+                    case OpCode::END:
+                        a.mov(A::RAX, A::RBX);
+                        epilogue();
+                        break;
+                    default:
+                        callStub(step.op, step.operand);
+                        break;
+                }
+            }
+            at = d.next;
+        }
+        if (!ok) return nullptr;
+
+        for (Slow& s : slow) {
+            for (size_t from : s.from) a.patch(from, a.size());
+            if (s.op == OpCode::JUMP_IF_FALSE) {
+                a.movImm(A::RAX, reinterpret_cast<uint64_t>(rt.truthy));  // rdi still holds the value
+                a.call(A::RAX);
+                a.test32(A::RAX, A::RAX);
+                jumps.push_back({a.jcc(A::E), s.operand});
+            } else {
+                callStub(s.op, s.operand);
+            }
+            a.patch(a.jmp(), s.resume);
+        }
+        for (size_t from : failures) a.patch(from, a.size());
+        a.movImm32(A::RAX, 0);
+        epilogue();
+        for (const auto& [from, target] : jumps) a.patch(from, native[target - begin]);
+        if (!ok) return nullptr;
+
+        // OSR entries: the same prologue, then straight to the loop header.
+        std::sort(headers.begin(), headers.end());
+        headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+        std::vector<size_t> osrAt;
+        for (uint32_t header : headers) {
+            osrAt.push_back(a.size());
+            prologue();
+            a.patch(a.jmp(), native[header - begin]);
+        }
+
+        // Written while writable, then flipped to executable: never both.
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t size = (a.size() + page - 1) / page * page;
+        void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == MAP_FAILED) return nullptr;
+        std::memcpy(block, a.code.data(), a.size());
+        if (mprotect(block, size, PROT_READ | PROT_EXEC) != 0) {
+            munmap(block, size);
+            return nullptr;
+        }
+        blocks.push_back({block, size});
+        bytes += a.size();
+        if (loops) {
+            loops->clear();
+            for (size_t i = 0; i < headers.size(); ++i)
+                loops->push_back({headers[i], reinterpret_cast<JitEntry>(static_cast<uint8_t*>(block) + osrAt[i])});
+        }
+        return reinterpret_cast<JitEntry>(block);
+#else
+        (void)program; (void)begin; (void)end; (void)constants; (void)rt; (void)loops;
+        return nullptr;
+#endif
+    }
+
+    // Frees all generated code; every JitEntry handed out is dead after this.
+    void reset() {
+#ifdef QTR_JIT
+        for (const Block& b : blocks) munmap(b.at, b.size);
+#endif
+        blocks.clear();
+        bytes = 0;
+    }
+
+    size_t functions() const { return blocks.size(); }
+    size_t codeBytes() const { return bytes; }
+
+private:
+    struct Block {
+        void* at;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t bytes = 0;
+};
+
+// VM.h
+// Stack VM that executes BytecodeProgram's packed stream in place. Values
+// are NanBox words. A call's frame is a window of the operand stack: its
+// arguments, its other locals, then its temporaries; the program's own
+// variables are globals. load() verifies the stream and works out how deep
+// each function's temporaries can go, so the stack is checked once per call
+// instead of once per push. On GCC/Clang dispatch is computed goto, one
+// indirect jump per handler so each gets its own branch history; elsewhere
+// a switch.
+//
+// Functions tier up: every call adds to its hotness, and the call that
+// reaches JIT_THRESHOLD compiles it with BaselineJIT. Calls made from native
+// code compile their callee on the spot, so native code never re-enters the
+// interpreter. A loop that runs long without any call being made (the main
+// code's, or one in a function entered only once) is caught by its back
+// edge instead: the jump that reaches OSR_THRESHOLD compiles the region it
+// is in and carries on in native code from the loop header, with the frame
+// exactly as it is.
+//
+// TAIL_CALL hands the returning frame to its callee: the arguments move down
+// to fp and nothing is pushed, so tail recursion runs in constant space in
+// the interpreter, and native code jumps to the callee instead of calling.
+#pragma once
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "NanBox.h"
+#include "QuarterJIT.h"
+#include "QuarterOutput.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define QTR_COMPUTED_GOTO 1
+#endif
+
+class VM {
+public:
+    static constexpr size_t STACK_SIZE = 1 << 16;   // values, shared by every frame
+    static constexpr size_t MAX_CALL_DEPTH = 4000;  // native code recurses on the C stack
+    static constexpr uint32_t JIT_THRESHOLD = 1000;  // calls of one function
+    static constexpr uint32_t OSR_THRESHOLD = 1000;  // back edges of one loop
+
+    VM() : stack(STACK_SIZE) {
+        runtime.ops[uint8_t(OpCode::SAY)] = &stub<OpCode::SAY>;
+        runtime.ops[uint8_t(OpCode::ADD)] = &stub<OpCode::ADD>;
+        runtime.ops[uint8_t(OpCode::SUB)] = &stub<OpCode::SUB>;
+        runtime.ops[uint8_t(OpCode::MUL)] = &stub<OpCode::MUL>;
+        runtime.ops[uint8_t(OpCode::DIV)] = &stub<OpCode::DIV>;
+        runtime.ops[uint8_t(OpCode::MOD)] = &stub<OpCode::MOD>;
+        runtime.ops[uint8_t(OpCode::EQ)] = &stub<OpCode::EQ>;
+        runtime.ops[uint8_t(OpCode::NE)] = &stub<OpCode::NE>;
+        runtime.ops[uint8_t(OpCode::LT)] = &stub<OpCode::LT>;
+        runtime.ops[uint8_t(OpCode::LE)] = &stub<OpCode::LE>;
+        runtime.ops[uint8_t(OpCode::GT)] = &stub<OpCode::GT>;
+        runtime.ops[uint8_t(OpCode::GE)] = &stub<OpCode::GE>;
+        runtime.ops[uint8_t(OpCode::NEG)] = &stub<OpCode::NEG>;
+        runtime.ops[uint8_t(OpCode::NOT)] = &stub<OpCode::NOT>;
+        runtime.ops[uint8_t(OpCode::CALL)] = &callFromNative;
+        runtime.release = [](uint64_t bits) { NanBox dropped = NanBox::adopt(bits); };
+        runtime.truthy = [](uint64_t bits) -> int { return truthy(NanBox::adopt(bits)); };
+        runtime.leave = [](NanBox* fp, NanBox* sp) { return leave(fp, sp); };
+        runtime.tail = &tailFromNative;
+    }
+
+    // Off: everything stays interpreted.
+    void setJit(bool enabled) { jitEnabled = enabled; }
+    size_t compiledFunctions() const { return jit.functions(); }
+
+    // On: runs are interpreted only, and dispatches() counts how often the
+    // instruction at each code offset was dispatched.
+    void setProfile(bool enabled) { profiling = enabled; }
+    const std::vector<uint64_t>& dispatches() const { return dispatchCounts; }
+
+    void run(const BytecodeProgram& program) {
+        load(program);
+        try {
+            execute(code, stack.data(), stack.data(), NO_FUNCTION);
+        } catch (...) {
+            // Values may be left anywhere; every slot past sp must be none
+            // when the next run starts.
+            for (NanBox& v : stack) v = NanBox();
+            QuarterOutput::local().flush();
+            throw;
+        }
+        QuarterOutput::local().flush();
+    }
+
+    // Value of a variable slot after run(), in the bytecode value type.
+    BytecodeValue variable(size_t slot) const { return toBytecodeValue(vars[slot]); }
+
+private:
+    static constexpr uint32_t NO_FUNCTION = UINT32_MAX;
+
+    struct Function {
+        const uint8_t* entry;
+        uint32_t begin, end;   // its bytecode, as offsets
+        uint32_t params;
+        uint32_t frameSize;
+        uint32_t maxStack;     // temporaries above the frame, from load()
+        uint32_t hotness = 0;
+        bool tiered = false;   // tierUp() has run, whether or not it compiled
+        JitEntry native = nullptr;
+        std::vector<OsrEntry> loops;
+    };
+    struct CallFrame {
+        const uint8_t* ret;
+        NanBox* fp;
+        uint32_t fn;
+    };
+
+    std::vector<NanBox> stack;   // slots past sp are always none
+    std::vector<NanBox> vars;
+    std::vector<NanBox> pool;
+    std::vector<Function> fns;
+    Function mainCode{};         // a region like the functions, for OSR
+    std::vector<uint32_t> backEdges;  // per bytecode offset: jumps back to it
+    std::vector<uint64_t> dispatchCounts;  // per bytecode offset, when profiling
+    std::vector<CallFrame> frames;
+    const BytecodeProgram* program = nullptr;
+    const uint8_t* code = nullptr;
+    size_t callDepth = 0;
+    uint32_t tailCallee = 0;  // for interpretTail
+    bool jitEnabled = true;
+    bool profiling = false;
+    BaselineJIT jit;
+    JitRuntime runtime;
+    std::string fault;  // why native code stopped
+
+    // Runs from `ip` until END, or until the frame it was entered with
+    // returns; either way returns sp. load() has already checked every
+    // operand and every stack depth, so the handlers do not.
+    NanBox* execute(const uint8_t* ip, NanBox* fp, NanBox* sp, uint32_t current) {
+        constexpr size_t WIDE = 1 + BytecodeProgram::OPERAND_SIZE;  // opcode + operand
+        constexpr size_t WIDER = WIDE + BytecodeProgram::OPERAND_SIZE;  // opcode + two operands
+        // Locals, not members, so the compiler can keep them in registers
+        // across the stores the handlers make through `sp`.
+        const NanBox* constants = pool.data();
+        NanBox* globals = vars.data();
+        const uint8_t* base = code;
+        uint32_t* loopHeat = backEdges.data();
+        uint64_t* counts = profiling ? dispatchCounts.data() : nullptr;
+        const size_t floor = frames.size();
+
+#ifdef QTR_COMPUTED_GOTO
+        void* jump[256];
+        for (void*& target : jump) target = &&op_BAD;
+        jump[uint8_t(OpCode::NOP)] = &&op_NOP;
+        jump[uint8_t(OpCode::LOAD_CONST)] = &&op_LOAD_CONST;
+        jump[uint8_t(OpCode::LOAD_VAR)] = &&op_LOAD_VAR;
+        jump[uint8_t(OpCode::SET_VAR)] = &&op_SET_VAR;
+        jump[uint8_t(OpCode::LOAD_LOCAL)] = &&op_LOAD_LOCAL;
+        jump[uint8_t(OpCode::SET_LOCAL)] = &&op_SET_LOCAL;
+        jump[uint8_t(OpCode::SAY)] = &&op_SAY;
+        jump[uint8_t(OpCode::ADD)] = &&op_ADD;
+        jump[uint8_t(OpCode::SUB)] = &&op_SUB;
+        jump[uint8_t(OpCode::MUL)] = &&op_MUL;
+        jump[uint8_t(OpCode::DIV)] = &&op_DIV;
+        jump[uint8_t(OpCode::MOD)] = &&op_MOD;
+        jump[uint8_t(OpCode::EQ)] = &&op_EQ;
+        jump[uint8_t(OpCode::NE)] = &&op_NE;
+        jump[uint8_t(OpCode::LT)] = &&op_LT;
+        jump[uint8_t(OpCode::LE)] = &&op_LE;
+        jump[uint8_t(OpCode::GT)] = &&op_GT;
+        jump[uint8_t(OpCode::GE)] = &&op_GE;
+        jump[uint8_t(OpCode::NEG)] = &&op_NEG;
+        jump[uint8_t(OpCode::NOT)] = &&op_NOT;
+        jump[uint8_t(OpCode::POP)] = &&op_POP;
+        jump[uint8_t(OpCode::JUMP)] = &&op_JUMP;
+        jump[uint8_t(OpCode::JUMP_IF_FALSE)] = &&op_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::CALL)] = &&op_CALL;
+        jump[uint8_t(OpCode::RETURN)] = &&op_RETURN;
+        jump[uint8_t(OpCode::RETURN_NONE)] = &&op_RETURN_NONE;
+        jump[uint8_t(OpCode::INC_VAR)] = &&op_INC_VAR;
+        jump[uint8_t(OpCode::INC_LOCAL)] = &&op_INC_LOCAL;
+        jump[uint8_t(OpCode::EQ_JUMP_IF_FALSE)] = &&op_EQ_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::NE_JUMP_IF_FALSE)] = &&op_NE_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::LT_JUMP_IF_FALSE)] = &&op_LT_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::LE_JUMP_IF_FALSE)] = &&op_LE_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::GT_JUMP_IF_FALSE)] = &&op_GT_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::GE_JUMP_IF_FALSE)] = &&op_GE_JUMP_IF_FALSE;
+        jump[uint8_t(OpCode::TAIL_CALL)] = &&op_TAIL_CALL;
+        jump[uint8_t(OpCode::END)] = &&op_END;
+        // Profiling routes every dispatch through op_COUNT first, so the
+        // handlers themselves pay nothing for it.
+        void* counted[256];
+        if (counts) {
+            std::copy(std::begin(jump), std::end(jump), counted);
+            for (void*& target : jump) target = &&op_COUNT;
+        }
+#define VM_CASE(name) op_##name
+#define VM_NEXT() goto *jump[*ip]
+        VM_NEXT();
+    op_COUNT:
+        ++counts[ip - base];
+        goto *counted[*ip];
+#else
+#define VM_CASE(name) case OpCode::name
+#define VM_NEXT() break
+        for (;;) {
+        if (counts) ++counts[ip - base];
+        switch (static_cast<OpCode>(*ip)) {
+#endif
+
+#define VM_OPERAND() BytecodeProgram::readOperand(ip + 1)
+#define VM_OPERAND2() BytecodeProgram::readOperand(ip + WIDE)
+// Both operands ints: integer result. Otherwise numeric, as doubles.
+#define VM_ARITH(box_int, expr_num)                                       \
+            ++ip;                                                         \
+            --sp;                                                         \
+            if (sp[-1].isInt() && sp->isInt()) {                          \
+                int64_t a = sp[-1].asInt(), b = sp->asInt();              \
+                sp[-1] = (box_int);                                       \
+            } else {                                                      \
+                double a = number(sp[-1]), b = number(*sp);               \
+                sp[-1] = NanBox::number(expr_num);                        \
+            }                                                             \
+            *sp = NanBox();
+#define VM_COMPARE(cmp)                                                   \
+            ++ip;                                                         \
+            --sp;                                                         \
+            sp[-1] = NanBox::boolean(compare(sp[-1], *sp) cmp 0);         \
+            *sp = NanBox();
+// Pops both operands; falls through if the comparison holds.
+#define VM_COMPARE_JUMP(holds)                                            \
+            sp -= 2;                                                      \
+            ip = (holds) ? ip + WIDE : base + VM_OPERAND();               \
+            sp[0] = NanBox();                                             \
+            sp[1] = NanBox();
+#define VM_ORDER_JUMP(cmp)                                                \
+            VM_COMPARE_JUMP(sp[0].isInt() && sp[1].isInt() ? sp[0].asInt() cmp sp[1].asInt() \
+                                                          : compare(sp[0], sp[1]) cmp 0)
+
+        VM_CASE(NOP):
+            ++ip;
+            VM_NEXT();
+        VM_CASE(LOAD_CONST):
+            *sp++ = constants[VM_OPERAND()];
+            ip += WIDE;
+            VM_NEXT();
+        VM_CASE(LOAD_VAR):
+            *sp++ = globals[VM_OPERAND()];
+            ip += WIDE;
+            VM_NEXT();
+        VM_CASE(SET_VAR):
+            globals[VM_OPERAND()] = std::move(*--sp);
+            ip += WIDE;
+            VM_NEXT();
+        VM_CASE(LOAD_LOCAL):
+            *sp++ = fp[VM_OPERAND()];
+            ip += WIDE;
+            VM_NEXT();
+        VM_CASE(SET_LOCAL):
+            fp[VM_OPERAND()] = std::move(*--sp);
+            ip += WIDE;
+            VM_NEXT();
+        VM_CASE(SAY):
+            ++ip;
+            --sp;
+            say(*sp);
+            *sp = NanBox();
+            VM_NEXT();
+        VM_CASE(POP):
+            ++ip;
+            *--sp = NanBox();
+            VM_NEXT();
+        VM_CASE(ADD):
+            if (sp[-2].isString() || sp[-1].isString()) {
+                ++ip;
+                --sp;
+                sp[-1] = NanBox::concat(textValue(sp[-1]), textValue(*sp));
+                *sp = NanBox();
+                VM_NEXT();
+            }
+            VM_ARITH(NanBox::integer(a + b), a + b)
+            VM_NEXT();
+        VM_CASE(SUB):
+            VM_ARITH(NanBox::integer(a - b), a - b)
+            VM_NEXT();
+        VM_CASE(MUL):
+            VM_ARITH(multiply(a, b), a * b)
+            VM_NEXT();
+        VM_CASE(DIV):
+            if (number(sp[-1]) == 0) throw std::runtime_error("VM: division by zero");
+            VM_ARITH(NanBox::number(double(a) / double(b)), a / b)  // a real quotient, as the walker gives
+            VM_NEXT();
+        VM_CASE(MOD):
+            if (number(sp[-1]) == 0) throw std::runtime_error("VM: division by zero");
+            VM_ARITH(NanBox::integer(a % b), std::fmod(a, b))
+            VM_NEXT();
+        VM_CASE(EQ):
+            ++ip;
+            --sp;
+            sp[-1] = NanBox::boolean(equal(sp[-1], *sp));
+            *sp = NanBox();
+            VM_NEXT();
+        VM_CASE(NE):
+            ++ip;
+            --sp;
+            sp[-1] = NanBox::boolean(!equal(sp[-1], *sp));
+            *sp = NanBox();
+            VM_NEXT();
+        VM_CASE(LT):
+            VM_COMPARE(<)
+            VM_NEXT();
+        VM_CASE(LE):
+            VM_COMPARE(<=)
+            VM_NEXT();
+        VM_CASE(GT):
+            VM_COMPARE(>)
+            VM_NEXT();
+        VM_CASE(GE):
+            VM_COMPARE(>=)
+            VM_NEXT();
+        VM_CASE(NEG):
+            ++ip;
+            if (sp[-1].isInt()) sp[-1] = NanBox::integer(-sp[-1].asInt());
+            else sp[-1] = NanBox::number(-number(sp[-1]));
+            VM_NEXT();
+        VM_CASE(NOT):
+            ++ip;
+            sp[-1] = NanBox::boolean(!truthy(sp[-1]));
+            VM_NEXT();
+        VM_CASE(JUMP): {
+            uint32_t target = VM_OPERAND();
+            if (base + target < ip && ++loopHeat[target] == OSR_THRESHOLD && compiling()) {
+                if (JitEntry entry = osrEntry(current, target)) {
+                    sp = entry(this, fp, sp, globals);
+                    if (!sp) throw std::runtime_error(fault);
+                    // It ran to the end of the region.
+                    if (current == NO_FUNCTION) goto do_end;
+                    goto did_return;
+                }
+            }
+            ip = base + target;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_IF_FALSE):
+            --sp;
+            ip = truthy(*sp) ? ip + WIDE : base + VM_OPERAND();
+            *sp = NanBox();
+            VM_NEXT();
+        VM_CASE(EQ_JUMP_IF_FALSE):
+            VM_COMPARE_JUMP(equal(sp[0], sp[1]))
+            VM_NEXT();
+        VM_CASE(NE_JUMP_IF_FALSE):
+            VM_COMPARE_JUMP(!equal(sp[0], sp[1]))
+            VM_NEXT();
+        VM_CASE(LT_JUMP_IF_FALSE):
+            VM_ORDER_JUMP(<)
+            VM_NEXT();
+        VM_CASE(LE_JUMP_IF_FALSE):
+            VM_ORDER_JUMP(<=)
+            VM_NEXT();
+        VM_CASE(GT_JUMP_IF_FALSE):
+            VM_ORDER_JUMP(>)
+            VM_NEXT();
+        VM_CASE(GE_JUMP_IF_FALSE):
+            VM_ORDER_JUMP(>=)
+            VM_NEXT();
+        VM_CASE(INC_VAR): {
+            NanBox& v = globals[VM_OPERAND()];
+            const NanBox& c = constants[VM_OPERAND2()];
+            v = v.isInt() && c.isInt() ? NanBox::integer(v.asInt() + c.asInt()) : binary(OpCode::ADD, v, c);
+            ip += WIDER;
+            VM_NEXT();
+        }
+        VM_CASE(INC_LOCAL): {
+            NanBox& v = fp[VM_OPERAND()];
+            const NanBox& c = constants[VM_OPERAND2()];
+            v = v.isInt() && c.isInt() ? NanBox::integer(v.asInt() + c.asInt()) : binary(OpCode::ADD, v, c);
+            ip += WIDER;
+            VM_NEXT();
+        }
+        VM_CASE(CALL): {
+            uint32_t index = VM_OPERAND();
+            Function& f = fns[index];
+            if (!f.tiered && ++f.hotness >= JIT_THRESHOLD) tierUp(f);
+            NanBox* callee = sp - f.params;  // the arguments become its first slots
+            enter(f, callee);
+            if (f.native) {
+                sp = runNative(f, callee);
+                ip += WIDE;
+                VM_NEXT();
+            }
+            frames.push_back({ip + WIDE, fp, current});
+            fp = callee;
+            sp = callee + f.frameSize;  // the slots past the arguments are already none
+            ip = f.entry;
+            current = index;
+            VM_NEXT();
+        }
+        VM_CASE(TAIL_CALL): {
+            uint32_t index = VM_OPERAND();
+            Function& f = fns[index];
+            if (!f.tiered && ++f.hotness >= JIT_THRESHOLD) tierUp(f);
+            replaceFrame(f, fp, sp);
+            sp = fp + f.frameSize;
+            if (f.native) {
+                sp = f.native(this, fp, sp, globals);
+                if (!sp) throw std::runtime_error(fault);
+                goto did_return;
+            }
+            ip = f.entry;
+            current = index;
+            VM_NEXT();
+        }
+        VM_CASE(RETURN_NONE):
+            ++sp;  // the slot at sp is none, and that is the result
+            goto do_return;
+        VM_CASE(RETURN):
+        do_return:
+            sp = leave(fp, sp);
+        did_return:
+            --callDepth;
+            if (frames.size() == floor) return sp;
+            ip = frames.back().ret;
+            fp = frames.back().fp;
+            current = frames.back().fn;
+            frames.pop_back();
+            VM_NEXT();
+        VM_CASE(END):
+        do_end:
+            while (sp != stack.data()) *--sp = NanBox();
+            return sp;
+#ifdef QTR_COMPUTED_GOTO
+        op_BAD:
+#else
+        default:
+#endif
+            throw std::runtime_error("VM: bad opcode " + std::to_string(*ip));
+#ifndef QTR_COMPUTED_GOTO
+        }
+        }
+#endif
+#undef VM_OPERAND
+#undef VM_OPERAND2
+#undef VM_ARITH
+#undef VM_COMPARE
+#undef VM_COMPARE_JUMP
+#undef VM_ORDER_JUMP
+#undef VM_CASE
+#undef VM_NEXT
+    }
+
+    QTR_HOT void enter(const Function& f, NanBox* callee) {
+        if (callDepth >= MAX_CALL_DEPTH) throw std::runtime_error("VM: call depth limit exceeded");
+        if (static_cast<size_t>(stack.data() + STACK_SIZE - callee) < f.frameSize + f.maxStack)
+            throw std::runtime_error("VM: operand stack overflow");
+        ++callDepth;
+    }
+
+    // RETURN: the result moves to the frame's first slot and every slot
+    // above it is cleared. Returns the caller's sp.
+    QTR_HOT static NanBox* leave(NanBox* fp, NanBox* sp) {
+        NanBox result = std::move(*--sp);
+        while (sp != fp) *--sp = NanBox();
+        *fp = std::move(result);
+        return fp + 1;
+    }
+
+    // TAIL_CALL: `f` takes over the frame at fp. Its arguments, on top of
+    // the stack, become the first slots; the rest of the old frame and its
+    // temporaries are cleared.
+    QTR_HOT void replaceFrame(const Function& f, NanBox* fp, NanBox* sp) {
+        if (static_cast<size_t>(stack.data() + STACK_SIZE - fp) < f.frameSize + f.maxStack)
+            throw std::runtime_error("VM: operand stack overflow");
+        NanBox* args = sp - f.params;  // never below fp, so moving down is safe
+        for (uint32_t i = 0; i < f.params; ++i) fp[i] = std::move(args[i]);
+        while (sp != fp + f.params) *--sp = NanBox();
+    }
+
+    NanBox* runNative(const Function& f, NanBox* callee) {
+        NanBox* sp = f.native(this, callee, callee + f.frameSize, vars.data());
+        --callDepth;
+        if (!sp) throw std::runtime_error(fault);
+        return sp;
+    }
+
+    bool compiling() const { return jitEnabled && !profiling; }
+
+    QTR_COLD void tierUp(Function& f) {
+        f.tiered = true;
+        if (compiling()) f.native = jit.compile(*program, f.begin, f.end, pool.data(), runtime, &f.loops);
+    }
+
+    // Native entry at the loop headed at `header` in the running region,
+    // compiling the region first if it has not been; null if there is none.
+    QTR_COLD JitEntry osrEntry(uint32_t current, uint32_t header) {
+        Function& f = current == NO_FUNCTION ? mainCode : fns[current];
+        if (!f.tiered) tierUp(f);
+        for (const OsrEntry& loop : f.loops)
+            if (loop.header == header) return loop.entry;
+        return nullptr;
+    }
+
+    // CALL from native code.
+    NanBox* invoke(uint32_t index, NanBox* sp) {
+        Function& f = fns[index];
+        if (!f.tiered) tierUp(f);
+        NanBox* callee = sp - f.params;
+        enter(f, callee);
+        if (f.native) return runNative(f, callee);
+        return execute(f.entry, callee, callee + f.frameSize, index);
+    }
+
+    // One instruction done the interpreter's way, for native code's slow
+    // paths and for what it does not inline.
+    NanBox* step(OpCode op, NanBox* sp, uint32_t operand) {
+        switch (op) {
+            case OpCode::CALL:
+                return invoke(operand, sp);
+            case OpCode::SAY:
+                say(sp[-1]);
+                sp[-1] = NanBox();
+                return sp - 1;
+            case OpCode::NEG:
+                if (sp[-1].isInt()) sp[-1] = NanBox::integer(-sp[-1].asInt());
+                else sp[-1] = NanBox::number(-number(sp[-1]));
+                return sp;
+            case OpCode::NOT:
+                sp[-1] = NanBox::boolean(!truthy(sp[-1]));
+                return sp;
+            default:
+                sp[-2] = binary(op, sp[-2], sp[-1]);
+                sp[-1] = NanBox();
+                return sp - 1;
+        }
+    }
+
+    template <OpCode Op>
+    static NanBox* stub(VM* vm, NanBox* sp, uint32_t operand) noexcept {
+        try {
+            return vm->step(Op, sp, operand);
+        } catch (const std::exception& e) {
+            vm->fault = e.what();
+            return nullptr;
+        }
+    }
+
+    // CALL's stub: native to native directly once the callee is compiled.
+    static NanBox* callFromNative(VM* vm, NanBox* sp, uint32_t index) noexcept {
+        Function& f = vm->fns[index];
+        NanBox* callee = sp - f.params;
+        if (f.native && vm->callDepth < MAX_CALL_DEPTH &&
+            static_cast<size_t>(vm->stack.data() + STACK_SIZE - callee) >= f.frameSize + f.maxStack) {
+            ++vm->callDepth;
+            NanBox* result = f.native(vm, callee, callee + f.frameSize, vm->vars.data());
+            --vm->callDepth;
+            return result;  // null: the fault is already recorded
+        }
+        return stub<OpCode::CALL>(vm, sp, index);
+    }
+
+    // TAIL_CALL's helper: replaces the frame and returns what native code
+    // jumps to in place of returning, the callee's code or interpretTail.
+    // Null on error.
+    static JitEntry tailFromNative(VM* vm, NanBox* fp, NanBox* sp, uint32_t index) noexcept {
+        try {
+            Function& f = vm->fns[index];
+            if (!f.tiered) vm->tierUp(f);
+            vm->replaceFrame(f, fp, sp);
+            if (f.native) return f.native;
+            vm->tailCallee = index;
+            return &interpretTail;
+        } catch (const std::exception& e) {
+            vm->fault = e.what();
+            return nullptr;
+        }
+    }
+    // A tail callee the JIT could not compile, run where native code was.
+    static NanBox* interpretTail(VM* vm, NanBox* fp, NanBox* sp, NanBox*) noexcept {
+        uint32_t index = vm->tailCallee;
+        try {
+            ++vm->callDepth;  // the interpreter's return takes it off again
+            return vm->execute(vm->fns[index].entry, fp, sp, index);
+        } catch (const std::exception& e) {
+            vm->fault = e.what();
+            return nullptr;
+        }
+    }
+
+    // One decode pass per region (the main code, then each function body):
+    // every opcode is known, every operand is in range, every jump lands on
+    // an instruction of its own region, the stack never underflows and is
+    // equally deep however an instruction is reached, and no region runs
+    // off its end.
+    void load(const BytecodeProgram& program) {
+        this->program = &program;
+        code = program.code.data();
+        jit.reset();
+        fns.clear();
+        frames.clear();
+        callDepth = 0;
+
+        size_t mainEnd = program.functions.empty() ? program.code.size() : program.functions[0].entry;
+        mainCode = Function{};
+        mainCode.entry = code;
+        mainCode.end = static_cast<uint32_t>(mainEnd);
+        mainCode.maxStack = verify(program, 0, mainEnd, nullptr);
+        if (mainCode.maxStack > STACK_SIZE)
+            throw std::runtime_error("VM: operand stack overflow");
+        backEdges.assign(program.code.size(), 0);
+        dispatchCounts.assign(profiling ? program.code.size() : 0, 0);
+        for (size_t i = 0; i < program.functions.size(); ++i) {
+            const BytecodeProgram::Function& f = program.functions[i];
+            size_t end = i + 1 < program.functions.size() ? program.functions[i + 1].entry : program.code.size();
+            if (f.entry >= end || f.params > f.frameSize)
+                throw std::runtime_error("VM: bad function table entry for '" + f.name + "'");
+            Function fn;
+            fn.entry = code + f.entry;
+            fn.begin = f.entry;
+            fn.end = static_cast<uint32_t>(end);
+            fn.params = f.params;
+            fn.frameSize = f.frameSize;
+            fn.maxStack = verify(program, f.entry, end, &f);
+            fns.push_back(fn);
+        }
+
+        pool.clear();
+        for (const BytecodeValue& c : program.constants) pool.push_back(fromBytecodeValue(c));
+        vars.assign(program.variables.size(), NanBox{});
+    }
+
+    // Checks code[begin, end) and returns the most temporaries it can have
+    // on the stack at once. `fn` is null for the main code.
+    static uint32_t verify(const BytecodeProgram& program, size_t begin, size_t end,
+                           const BytecodeProgram::Function* fn) {
+        auto fail = [](size_t at, const std::string& what) {
+            throw std::runtime_error("VM: " + what + " at " + std::to_string(at));
+        };
+        std::vector<int32_t> depthAt(end - begin, -1);     // -1: not an instruction
+        std::unordered_map<size_t, uint32_t> pending;      // forward jump target -> depth there
+        uint32_t depth = 0, deepest = 0;
+        bool live = true;                                  // reachable by falling through
+        for (size_t at = begin; at < end;) {
+            BytecodeProgram::Decoded d = program.decode(at);
+            if (d.next > end) fail(at, "instruction runs past the end of its function");
+            auto p = pending.find(at);
+            if (p != pending.end()) {
+                if (live && p->second != depth) fail(at, "inconsistent stack depth");
+                depth = p->second;
+                live = true;
+                pending.erase(p);
+            } else if (!live) {
+                depth = 0;  // unreachable; statements start on an empty stack
+            }
+            depthAt[at - begin] = static_cast<int32_t>(depth);
+
+            // A fused opcode is checked as the sequence it stands for.
+            Superinstructions::Step steps[4];
+            size_t count = Superinstructions::expand(d, steps);
+            for (size_t k = 0; k < count; ++k) {
+                const Superinstructions::Step& step = steps[k];
+                uint32_t pops = 0, pushes = 0;
+                switch (step.op) {
+                    case OpCode::LOAD_CONST:
+                        if (step.operand >= program.constants.size()) fail(at, "constant out of range");
+                        pushes = 1;
+                        break;
+                    case OpCode::LOAD_VAR:
+                    case OpCode::SET_VAR:
+                        if (step.operand >= program.variables.size()) fail(at, "variable out of range");
+                        (step.op == OpCode::LOAD_VAR ? pushes : pops) = 1;
+                        break;
+                    case OpCode::LOAD_LOCAL:
+                    case OpCode::SET_LOCAL:
+                        if (!fn || step.operand >= fn->frameSize) fail(at, "local slot out of range");
+                        (step.op == OpCode::LOAD_LOCAL ? pushes : pops) = 1;
+                        break;
+                    case OpCode::CALL:
+                        if (step.operand >= program.functions.size()) fail(at, "function out of range");
+                        pops = program.functions[step.operand].params;
+                        pushes = 1;
+                        break;
+                    case OpCode::RETURN:
+                    case OpCode::RETURN_NONE:
+                        if (!fn) fail(at, "return outside a function");
+                        pops = step.op == OpCode::RETURN;
+                        break;
+                    case OpCode::TAIL_CALL:
+                        if (!fn) fail(at, "return outside a function");
+                        if (step.operand >= program.functions.size()) fail(at, "function out of range");
+                        pops = program.functions[step.operand].params;
+                        break;
+                    case OpCode::END:
+                        if (fn) fail(at, "END inside a function");
+                        break;
+                    case OpCode::NEG:
+                    case OpCode::NOT:
+                        pops = pushes = 1;
+                        break;
+                    case OpCode::SAY:
+                    case OpCode::POP:
+                    case OpCode::JUMP_IF_FALSE:
+                        pops = 1;
+                        break;
+                    case OpCode::NOP:
+                    case OpCode::JUMP:
+                        break;
+                    default:  // binary operators
+                        pops = 2;
+                        pushes = 1;
+                        break;
+                }
+                if (depth < pops) fail(at, "operand stack underflow");
+                depth = depth - pops + pushes;
+                deepest = std::max(deepest, depth);
+            }
+
+            if (isJump(d.op)) {
+                if (d.operand < begin || d.operand >= end) fail(at, "jump out of its function");
+                if (d.operand <= at) {
+                    int32_t there = depthAt[d.operand - begin];
+                    if (there < 0) fail(at, "jump into the middle of an instruction");
+                    if (static_cast<uint32_t>(there) != depth) fail(at, "inconsistent stack depth");
+                } else {
+                    auto [it, fresh] = pending.try_emplace(d.operand, depth);
+                    if (!fresh && it->second != depth) fail(at, "inconsistent stack depth");
+                }
+            }
+            live = d.op != OpCode::JUMP && d.op != OpCode::RETURN && d.op != OpCode::RETURN_NONE &&
+                   d.op != OpCode::TAIL_CALL && d.op != OpCode::END;
+            at = d.next;
+        }
+        if (!pending.empty()) fail(pending.begin()->first, "jump into the middle of an instruction");
+        if (live) throw std::runtime_error(fn ? "VM: function '" + fn->name + "' does not end in a return"
+                                              : "VM: program does not end with END");
+        return deepest;
+    }
+
+public:
+    // Value semantics, shared with RegisterVM. Constant strings are interned.
+    static NanBox fromBytecodeValue(const BytecodeValue& v) {
+        switch (v.index()) {
+            case 0: return NanBox::integer(std::get<int64_t>(v));
+            case 1: return NanBox::number(std::get<double>(v));
+            case 2: return NanBox::intern(std::get<std::string>(v));
+            default: return NanBox::boolean(std::get<bool>(v));
+        }
+    }
+    // An unset slot reads as false.
+    static BytecodeValue toBytecodeValue(const NanBox& v) {
+        if (v.isInt())    return v.asInt();
+        if (v.isDouble()) return v.asDouble();
+        if (v.isString()) return std::string(v.asString());
+        return v.isBool() && v.asBool();
+    }
+
+    // Products that may not fit 48 bits go through double, which is also
+    // where NanBox::integer would put them.
+    static NanBox multiply(int64_t a, int64_t b) {
+        double p = static_cast<double>(a) * static_cast<double>(b);
+        if (std::fabs(p) < 9.0e15) return NanBox::integer(a * b);
+        return NanBox::number(p);
+    }
+
+    // Any binary opcode on any operands, with the handlers' semantics.
+    static NanBox binary(OpCode op, const NanBox& l, const NanBox& r) {
+        switch (op) {
+            case OpCode::EQ: return NanBox::boolean(equal(l, r));
+            case OpCode::NE: return NanBox::boolean(!equal(l, r));
+            case OpCode::LT: return NanBox::boolean(compare(l, r) < 0);
+            case OpCode::LE: return NanBox::boolean(compare(l, r) <= 0);
+            case OpCode::GT: return NanBox::boolean(compare(l, r) > 0);
+            case OpCode::GE: return NanBox::boolean(compare(l, r) >= 0);
+            case OpCode::ADD:
+                if (l.isString() || r.isString()) return NanBox::concat(textValue(l), textValue(r));
+                break;
+            case OpCode::DIV:
+            case OpCode::MOD:
+                if (number(r) == 0) throw std::runtime_error("VM: division by zero");
+                break;
+            default:
+                break;
+        }
+        if (l.isInt() && r.isInt()) {
+            int64_t a = l.asInt(), b = r.asInt();
+            switch (op) {
+                case OpCode::ADD: return NanBox::integer(a + b);
+                case OpCode::SUB: return NanBox::integer(a - b);
+                case OpCode::MUL: return multiply(a, b);
+                case OpCode::DIV: return NanBox::number(double(a) / double(b));
+                default:          return NanBox::integer(a % b);
+            }
+        }
+        double a = number(l), b = number(r);
+        switch (op) {
+            case OpCode::ADD: return NanBox::number(a + b);
+            case OpCode::SUB: return NanBox::number(a - b);
+            case OpCode::MUL: return NanBox::number(a * b);
+            case OpCode::DIV: return NanBox::number(a / b);
+            default:          return NanBox::number(std::fmod(a, b));
+        }
+    }
+    static double number(const NanBox& v) {
+        if (v.isDouble()) return v.asDouble();
+        if (v.isInt())    return static_cast<double>(v.asInt());
+        if (v.isBool())   return v.asBool() ? 1.0 : 0.0;
+        throw std::runtime_error("VM: expected a number");
+    }
+    static bool truthy(const NanBox& v) {
+        if (v.isBool())   return v.asBool();
+        if (v.isInt())    return v.asInt() != 0;
+        if (v.isDouble()) return v.asDouble() != 0.0;
+        if (v.isString()) return v.length() != 0;
+        return false;
+    }
+    // Numbers, int or double, print as the walker prints them (see
+    // QuarterOutput::fixed).
+    static std::string toText(const NanBox& v) {
+        if (v.isInt() || v.isDouble()) return QuarterOutput::fixed(number(v));
+        if (v.isString()) return std::string(v.asString());
+        if (v.isBool())   return v.asBool() ? "true" : "false";
+        return "none";
+    }
+    // v as a string value: a string as it is, anything else through toText.
+    static NanBox textValue(const NanBox& v) {
+        return v.isString() ? v : NanBox::string(toText(v));
+    }
+    // toText(v) and a newline, formatted straight into this thread's output.
+    static void say(const NanBox& v) {
+        QuarterOutput& out = QuarterOutput::local();
+        if (v.isInt() || v.isDouble()) out.writeFixed(number(v));
+        else if (v.isString()) out.write(v.asString());
+        else out.write(toText(v));
+        out.endLine();
+    }
+    static bool equal(const NanBox& l, const NanBox& r) {
+        if (l.isString() || r.isString())
+            return l.isString() && r.isString() && NanBox::sameString(l, r);
+        if (l.isNone() || r.isNone()) return l.isNone() && r.isNone();
+        if (l.isInt() && r.isInt()) return l.asInt() == r.asInt();
+        return number(l) == number(r);
+    }
+    static int compare(const NanBox& l, const NanBox& r) {
+        if (l.isInt() && r.isInt()) return (l.asInt() > r.asInt()) - (l.asInt() < r.asInt());
+        if (l.isString() && r.isString()) return l.asString().compare(r.asString());
+        double a = number(l), b = number(r);
+        return (a > b) - (a < b);
+    }
+};
+
+// RegisterBytecode.h
+// Three-address form of the same programs, for RegisterVM. An instruction
+// names its registers directly (ADD r3, r1, r2), so nothing is pushed or
+// popped. A frame's registers are its resolved variable slots followed by
+// the temporaries its expressions need; the main code's variable slots are
+// the program's globals. Operands are 16 bits, so a frame has at most
+// 65536 registers and the pool at most 65536 constants; jump targets use
+// both b and c.
+#pragma once
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Bytecode.h"
+#include "QuarterLangBinder.hpp"
+
+enum class RegOp : uint8_t {
+    MOVE,           // a = b
+    LOADK,          // a = constant b
+    GETGLOBAL,      // a = global b
+    SETGLOBAL,      // global a = b
+    ADD, SUB, MUL, DIV, MOD,
+    EQ, NE, LT, LE, GT, GE,  // a = b op c
+    NEG, NOT,       // a = op b
+    SAY,            // print a
+    JUMP,           // to bc
+    JUMP_IF_FALSE,  // to bc unless a is truthy
+    CALL,           // a = function b(a, a+1, ...): the arguments start the callee's frame
+    RETURN,         // return a
+    RETURN_NONE,
+    TAIL_CALL,      // return function b(a, a+1, ...), run in this frame
+    END
+};
+
+inline const char* regOpName(RegOp op) {
+    static const char* const names[] = {
+        "MOVE", "LOADK", "GETGLOBAL", "SETGLOBAL", "ADD", "SUB", "MUL", "DIV", "MOD",
+        "EQ", "NE", "LT", "LE", "GT", "GE", "NEG", "NOT", "SAY", "JUMP", "JUMP_IF_FALSE",
+        "CALL", "RETURN", "RETURN_NONE", "TAIL_CALL", "END"
+    };
+    return static_cast<size_t>(op) < sizeof(names) / sizeof(names[0]) ? names[static_cast<size_t>(op)] : nullptr;
+}
+
+struct RegInstruction {
+    RegOp op;
+    uint16_t a = 0, b = 0, c = 0;
+
+    uint32_t target() const { return b | static_cast<uint32_t>(c) << 16; }
+};
+
+struct RegisterProgram {
+    struct Function {
+        std::string name;
+        uint32_t entry;
+        uint32_t params;     // arrive in the first registers
+        uint32_t registers;  // slots, then temporaries
+    };
+
+    std::vector<BytecodeValue> constants;
+    std::vector<std::string> variables;  // the main frame's slots, by register
+    uint32_t mainRegisters = 0;
+    std::vector<Function> functions;     // CALL's b indexes this
+    std::vector<RegInstruction> code;    // main code, END, then each function
+
+    void disassemble(std::ostream& out = std::cout) const {
+        size_t nextFn = 0;
+        for (size_t at = 0; at < code.size(); ++at) {
+            if (nextFn < functions.size() && functions[nextFn].entry == at) {
+                const Function& fn = functions[nextFn++];
+                out << "\n" << fn.name << "(" << fn.params << " param(s), " << fn.registers << " register(s)):\n";
+            }
+            const RegInstruction& i = code[at];
+            out << std::setw(6) << std::setfill('0') << at << std::setfill(' ') << "  "
+                << std::left << std::setw(14) << regOpName(i.op) << std::right;
+            switch (i.op) {
+                case RegOp::MOVE:
+                case RegOp::NEG:
+                case RegOp::NOT:       out << "r" << i.a << ", r" << i.b; break;
+                case RegOp::LOADK:     out << "r" << i.a << ", k" << i.b; break;
+                case RegOp::GETGLOBAL: out << "r" << i.a << ", g" << i.b; break;
+                case RegOp::SETGLOBAL: out << "g" << i.a << ", r" << i.b; break;
+                case RegOp::SAY:
+                case RegOp::RETURN:    out << "r" << i.a; break;
+                case RegOp::JUMP:      out << i.target(); break;
+                case RegOp::JUMP_IF_FALSE: out << "r" << i.a << ", " << i.target(); break;
+                case RegOp::CALL:
+                case RegOp::TAIL_CALL:
+                    out << "r" << i.a << ", " << (i.b < functions.size() ? functions[i.b].name : "?");
+                    break;
+                case RegOp::RETURN_NONE:
+                case RegOp::END:       break;
+                default:               out << "r" << i.a << ", r" << i.b << ", r" << i.c; break;
+            }
+            if (i.op == RegOp::LOADK && i.b < constants.size()) out << "  ; " << describe(constants[i.b]);
+            out << "\n";
+        }
+    }
+
+private:
+    static std::string describe(const BytecodeValue& v) {
+        switch (v.index()) {
+            case 0: return std::to_string(std::get<int64_t>(v));
+            case 1: {
+                std::ostringstream out;
+                out << std::get<double>(v);
+                return out.str();
+            }
+            case 2: return "\"" + std::get<std::string>(v) + "\"";
+            default: return std::get<bool>(v) ? "true" : "false";
+        }
+    }
+};
+
+// AstArena -> RegisterProgram. Same resolution and the same restrictions
+// as BytecodeCompiler (no closures). Temporaries are allocated stack-wise
+// above the frame's slots and all released at the end of each statement.
+// An expression whose result has a home (an assignment's variable, a call
+// argument's register) is computed straight into it when every operand is
+// read before the write.
+class RegisterCompiler {
+public:
+    // Throws std::runtime_error for unresolved names and for constructs the
+    // VM does not run.
+    RegisterProgram compile(const AstArena& tree, NodeId root) {
+        ast = &tree;
+        names = Resolver().resolve(tree, root);
+        program = RegisterProgram{};
+        constantIndex.clear();
+        program.variables.resize(names.frameSize[root]);
+        enterFrame(0, names.frameSize[root]);
+        compileNode(root);
+        emit(RegOp::END);
+        program.mainRegisters = highest;
+        for (const FunctionInfo& fn : names.functions) {
+            size_t index = program.functions.size();
+            program.functions.push_back({std::string(SymbolInterner::global().name(ast->symbol(fn.def))),
+                                         static_cast<uint32_t>(program.code.size()), fn.params, 0});
+            enterFrame(fn.level, fn.frameSize);
+            compileNode(fn.body);
+            emit(RegOp::RETURN_NONE);
+            program.functions[index].registers = highest;
+        }
+        return std::move(program);
+    }
+
+private:
+    static constexpr uint32_t LIMIT = UINT16_MAX + 1;
+
+    const AstArena* ast = nullptr;
+    ResolvedNames names;
+    RegisterProgram program;
+    std::map<BytecodeValue, uint32_t> constantIndex;
+    uint32_t level = 0;      // frames below the program's: 0 while compiling the main code
+    uint32_t slots = 0;      // the current frame's variable slots
+    uint32_t top = 0;        // next free temporary
+    uint32_t highest = 0;    // registers the frame needs
+
+    void enterFrame(uint32_t frameLevel, uint32_t frameSlots) {
+        level = frameLevel;
+        slots = top = highest = frameSlots;
+    }
+
+    size_t emit(RegOp op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+        program.code.push_back({op, static_cast<uint16_t>(a), static_cast<uint16_t>(b), static_cast<uint16_t>(c)});
+        return program.code.size() - 1;
+    }
+    size_t emitJump(RegOp op, uint32_t a = 0) { return emit(op, a); }
+    void patch(size_t jump, uint32_t target) {
+        program.code[jump].b = static_cast<uint16_t>(target);
+        program.code[jump].c = static_cast<uint16_t>(target >> 16);
+    }
+    void patch(size_t jump) { patch(jump, static_cast<uint32_t>(program.code.size())); }
+
+    uint32_t temp() {
+        if (top >= LIMIT) throw std::runtime_error("Register bytecode: too many registers in one frame");
+        highest = std::max(highest, top + 1);
+        return top++;
+    }
+    uint32_t constant(BytecodeValue v) {
+        auto [it, fresh] = constantIndex.try_emplace(v, static_cast<uint32_t>(program.constants.size()));
+        if (fresh) {
+            if (program.constants.size() >= LIMIT) throw std::runtime_error("Register bytecode: too many constants");
+            program.constants.push_back(std::move(v));
+        }
+        return it->second;
+    }
+
+    // Where a resolved variable lives: a register of this frame, or (inside
+    // a function) one of the program's globals.
+    struct Place {
+        bool global;
+        uint32_t index;
+    };
+    Place place(const VarSlot& v, NodeId node) {
+        if (v.depth == 0) return {false, v.slot};
+        if (v.depth == level) return {true, v.slot};
+        throw std::runtime_error("Register bytecode: '" + std::string(SymbolInterner::global().name(ast->symbol(node))) +
+                                 "' belongs to an enclosing function at line " + std::to_string(ast->line(node)) +
+                                 "; closures are not supported");
+    }
+
+    // Reads all of its operands before it writes its result.
+    bool writesLast(NodeId node) const {
+        NodeKind k = ast->kind(node);
+        if (k == NodeKind::BinaryOp) return ast->op(node) != AstOp::And && ast->op(node) != AstOp::Or;
+        return k == NodeKind::UnaryOp || k == NodeKind::Identifier || ast->isLiteral(node);
+    }
+    bool hasCall(NodeId node) const {
+        if (ast->kind(node) == NodeKind::Call) return true;
+        for (NodeId child : ast->children(node))
+            if (hasCall(child)) return true;
+        return false;
+    }
+
+    // A value read straight from a main-code variable's register, with a
+    // call still to be evaluated in `next`, is copied first: the call may
+    // assign that global.
+    uint32_t copyIfCallFollows(uint32_t value, NodeId next) {
+        if (level != 0 || value >= slots || !hasCall(next)) return value;
+        uint32_t copy = temp();
+        emit(RegOp::MOVE, copy, value);
+        return copy;
+    }
+
+    // Assigns the value of `value` to the variable at `v`.
+    void store(const VarSlot& v, NodeId node, NodeId value) {
+        Place p = place(v, node);
+        if (p.global) {
+            emit(RegOp::SETGLOBAL, p.index, compileExpr(value));
+        } else if (writesLast(value)) {
+            compileExpr(value, static_cast<int64_t>(p.index));
+        } else {
+            uint32_t r = compileExpr(value);
+            if (r != p.index) emit(RegOp::MOVE, p.index, r);
+        }
+    }
+
+    void compileNode(NodeId node) {
+        const AstArena& a = *ast;
+        top = slots;  // statements hold no temporaries across each other
+        switch (a.kind(node)) {
+            case NodeKind::Program:
+            case NodeKind::Block:
+                for (NodeId child : a.children(node)) compileNode(child);
+                break;
+            case NodeKind::Val:
+            case NodeKind::Var:
+            case NodeKind::Assign: {
+                const VarSlot& v = names.at(node);
+                if (level == 0 && v.depth == 0) program.variables[v.slot] = SymbolInterner::global().name(a.symbol(node));
+                store(v, node, a.child(node, 0));
+                break;
+            }
+            case NodeKind::Say:
+                emit(RegOp::SAY, compileExpr(a.child(node, 0)));
+                break;
+            case NodeKind::If: {
+                size_t toElse = emitJump(RegOp::JUMP_IF_FALSE, compileExpr(a.child(node, 0)));
+                compileNode(a.child(node, 1));
+                if (a.childCount(node) > 2) {
+                    size_t toEnd = emitJump(RegOp::JUMP);
+                    patch(toElse);
+                    compileNode(a.child(node, 2));
+                    patch(toEnd);
+                } else {
+                    patch(toElse);
+                }
+                break;
+            }
+            case NodeKind::While: {
+                uint32_t start = static_cast<uint32_t>(program.code.size());
+                size_t toExit = emitJump(RegOp::JUMP_IF_FALSE, compileExpr(a.child(node, 0)));
+                compileNode(a.child(node, 1));
+                patch(emitJump(RegOp::JUMP), start);
+                patch(toExit);
+                break;
+            }
+            case NodeKind::Loop: {
+                // Counter and limit are slots of this frame, never globals.
+                uint32_t counter = names.at(node).slot, limit = names.limit[node];
+                if (level == 0 && a.symbol(node) != sym::NONE)
+                    program.variables[counter] = SymbolInterner::global().name(a.symbol(node));
+                uint32_t first = copyIfCallFollows(compileExpr(a.child(node, 0)), a.child(node, 1));
+                compileExpr(a.child(node, 1), limit);  // both bounds before the counter changes
+                if (first != counter) emit(RegOp::MOVE, counter, first);
+                uint32_t start = static_cast<uint32_t>(program.code.size());
+                top = slots;
+                uint32_t test = temp();
+                emit(RegOp::LE, test, counter, limit);
+                size_t toExit = emitJump(RegOp::JUMP_IF_FALSE, test);
+                compileNode(a.child(node, 2));
+                top = slots;
+                uint32_t one = temp();
+                emit(RegOp::LOADK, one, constant(int64_t(1)));
+                emit(RegOp::ADD, counter, counter, one);
+                patch(emitJump(RegOp::JUMP), start);
+                patch(toExit);
+                break;
+            }
+            case NodeKind::FuncDef:
+                break;  // compiled after the main code, from the function table
+            case NodeKind::Call:
+                compileExpr(node);
+                break;
+            case NodeKind::Return:
+                if (a.childCount(node) == 0) emit(RegOp::RETURN_NONE);
+                else if (names.tailCall[a.child(node, 0)])
+                    emit(RegOp::TAIL_CALL, arguments(a.child(node, 0)), names.callee[a.child(node, 0)]);
+                else emit(RegOp::RETURN, compileExpr(a.child(node, 0)));
+                break;
+            case NodeKind::Thread:
+            case NodeKind::Await:
+                throw WalkerOnlyError("Register bytecode: 'thread' and 'await' need the tree walker (--vm=walk) at line " +
+                                      std::to_string(a.line(node)));
+            case NodeKind::Pipe:
+                throw WalkerOnlyError("Register bytecode: 'pipe' needs the tree walker (--vm=walk) at line " +
+                                      std::to_string(a.line(node)));
+            default:
+                throw std::runtime_error("Register bytecode: unsupported statement at line " + std::to_string(a.line(node)));
+        }
+    }
+
+    // A call's arguments go to consecutive registers at the top of the
+    // frame; the callee's frame starts at the first, which is returned.
+    uint32_t arguments(NodeId call) {
+        uint32_t base = top;
+        for (NodeId arg : ast->children(call)) {
+            uint32_t slot = temp();
+            compileExpr(arg, slot);
+            top = slot + 1;
+        }
+        return base;
+    }
+
+    // Returns the register holding the value: `dest` if one is given (>= 0),
+    // otherwise a variable's own register or a fresh temporary.
+    uint32_t compileExpr(NodeId node, int64_t dest = -1) {
+        const AstArena& a = *ast;
+        uint32_t mark = top;
+        auto result = [&] { return dest >= 0 ? static_cast<uint32_t>(dest) : temp(); };
+        switch (a.kind(node)) {
+            case NodeKind::IntLiteral:    { uint32_t r = result(); emit(RegOp::LOADK, r, constant(a.intValue(node))); return r; }
+            case NodeKind::FloatLiteral:  { uint32_t r = result(); emit(RegOp::LOADK, r, constant(a.floatValue(node))); return r; }
+            case NodeKind::StringLiteral: { uint32_t r = result(); emit(RegOp::LOADK, r, constant(std::string(a.text(node)))); return r; }
+            case NodeKind::BoolLiteral:   { uint32_t r = result(); emit(RegOp::LOADK, r, constant(a.boolValue(node))); return r; }
+            case NodeKind::Identifier: {
+                Place p = place(names.at(node), node);
+                if (p.global) {
+                    uint32_t r = result();
+                    emit(RegOp::GETGLOBAL, r, p.index);
+                    return r;
+                }
+                if (dest < 0 || dest == p.index) return p.index;
+                emit(RegOp::MOVE, static_cast<uint32_t>(dest), p.index);
+                return static_cast<uint32_t>(dest);
+            }
+            case NodeKind::Call: {
+                if (names.builtin[node] != Builtin::None)
+                    throw WalkerOnlyError("Register bytecode: '" + std::string(builtinInfo(names.builtin[node]).name) +
+                                          "' needs the tree walker (--vm=walk) at line " + std::to_string(a.line(node)));
+                uint32_t base = arguments(node);
+                top = base;
+                emit(RegOp::CALL, temp(), names.callee[node]);
+                if (dest >= 0 && dest != base) emit(RegOp::MOVE, static_cast<uint32_t>(dest), base);
+                return dest >= 0 ? static_cast<uint32_t>(dest) : base;
+            }
+            case NodeKind::UnaryOp: {
+                uint32_t operand = compileExpr(a.child(node, 0));
+                top = mark;
+                uint32_t r = result();
+                emit(a.op(node) == AstOp::Not ? RegOp::NOT : RegOp::NEG, r, operand);
+                return r;
+            }
+            case NodeKind::BinaryOp:
+                return compileBinary(node, dest);
+            case NodeKind::Interpolate: {
+                // "" + part + part ...: ADD concatenates once either side is text
+                uint32_t r = temp();
+                emit(RegOp::LOADK, r, constant(std::string()));
+                for (NodeId part : a.children(node)) {
+                    emit(RegOp::ADD, r, r, compileExpr(part));
+                    top = r + 1;
+                }
+                if (dest >= 0) {
+                    emit(RegOp::MOVE, static_cast<uint32_t>(dest), r);
+                    return static_cast<uint32_t>(dest);
+                }
+                return r;
+            }
+            default:
+                throw std::runtime_error("Register bytecode: unsupported expression at line " + std::to_string(a.line(node)));
+        }
+    }
+
+    uint32_t compileBinary(NodeId node, int64_t dest) {
+        const AstArena& a = *ast;
+        AstOp op = a.op(node);
+        uint32_t mark = top;
+        if (op == AstOp::And || op == AstOp::Or) {
+            // Short-circuit into a temporary; the result is always a bool.
+            uint32_t r = temp();
+            compileExpr(a.child(node, 0), r);
+            size_t shortCut = emitJump(RegOp::JUMP_IF_FALSE, r);
+            size_t toEnd;
+            if (op == AstOp::Or) {
+                emit(RegOp::LOADK, r, constant(true));  // left was truthy
+                toEnd = emitJump(RegOp::JUMP);
+                patch(shortCut);
+                compileExpr(a.child(node, 1), r);
+                emit(RegOp::NOT, r, r);
+                emit(RegOp::NOT, r, r);
+            } else {
+                compileExpr(a.child(node, 1), r);
+                emit(RegOp::NOT, r, r);
+                emit(RegOp::NOT, r, r);
+                toEnd = emitJump(RegOp::JUMP);
+                patch(shortCut);
+                emit(RegOp::LOADK, r, constant(false));  // left was falsy
+            }
+            patch(toEnd);
+            if (dest >= 0) {
+                emit(RegOp::MOVE, static_cast<uint32_t>(dest), r);
+                return static_cast<uint32_t>(dest);
+            }
+            return r;
+        }
+        uint32_t lhs = copyIfCallFollows(compileExpr(a.child(node, 0)), a.child(node, 1));
+        uint32_t rhs = compileExpr(a.child(node, 1));
+        top = mark;
+        uint32_t r = dest >= 0 ? static_cast<uint32_t>(dest) : temp();
+        static const RegOp lowered[] = {
+            RegOp::ADD, RegOp::SUB, RegOp::MUL, RegOp::DIV, RegOp::MOD,
+            RegOp::EQ, RegOp::NE, RegOp::LT, RegOp::LE, RegOp::GT, RegOp::GE
+        };
+        emit(lowered[static_cast<size_t>(op)], r, lhs, rhs);
+        return r;
+    }
+};
+
+// RegisterVM.h
+// Interpreter for RegisterProgram. A frame is a window of one register
+// file: a call's frame starts at the register holding its first argument,
+// and the result comes back in that register; a tail call's callee takes
+// over its caller's window instead. The main frame sits at the bottom and
+// its slots are the globals. Values and errors are the stack
+// VM's (VM's value helpers are shared); there is no JIT for this form.
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "NanBox.h"
+#include "RegisterBytecode.h"
+#include "VM.h"
+
+class RegisterVM {
+public:
+    static constexpr size_t REGISTERS = 1 << 16;     // shared by every frame
+    static constexpr size_t MAX_CALL_DEPTH = VM::MAX_CALL_DEPTH;
+
+    RegisterVM() : registers(REGISTERS) {}
+
+    void run(const RegisterProgram& program) {
+        load(program);
+        try {
+            execute();
+        } catch (...) {
+            for (NanBox& v : registers) v = NanBox();
+            frames.clear();
+            QuarterOutput::local().flush();
+            throw;
+        }
+        QuarterOutput::local().flush();
+    }
 
-// === IR Instruction Structure === //
-struct Instruction {
-    OpCode op;
-    std::vector<int> int_args;      // For integer operands (e.g., value index, var index, jump address)
-    std::vector<QValue> data_args;  // For literal constants (if needed)
+    // Value of a global after run(), in the bytecode value type.
+    BytecodeValue variable(size_t slot) const { return VM::toBytecodeValue(globals[slot]); }
 
-    Instruction(OpCode op_) : op(op_) {}
-    Instruction(OpCode op_, int arg) : op(op_), int_args{arg} {}
-    Instruction(OpCode op_, QValue val) : op(op_), data_args{val} {}
-    Instruction(OpCode op_, int arg, QValue val) : op(op_), int_args{arg}, data_args{val} {}
-};
+private:
+    struct CallFrame {
+        const RegInstruction* ret;
+        NanBox* base;
+    };
 
-// === Quarter Bytecode Program === //
-struct BytecodeProgram {
-    std::vector<QValue> constants;          // Pool of constants
-    std::vector<std::string> variables;     // Variable names table (for mapping indices)
-    std::vector<Instruction> instructions;  // The IR/bytecode stream
+    std::vector<NanBox> registers;
+    std::vector<NanBox> pool;
+    std::vector<NanBox> globals;  // copied out of the main frame at END
+    std::vector<CallFrame> frames;
+    const RegisterProgram* program = nullptr;
+
+    void execute() {
+        const RegisterProgram& p = *program;
+        const RegInstruction* code = p.code.data();
+        const RegInstruction* ip = code;
+        const NanBox* k = pool.data();
+        NanBox* const g = registers.data();  // the main frame
+        NanBox* r = g;
+        NanBox* const end = registers.data() + REGISTERS;
+
+#ifdef QTR_COMPUTED_GOTO
+        static void* const jump[] = {
+            &&op_MOVE, &&op_LOADK, &&op_GETGLOBAL, &&op_SETGLOBAL,
+            &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_MOD,
+            &&op_EQ, &&op_NE, &&op_LT, &&op_LE, &&op_GT, &&op_GE,
+            &&op_NEG, &&op_NOT, &&op_SAY, &&op_JUMP, &&op_JUMP_IF_FALSE,
+            &&op_CALL, &&op_RETURN, &&op_RETURN_NONE, &&op_TAIL_CALL, &&op_END
+        };
+#define REG_CASE(name) op_##name
+#define REG_NEXT() goto *jump[static_cast<size_t>(ip->op)]
+        REG_NEXT();
+#else
+#define REG_CASE(name) case RegOp::name
+#define REG_NEXT() break
+        for (;;) {
+        switch (ip->op) {
+#endif
+
+// Both operands ints: integer result. Otherwise VM::binary decides.
+#define REG_ARITH(name, int_expr)                                            \
+        REG_CASE(name): {                                                    \
+            const NanBox& x = r[ip->b];                                      \
+            const NanBox& y = r[ip->c];                                      \
+            if (x.isInt() && y.isInt()) {                                    \
+                int64_t a = x.asInt(), b = y.asInt();                        \
+                r[ip->a] = (int_expr);                                       \
+            } else {                                                         \
+                r[ip->a] = VM::binary(OpCode::name, x, y);                   \
+            }                                                                \
+            ++ip;                                                            \
+            REG_NEXT();                                                      \
+        }
+#define REG_ORDER(name, cmp)                                                 \
+        REG_CASE(name): {                                                    \
+            const NanBox& x = r[ip->b];                                      \
+            const NanBox& y = r[ip->c];                                      \
+            r[ip->a] = NanBox::boolean(x.isInt() && y.isInt() ? x.asInt() cmp y.asInt() \
+                                                              : VM::compare(x, y) cmp 0); \
+            ++ip;                                                            \
+            REG_NEXT();                                                      \
+        }
 
-    void emit(const Instruction& instr) {
-        instructions.push_back(instr);
-    }
-    void dump() const {
-        for (size_t i = 0; i < instructions.size(); ++i) {
-            std::cout << i << ": ";
-            const auto& instr = instructions[i];
-            std::cout << static_cast<int>(instr.op);
-            for (int arg : instr.int_args) std::cout << " " << arg;
-            for (const auto& val : instr.data_args) {
-                std::visit([](auto&& v) { std::cout << " [" << v << "]"; }, val);
+        REG_CASE(MOVE):
+            r[ip->a] = r[ip->b];
+            ++ip;
+            REG_NEXT();
+        REG_CASE(LOADK):
+            r[ip->a] = k[ip->b];
+            ++ip;
+            REG_NEXT();
+        REG_CASE(GETGLOBAL):
+            r[ip->a] = g[ip->b];
+            ++ip;
+            REG_NEXT();
+        REG_CASE(SETGLOBAL):
+            g[ip->a] = r[ip->b];
+            ++ip;
+            REG_NEXT();
+        REG_CASE(ADD): {
+            const NanBox& x = r[ip->b];
+            const NanBox& y = r[ip->c];
+            r[ip->a] = x.isInt() && y.isInt() ? NanBox::integer(x.asInt() + y.asInt()) : VM::binary(OpCode::ADD, x, y);
+            ++ip;
+            REG_NEXT();
+        }
+        REG_ARITH(SUB, NanBox::integer(a - b))
+        REG_ARITH(MUL, VM::multiply(a, b))
+        REG_CASE(DIV):
+            r[ip->a] = VM::binary(OpCode::DIV, r[ip->b], r[ip->c]);  // always a double: see VM::binary
+            ++ip;
+            REG_NEXT();
+        REG_ARITH(MOD, b ? NanBox::integer(a % b) : VM::binary(OpCode::MOD, x, y))
+        REG_CASE(EQ):
+            r[ip->a] = NanBox::boolean(VM::equal(r[ip->b], r[ip->c]));
+            ++ip;
+            REG_NEXT();
+        REG_CASE(NE):
+            r[ip->a] = NanBox::boolean(!VM::equal(r[ip->b], r[ip->c]));
+            ++ip;
+            REG_NEXT();
+        REG_ORDER(LT, <)
+        REG_ORDER(LE, <=)
+        REG_ORDER(GT, >)
+        REG_ORDER(GE, >=)
+        REG_CASE(NEG): {
+            const NanBox& x = r[ip->b];
+            r[ip->a] = x.isInt() ? NanBox::integer(-x.asInt()) : NanBox::number(-VM::number(x));
+            ++ip;
+            REG_NEXT();
+        }
+        REG_CASE(NOT):
+            r[ip->a] = NanBox::boolean(!VM::truthy(r[ip->b]));
+            ++ip;
+            REG_NEXT();
+        REG_CASE(SAY):
+            VM::say(r[ip->a]);
+            ++ip;
+            REG_NEXT();
+        REG_CASE(JUMP):
+            ip = code + ip->target();
+            REG_NEXT();
+        REG_CASE(JUMP_IF_FALSE):
+            ip = VM::truthy(r[ip->a]) ? ip + 1 : code + ip->target();
+            REG_NEXT();
+        REG_CASE(CALL): {
+            const RegisterProgram::Function& f = p.functions[ip->b];
+            NanBox* callee = r + ip->a;
+            if (frames.size() >= MAX_CALL_DEPTH) throw std::runtime_error("VM: call depth limit exceeded");
+            if (static_cast<size_t>(end - callee) < f.registers) throw std::runtime_error("VM: register stack overflow");
+            // Registers past the arguments may hold the caller's old temporaries.
+            std::fill(callee + f.params, callee + f.registers, NanBox());
+            frames.push_back({ip + 1, r});
+            r = callee;
+            ip = code + f.entry;
+            REG_NEXT();
+        }
+        REG_CASE(TAIL_CALL): {
+            // The callee takes over this frame: no frame is pushed.
+            const RegisterProgram::Function& f = p.functions[ip->b];
+            if (static_cast<size_t>(end - r) < f.registers) throw std::runtime_error("VM: register stack overflow");
+            std::move(r + ip->a, r + ip->a + f.params, r);
+            std::fill(r + f.params, r + f.registers, NanBox());
+            ip = code + f.entry;
+            REG_NEXT();
+        }
+        REG_CASE(RETURN_NONE):
+            *r = NanBox();
+            goto do_return;
+        REG_CASE(RETURN):
+            if (ip->a) *r = r[ip->a];
+        do_return:
+            ip = frames.back().ret;
+            r = frames.back().base;
+            frames.pop_back();
+            REG_NEXT();
+        REG_CASE(END):
+            globals.assign(g, g + p.variables.size());
+            return;
+#ifndef QTR_COMPUTED_GOTO
+        }
+        }
+#endif
+#undef REG_ARITH
+#undef REG_ORDER
+#undef REG_CASE
+#undef REG_NEXT
+    }
+
+    // Checks every operand against its frame and every jump against its
+    // region, so execute() need not.
+    void load(const RegisterProgram& p) {
+        program = &p;
+        frames.clear();
+        pool.clear();
+        for (const BytecodeValue& c : p.constants) pool.push_back(VM::fromBytecodeValue(c));
+        if (p.mainRegisters > REGISTERS || p.variables.size() > p.mainRegisters)
+            throw std::runtime_error("VM: register stack overflow");
+        size_t mainEnd = p.functions.empty() ? p.code.size() : p.functions[0].entry;
+        verify(p, 0, mainEnd, p.mainRegisters, false);
+        for (size_t i = 0; i < p.functions.size(); ++i) {
+            const RegisterProgram::Function& f = p.functions[i];
+            size_t end = i + 1 < p.functions.size() ? p.functions[i + 1].entry : p.code.size();
+            if (f.entry >= end || f.params > f.registers || f.registers > REGISTERS)
+                throw std::runtime_error("VM: bad function table entry for '" + f.name + "'");
+            verify(p, f.entry, end, f.registers, true);
+        }
+        std::fill(registers.begin(), registers.begin() + p.mainRegisters, NanBox());
+        globals.clear();
+    }
+
+    static void verify(const RegisterProgram& p, size_t begin, size_t end, uint32_t regs, bool inFunction) {
+        auto fail = [](size_t at, const std::string& what) {
+            throw std::runtime_error("VM: " + what + " at " + std::to_string(at));
+        };
+        for (size_t at = begin; at < end; ++at) {
+            const RegInstruction& i = p.code[at];
+            auto reg = [&](uint32_t n) { if (n >= regs) fail(at, "register out of range"); };
+            switch (i.op) {
+                case RegOp::MOVE:
+                case RegOp::NEG:
+                case RegOp::NOT:
+                    reg(i.a); reg(i.b);
+                    break;
+                case RegOp::LOADK:
+                    reg(i.a);
+                    if (i.b >= p.constants.size()) fail(at, "constant out of range");
+                    break;
+                case RegOp::GETGLOBAL:
+                case RegOp::SETGLOBAL:
+                    reg(i.op == RegOp::GETGLOBAL ? i.a : i.b);
+                    if ((i.op == RegOp::GETGLOBAL ? i.b : i.a) >= p.variables.size()) fail(at, "variable out of range");
+                    break;
+                case RegOp::SAY:
+                case RegOp::RETURN:
+                    reg(i.a);
+                    if (i.op == RegOp::RETURN && !inFunction) fail(at, "return outside a function");
+                    break;
+                case RegOp::JUMP:
+                case RegOp::JUMP_IF_FALSE:
+                    if (i.op == RegOp::JUMP_IF_FALSE) reg(i.a);
+                    if (i.target() < begin || i.target() >= end) fail(at, "jump out of its function");
+                    break;
+                case RegOp::CALL:
+                case RegOp::TAIL_CALL:
+                    if (i.op == RegOp::TAIL_CALL && !inFunction) fail(at, "return outside a function");
+                    if (i.b >= p.functions.size()) fail(at, "function out of range");
+                    reg(i.a);
+                    if (i.a + p.functions[i.b].params > regs) fail(at, "arguments out of range");
+                    break;
+                case RegOp::RETURN_NONE:
+                    if (!inFunction) fail(at, "return outside a function");
+                    break;
+                case RegOp::END:
+                    if (inFunction) fail(at, "END inside a function");
+                    break;
+                default:
+                    if (!regOpName(i.op)) fail(at, "bad opcode");
+                    reg(i.a); reg(i.b); reg(i.c);
+                    break;
             }
-            std::cout << "\n";
         }
+        RegOp last = end > begin ? p.code[end - 1].op : RegOp::MOVE;
+        if (last != RegOp::JUMP && last != RegOp::RETURN && last != RegOp::RETURN_NONE && last != RegOp::TAIL_CALL &&
+            last != RegOp::END)
+            fail(end, inFunction ? "function does not end in a return" : "program does not end with END");
     }
 };
 
@@ -2439,302 +6552,1195 @@ struct Program : public ASTNode {
     Program(std::vector<StmtPtr> s) : statements(std::move(s)) {}
 };
 
+// === QuarterLang Symbol Interner ===
+// One global table of identifier/keyword spellings. Every spelling is stored
+// once and handed out as a small integer SymbolId, so the Lexer, Parser,
+// Binder and Indexter compare integers instead of strings.
+
+// SymbolInterner.h
 #pragma once
-#include <string>
-#include <vector>
+#include <cstdint>
+#include <cstring>
 #include <memory>
-#include <iostream>
-#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
-#include "lexer.h"  // Assumes you have a lexer/token system
+#include <vector>
 
-// --- Token Type Alias for Convenience ---
-using TokenList = std::vector<Token>;
+using SymbolId = uint32_t;
+
+// Well-known symbols, pre-interned in this order so their ids are constants
+// the parser can switch on. Whether a spelling is a keyword is decided by the
+// shared QuarterKeywords table, not by this list.
+namespace sym {
+enum : SymbolId {
+    NONE = 0,
+    STAR, END, VAL, VAR, SAY, LOOP, IF, ELSE, WHILE, MATCH, CASE,
+    BREAK, CONTINUE, RETURN, FUNC, DEFINE,
+    ASSIGN,             // =
+    TRUE, FALSE, AND, OR, NOT,
+    ADD, SUB, MUL, DIV, MOD,        // + - * / %
+    EQ, NE, LT, LE, GT, GE,         // == != < <= > >=
+    AND_AND, OR_OR, BANG,           // && || !
+    LPAREN, RPAREN, COMMA, COLON,   // ( ) , :
+    WELL_KNOWN_COUNT
+};
+} // namespace sym
+
+class SymbolInterner {
+public:
+    static SymbolInterner& global() {
+        static SymbolInterner instance;
+        return instance;
+    }
 
-// === AST Node Types ===
-enum class NodeKind {
-    BLOCK,        // star ... end
-    VAL,          // val name = expr
-    VAR,          // var name = expr
-    SAY,          // say expr
-    NUMBER,       // literal
-    STRING,       // literal
-    IDENTIFIER,   // variable usage
-    ASSIGN,       // name = expr
-    IF,           // if ... then ... else ... end
-    LOOP,         // loop ... end
-    MATCH,        // match ... case ... end
-    CALL,         // function call
-    UNKNOWN
-};
-
-// === AST Base ===
-struct ASTNode {
-    NodeKind kind;
-    int line;
-    virtual ~ASTNode() = default;
-};
-using AST = std::shared_ptr<ASTNode>;
+    // Returns the id for `text`, interning it on first sight.
+    SymbolId intern(std::string_view text) {
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+        std::string_view stored = store(text);
+        SymbolId id = static_cast<SymbolId>(names.size());
+        names.push_back(stored);
+        ids.emplace(stored, id);
+        return id;
+    }
 
-// === Specific AST Nodes ===
-struct BlockNode : ASTNode {
-    std::vector<AST> statements;
-    BlockNode(int l) { kind = NodeKind::BLOCK; line = l; }
-};
-struct ValNode : ASTNode {
-    std::string name;
-    AST value;
-    ValNode(const std::string& n, AST v, int l) : name(n), value(v) {
-        kind = NodeKind::VAL; line = l;
+    // Returns the id for `text` or sym::NONE if it was never interned.
+    SymbolId lookup(std::string_view text) const {
+        auto it = ids.find(text);
+        return it != ids.end() ? it->second : sym::NONE;
     }
-};
-struct VarNode : ASTNode {
-    std::string name;
-    AST value;
-    VarNode(const std::string& n, AST v, int l) : name(n), value(v) {
-        kind = NodeKind::VAR; line = l;
+
+    std::string_view name(SymbolId id) const {
+        return id < names.size() ? names[id] : std::string_view{};
+    }
+
+    size_t size() const { return names.size(); }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;   // stable backing storage
+    size_t blockUsed = BLOCK_SIZE;
+    std::vector<std::string_view> names;           // id -> spelling
+    std::unordered_map<std::string_view, SymbolId> ids;
+
+    SymbolInterner() {
+        static const char* const wellKnown[] = {
+            "", "star", "end", "val", "var", "say", "loop", "if", "else", "while",
+            "match", "case", "break", "continue", "return", "func", "define", "=",
+            "true", "false", "and", "or", "not",
+            "+", "-", "*", "/", "%",
+            "==", "!=", "<", "<=", ">", ">=",
+            "&&", "||", "!",
+            "(", ")", ",", ":"
+        };
+        static_assert(sizeof(wellKnown) / sizeof(wellKnown[0]) == sym::WELL_KNOWN_COUNT,
+                      "well-known symbol table out of sync with sym::");
+        names.push_back(std::string_view{});
+        for (size_t i = 1; i < sym::WELL_KNOWN_COUNT; ++i) intern(wellKnown[i]);
+    }
+
+    // Copies `text` into the arena; spellings never move once stored.
+    std::string_view store(std::string_view text) {
+        if (text.size() > BLOCK_SIZE) {
+            blocks.emplace_back(new char[text.size()]);
+            std::memcpy(blocks.back().get(), text.data(), text.size());
+            blockUsed = BLOCK_SIZE; // oversized block is private; next store opens a fresh one
+            return {blocks.back().get(), text.size()};
+        }
+        if (blockUsed + text.size() > BLOCK_SIZE) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            blockUsed = 0;
+        }
+        char* dst = blocks.back().get() + blockUsed;
+        std::memcpy(dst, text.data(), text.size());
+        blockUsed += text.size();
+        return {dst, text.size()};
     }
 };
-struct SayNode : ASTNode {
-    AST value;
-    SayNode(AST v, int l) : value(v) { kind = NodeKind::SAY; line = l; }
-};
-struct NumberNode : ASTNode {
-    std::string value;
-    NumberNode(const std::string& v, int l) : value(v) { kind = NodeKind::NUMBER; line = l; }
-};
-struct StringNode : ASTNode {
-    std::string value;
-    StringNode(const std::string& v, int l) : value(v) { kind = NodeKind::STRING; line = l; }
-};
-struct IdentifierNode : ASTNode {
-    std::string name;
-    IdentifierNode(const std::string& n, int l) : name(n) { kind = NodeKind::IDENTIFIER; line = l; }
+
+// === QuarterLang AST Arena ===
+// The one AST shared by the Parser, QuarterOptimizer, QuarterCodeGen and
+// QuarterRuntime. Nodes are rows in flat arrays addressed by NodeId: kinds
+// sit in their own byte array, every node's children are one contiguous run
+// of ids, and names are SymbolIds. Building a node is an append; dropping
+// the arena frees the whole tree at once.
+
+// AstArena.h
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SymbolInterner.h"
+
+using NodeId = uint32_t;
+constexpr NodeId NO_NODE = UINT32_MAX;
+
+enum class NodeKind : uint8_t {
+    Program,
+    Block,          // star ... end              children: statements
+    Val,            // val name = expr           symbol, children: [expr]
+    Var,            // var name = expr           symbol, children: [expr]
+    Assign,         // name = expr               symbol, children: [expr]
+    Say,            // say expr                  children: [expr]
+    Ask,            // ask name                  symbol
+    If,             // children: [cond, then, else?]
+    While,          // children: [cond, body]
+    Loop,           // loop [name] from a to b   symbol (sym::NONE if unnamed), children: [from, to, body]
+    FuncDef,        // symbol, children: [params (Identifier)..., body]
+    Call,           // symbol, children: args
+    Return,         // children: [expr?]
+    Thread,         // thread f(args)            children: [Call]
+    Await,          // await: joins the threads its frame started
+    Pipe,           // pipe write|append: file   symbol (write or append), children: [file]
+    BinaryOp,       // op, children: [lhs, rhs]
+    UnaryOp,        // op, children: [operand]
+    Interpolate,    // "a {x} b"                 children: text pieces and exprs, in order
+    IntLiteral,
+    FloatLiteral,
+    StringLiteral,  // text views the source buffer or the arena's owned text
+    BoolLiteral,
+    Identifier      // symbol
+};
+
+enum class AstOp : uint8_t {
+    Add, Sub, Mul, Div, Mod,
+    Eq, Ne, Lt, Le, Gt, Ge,
+    And, Or, Not, Neg
 };
-struct AssignNode : ASTNode {
-    std::string name;
-    AST value;
-    AssignNode(const std::string& n, AST v, int l) : name(n), value(v) { kind = NodeKind::ASSIGN; line = l; }
+
+constexpr std::string_view opSpelling(AstOp op) {
+    constexpr std::string_view spellings[] = {
+        "+", "-", "*", "/", "%", "==", "!=", "<", "<=", ">", ">=", "and", "or", "not", "-"
+    };
+    return spellings[static_cast<size_t>(op)];
+}
+
+class AstArena {
+public:
+    // Children of one node. Holds indices rather than pointers, so it stays
+    // valid while new nodes are appended.
+    class Children {
+    public:
+        Children(const AstArena& a, uint32_t first, uint32_t count) : arena(a), first(first), count(count) {}
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        NodeId operator[](size_t i) const { return arena.links[first + i]; }
+
+        struct iterator {
+            const AstArena* arena;
+            size_t at;
+            NodeId operator*() const { return arena->links[at]; }
+            iterator& operator++() { ++at; return *this; }
+            bool operator!=(const iterator& o) const { return at != o.at; }
+        };
+        iterator begin() const { return {&arena, first}; }
+        iterator end() const { return {&arena, size_t(first) + count}; }
+
+    private:
+        const AstArena& arena;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    NodeId root = NO_NODE;
+
+    void reserve(size_t nodes) {
+        kinds.reserve(nodes);
+        rows.reserve(nodes);
+        links.reserve(nodes);
+    }
+
+    // Drops every node; capacity is kept for the next parse.
+    void clear() {
+        kinds.clear();
+        rows.clear();
+        links.clear();
+        owned.clear();
+        root = NO_NODE;
+    }
+
+    size_t size() const { return kinds.size(); }
+
+    // --- Building ---
+    NodeId add(NodeKind k, int line, std::initializer_list<NodeId> kids = {}) {
+        return append(k, line, kids.begin(), kids.size());
+    }
+    NodeId add(NodeKind k, int line, const std::vector<NodeId>& kids) {
+        return append(k, line, kids.data(), kids.size());
+    }
+    NodeId named(NodeKind k, SymbolId name, int line, std::initializer_list<NodeId> kids = {}) {
+        NodeId id = add(k, line, kids);
+        rows[id].data.sym = name;
+        return id;
+    }
+    NodeId named(NodeKind k, SymbolId name, int line, const std::vector<NodeId>& kids) {
+        NodeId id = add(k, line, kids);
+        rows[id].data.sym = name;
+        return id;
+    }
+    NodeId binary(AstOp op, NodeId lhs, NodeId rhs, int line) {
+        NodeId id = add(NodeKind::BinaryOp, line, {lhs, rhs});
+        rows[id].data.op = op;
+        return id;
+    }
+    NodeId unary(AstOp op, NodeId operand, int line) {
+        NodeId id = add(NodeKind::UnaryOp, line, {operand});
+        rows[id].data.op = op;
+        return id;
+    }
+    NodeId intLiteral(int64_t v, int line) {
+        NodeId id = add(NodeKind::IntLiteral, line);
+        rows[id].data.i = v;
+        return id;
+    }
+    NodeId floatLiteral(double v, int line) {
+        NodeId id = add(NodeKind::FloatLiteral, line);
+        rows[id].data.f = v;
+        return id;
+    }
+    NodeId boolLiteral(bool v, int line) {
+        NodeId id = add(NodeKind::BoolLiteral, line);
+        rows[id].data.i = v ? 1 : 0;
+        return id;
+    }
+    // `text` must outlive the arena (source buffer, or text from keep()).
+    NodeId stringLiteral(std::string_view text, int line) {
+        NodeId id = add(NodeKind::StringLiteral, line);
+        rows[id].data.text = {text.data(), static_cast<uint32_t>(text.size())};
+        return id;
+    }
+    // Takes ownership of text with no home in the source (decoded escapes);
+    // the view stays valid until clear().
+    std::string_view keep(std::string text) {
+        owned.push_back(std::move(text));
+        return owned.back();
+    }
+
+    // --- Reading ---
+    NodeKind kind(NodeId id) const { return kinds[id]; }
+    int line(NodeId id) const { return rows[id].line; }
+    Children children(NodeId id) const { return {*this, rows[id].firstChild, rows[id].childCount}; }
+    size_t childCount(NodeId id) const { return rows[id].childCount; }
+    NodeId child(NodeId id, size_t i) const { return links[rows[id].firstChild + i]; }
+    SymbolId symbol(NodeId id) const { return rows[id].data.sym; }
+    AstOp op(NodeId id) const { return rows[id].data.op; }
+    int64_t intValue(NodeId id) const { return rows[id].data.i; }
+    double floatValue(NodeId id) const { return rows[id].data.f; }
+    bool boolValue(NodeId id) const { return rows[id].data.i != 0; }
+    std::string_view text(NodeId id) const { return {rows[id].data.text.ptr, rows[id].data.text.len}; }
+
+    bool isLiteral(NodeId id) const {
+        NodeKind k = kinds[id];
+        return k == NodeKind::IntLiteral || k == NodeKind::FloatLiteral ||
+               k == NodeKind::StringLiteral || k == NodeKind::BoolLiteral;
+    }
+
+private:
+    // Which member is live depends on the node kind.
+    union Payload {
+        int64_t i;
+        double f;
+        SymbolId sym;
+        AstOp op;
+        struct { const char* ptr; uint32_t len; } text;
+    };
+    struct Row {
+        uint32_t firstChild;
+        uint32_t childCount;
+        int32_t line;
+        Payload data;
+    };
+
+    std::vector<NodeKind> kinds;  // tag array, one byte per node
+    std::vector<Row> rows;
+    std::vector<NodeId> links;    // children runs, back to back
+    std::deque<std::string> owned; // keep() text; deque so views never move
+
+    NodeId append(NodeKind k, int line, const NodeId* kids, size_t count) {
+        NodeId id = static_cast<NodeId>(kinds.size());
+        kinds.push_back(k);
+        Row row{static_cast<uint32_t>(links.size()), static_cast<uint32_t>(count), line, {}};
+        row.data.i = 0;
+        rows.push_back(row);
+        links.insert(links.end(), kids, kids + count);
+        return id;
+    }
 };
 
-// You can expand for IF, LOOP, MATCH, CALL, etc.
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <array>
+#include <charconv>
+#include <system_error>
+#include "lexer.h"  // Assumes you have a lexer/token system
+#include "SymbolInterner.h"
+#include "AstArena.h"
+#include "ErrorHandler.h"
 
+// --- Token Type Alias for Convenience ---
+using TokenList = std::vector<Token>;
 
 // === Parser ===
+// Builds straight into an AstArena. Names are interned SymbolIds; string
+// literal text is a view into the source buffer (or into arena-owned text for
+// strings that needed escape decoding).
+//
+// Syntax errors are reported to an ErrorHandler as ERROR, the broken statement
+// is dropped, and parsing resumes at the next statement boundary, so a single
+// pass reports every error. Without a handler, parse() throws one
+// std::runtime_error listing all of them.
 class Parser {
     const TokenList& tokens;
+    AstArena& ast;
     size_t pos;
+    size_t statementStart = 0;
+    ErrorHandler ownErrors;
+    ErrorHandler* errors;
+    std::string filename;
+
+    struct ParseError {};  // unwinds to the statement loop
 
-    Token peek(int ahead = 0) const {
+    const Token& peek(int ahead = 0) const {
         if (pos + ahead < tokens.size()) return tokens[pos + ahead];
         return tokens.back(); // EOF token
     }
-    Token consume() { return tokens[pos++]; }
-    bool match(const std::string& val) {
-        if (peek().value == val) { consume(); return true; }
+    // Never steps past EOF, so recovery can always call it.
+    const Token& consume() {
+        const Token& t = peek();
+        if (t.type != TokenType::END_OF_FILE) ++pos;
+        return t;
+    }
+    bool match(SymbolId s) {
+        if (peek().sym == s) { consume(); return true; }
         return false;
     }
-    void expect(const std::string& val) {
-        if (peek().value != val) throw std::runtime_error(
-            "Expected '" + val + "' at line " + std::to_string(peek().line));
+    void expect(SymbolId s) {
+        if (peek().sym != s)
+            throw error(peek(), "Expected '" + std::string(SymbolInterner::global().name(s)) + "'");
         consume();
     }
 
+    // Records the error and returns the exception to throw. A statement that
+    // fails on the first token of the next line is reported against the line
+    // that ran out.
+    ParseError error(const Token& at, const std::string& message) {
+        int line = at.line;
+        std::string where = "'" + std::string(at.value) + "'";
+        if (at.type == TokenType::END_OF_FILE) {
+            where = "end of input";
+        } else if (pos > statementStart && &at == &peek() && tokens[pos - 1].line < at.line) {
+            line = tokens[pos - 1].line;
+            where = "end of line";
+        }
+        errors->report(ErrorLevel::ERROR, message + " (found " + where + ")", filename, line);
+        return ParseError{};
+    }
+
+    // Panic mode: skip to the first token of a later line, `end`, `define` or `func`.
+    // The lexer keeps no newline tokens, so line numbers mark the boundaries.
+    void synchronize() {
+        if (pos == statementStart) consume();  // always make progress
+        int errorLine = tokens[pos - 1].line;
+        while (peek().type != TokenType::END_OF_FILE) {
+            const Token& t = peek();
+            if (t.line > errorLine || t.sym == sym::END || t.sym == sym::DEFINE || t.sym == sym::FUNC) return;
+            consume();
+        }
+    }
+
 public:
-    Parser(const TokenList& toks) : tokens(toks), pos(0) {}
+    Parser(const TokenList& toks, AstArena& arena, ErrorHandler* diagnostics = nullptr, std::string file = "")
+        : tokens(toks), ast(arena), pos(0), errors(diagnostics ? diagnostics : &ownErrors), filename(std::move(file)) {
+        ownErrors.setVerbose(false);
+        ast.reserve(toks.size());
+    }
 
-    AST parse() {
+    NodeId parse() {
         // Expect file to start with 'star' and end with 'end'
-        expect("star");
-        auto block = std::make_shared<BlockNode>(peek().line);
-        while (peek().value != "end" && peek().type != TokenType::END_OF_FILE) {
-            block->statements.push_back(parse_statement());
-        }
-        expect("end");
-        return block;
-    }
-
-    AST parse_statement() {
-        Token t = peek();
-        if (t.value == "val") return parse_val();
-        if (t.value == "var") return parse_var();
-        if (t.value == "say") return parse_say();
-        if (t.type == TokenType::IDENTIFIER && peek(1).value == "=") return parse_assign();
-        throw std::runtime_error("Unknown statement at line " + std::to_string(t.line));
-    }
-
-    AST parse_val() {
-        Token t = consume(); // val
-        Token name = consume(); // identifier
-        expect("=");
-        AST val = parse_expression();
-        return std::make_shared<ValNode>(name.value, val, t.line);
-    }
-    AST parse_var() {
-        Token t = consume(); // var
-        Token name = consume(); // identifier
-        expect("=");
-        AST val = parse_expression();
-        return std::make_shared<VarNode>(name.value, val, t.line);
-    }
-    AST parse_say() {
-        Token t = consume(); // say
-        AST val = parse_expression();
-        return std::make_shared<SayNode>(val, t.line);
-    }
-    AST parse_assign() {
-        Token name = consume(); // identifier
+        try { expect(sym::STAR); } catch (const ParseError&) {}
+        ast.root = parse_block(peek().line, false);
+        try { expect(sym::END); } catch (const ParseError&) {}
+        if (errors == &ownErrors && ownErrors.hasErrors()) throw std::runtime_error(summary());
+        return ast.root;
+    }
+
+    // Statements up to `end` (or `else`, inside an if). Each one recovers on
+    // its own, so an error in a nested block does not end the outer one.
+    NodeId parse_block(int line, bool stopAtElse) {
+        size_t outerStart = statementStart;
+        std::vector<NodeId> statements;
+        while (peek().sym != sym::END && !(stopAtElse && peek().sym == sym::ELSE) &&
+               peek().type != TokenType::END_OF_FILE) {
+            statementStart = pos;
+            try {
+                statements.push_back(parse_statement());
+            } catch (const ParseError&) {
+                synchronize();
+            }
+        }
+        statementStart = outerStart;
+        return ast.add(NodeKind::Block, line, statements);
+    }
+
+    NodeId parse_statement() {
+        const Token& t = peek();
+        if (t.sym == sym::VAL) return parse_binding(NodeKind::Val);
+        if (t.sym == sym::VAR) return parse_binding(NodeKind::Var);
+        if (t.sym == sym::SAY) return parse_say();
+        if (t.sym == sym::WHILE) return parse_while();
+        if (t.sym == sym::LOOP) return parse_loop();
+        if (t.sym == sym::IF) return parse_if();
+        if (t.sym == sym::DEFINE || t.sym == sym::FUNC) return parse_define();
+        if (t.sym == sym::RETURN) return parse_return();
+        static const SymbolId thread = SymbolInterner::global().intern("thread");
+        static const SymbolId await = SymbolInterner::global().intern("await");
+        if (t.sym == thread) return parse_thread();
+        if (t.sym == await) return ast.add(NodeKind::Await, consume().line);
+        static const SymbolId pipe = SymbolInterner::global().intern("pipe");
+        if (t.sym == pipe) return parse_pipe();
+        if (isName(t) && peek(1).sym == sym::ASSIGN) return parse_assign();
+        if (isName(t) && peek(1).sym == sym::LPAREN && peek(1).line == t.line)
+            return parse_call(consume());
+        throw error(t, "Unknown statement");
+    }
+
+    NodeId parse_binding(NodeKind kind) {
+        int line = consume().line; // val / var
+        if (!isName(peek())) throw error(peek(), "Expected a name");
+        SymbolId name = consume().sym; // identifier
+        expect(sym::ASSIGN);
+        NodeId val = parse_expression();
+        return ast.named(kind, name, line, {val});
+    }
+    NodeId parse_say() {
+        int line = consume().line; // say
+        NodeId val = parse_expression();
+        return ast.add(NodeKind::Say, line, {val});
+    }
+    // while cond[:] ... end
+    NodeId parse_while() {
+        int line = consume().line; // while
+        NodeId cond = parse_expression();
+        match(sym::COLON);
+        NodeId body = parse_block(line, false);
+        expect(sym::END);
+        return ast.add(NodeKind::While, line, {cond, body});
+    }
+    // loop [name] from a to b[:] ... end, with name = a, a+1, ..., b
+    NodeId parse_loop() {
+        static const SymbolId from = SymbolInterner::global().intern("from");
+        static const SymbolId to = SymbolInterner::global().intern("to");
+        int line = consume().line; // loop
+        SymbolId counter = sym::NONE;
+        if (isName(peek()) && peek(1).sym == from) counter = consume().sym;
+        expect(from);
+        NodeId first = parse_expression();
+        expect(to);
+        NodeId last = parse_expression();
+        match(sym::COLON);
+        NodeId body = parse_block(line, false);
+        expect(sym::END);
+        return ast.named(NodeKind::Loop, counter, line, {first, last, body});
+    }
+    // if cond[:] ... [else ...] end
+    NodeId parse_if() {
+        int line = consume().line; // if
+        NodeId cond = parse_expression();
+        match(sym::COLON);
+        NodeId then = parse_block(line, true);
+        if (!match(sym::ELSE)) {
+            expect(sym::END);
+            return ast.add(NodeKind::If, line, {cond, then});
+        }
+        NodeId otherwise = parse_block(line, false);
+        expect(sym::END);
+        return ast.add(NodeKind::If, line, {cond, then, otherwise});
+    }
+    // define name(param [as type], ...) [as type | -> type][:] ... end
+    // (`func` is a synonym). Type annotations are accepted and not checked.
+    NodeId parse_define() {
+        int line = consume().line; // define / func
+        if (!isName(peek())) throw error(peek(), "Expected a function name");
+        SymbolId name = consume().sym;
+        expect(sym::LPAREN);
+        std::vector<NodeId> kids;
+        if (!match(sym::RPAREN)) {
+            do {
+                if (!isName(peek())) throw error(peek(), "Expected a parameter name");
+                const Token& param = consume();
+                kids.push_back(ast.named(NodeKind::Identifier, param.sym, param.line));
+                skip_type_annotation();
+            } while (match(sym::COMMA));
+            expect(sym::RPAREN);
+        }
+        static const SymbolId arrow = SymbolInterner::global().intern("->");
+        if (match(arrow)) {
+            skip_type();
+        } else {
+            skip_type_annotation();
+        }
+        match(sym::COLON);
+        kids.push_back(parse_block(line, false));
+        expect(sym::END);
+        return ast.named(NodeKind::FuncDef, name, line, kids);
+    }
+    // return [expr]; the value must start on the same line
+    NodeId parse_return() {
+        int line = consume().line; // return
+        if (peek().line == line && peek().sym != sym::END && startsExpression(peek()))
+            return ast.add(NodeKind::Return, line, {parse_expression()});
+        return ast.add(NodeKind::Return, line);
+    }
+    // thread f(args): the call runs as a task of its own
+    NodeId parse_thread() {
+        int line = consume().line; // thread
+        if (!isName(peek()) || peek(1).sym != sym::LPAREN)
+            throw error(peek(), "Expected a function call after 'thread'");
+        return ast.add(NodeKind::Thread, line, {parse_call(consume())});
+    }
+    // pipe write|append[:] file: later `say`s go to the file
+    NodeId parse_pipe() {
+        static const SymbolId write = SymbolInterner::global().intern("write");
+        static const SymbolId append = SymbolInterner::global().intern("append");
+        int line = consume().line; // pipe
+        if (peek().sym != write && peek().sym != append) throw error(peek(), "Expected 'write' or 'append' after 'pipe'");
+        SymbolId mode = consume().sym;
+        match(sym::COLON);
+        return ast.named(NodeKind::Pipe, mode, line, {parse_expression()});
+    }
+    NodeId parse_assign() {
+        const Token& name = consume(); // identifier
         consume(); // =
-        AST val = parse_expression();
-        return std::make_shared<AssignNode>(name.value, val, name.line);
+        NodeId val = parse_expression();
+        return ast.named(NodeKind::Assign, name.sym, name.line, {val});
+    }
+
+    // Pratt loop: parse a prefix form, then fold in infix operators for as
+    // long as they bind tighter than `minBp`. Equal power stops the loop, so
+    // every binary operator is left-associative.
+    NodeId parse_expression(uint8_t minBp = BP_NONE) {
+        NodeId lhs = parse_prefix();
+        for (;;) {
+            const InfixRule& rule = infixRule(peek());
+            if (rule.bp <= minBp) return lhs;
+            int line = consume().line;
+            NodeId rhs = parse_expression(rule.bp);
+            lhs = ast.binary(rule.op, lhs, rhs, line);
+        }
+    }
+
+private:
+    // Binding powers, loosest first. Prefix operators bind tighter than any
+    // infix one, so `-a * b` is `(-a) * b` and `not a == b` is `(not a) == b`.
+    enum : uint8_t {
+        BP_NONE = 0, BP_OR, BP_AND, BP_EQUALITY, BP_COMPARE, BP_TERM, BP_FACTOR, BP_PREFIX
+    };
+
+    struct InfixRule {
+        AstOp op;
+        uint8_t bp;  // BP_NONE: not an infix operator
+    };
+
+    // Indexed by SymbolId; only well-known symbols can be operators.
+    static const InfixRule& infixRule(const Token& t) {
+        static const auto table = [] {
+            std::array<InfixRule, sym::WELL_KNOWN_COUNT> r{};
+            r[sym::OR] = r[sym::OR_OR] = {AstOp::Or, BP_OR};
+            r[sym::AND] = r[sym::AND_AND] = {AstOp::And, BP_AND};
+            r[sym::EQ] = {AstOp::Eq, BP_EQUALITY};
+            r[sym::NE] = {AstOp::Ne, BP_EQUALITY};
+            r[sym::LT] = {AstOp::Lt, BP_COMPARE};
+            r[sym::LE] = {AstOp::Le, BP_COMPARE};
+            r[sym::GT] = {AstOp::Gt, BP_COMPARE};
+            r[sym::GE] = {AstOp::Ge, BP_COMPARE};
+            r[sym::ADD] = {AstOp::Add, BP_TERM};
+            r[sym::SUB] = {AstOp::Sub, BP_TERM};
+            r[sym::MUL] = {AstOp::Mul, BP_FACTOR};
+            r[sym::DIV] = {AstOp::Div, BP_FACTOR};
+            r[sym::MOD] = {AstOp::Mod, BP_FACTOR};
+            return r;
+        }();
+        static const InfixRule none{};
+        if (t.type == TokenType::STRING || t.sym >= table.size()) return none;
+        return table[t.sym];
+    }
+
+    NodeId parse_prefix() {
+        if (!startsExpression(peek())) throw error(peek(), "Expected an expression");
+        const Token& t = consume();
+        switch (t.type) {
+        case TokenType::NUMBER:
+            return parse_number(t);
+        case TokenType::STRING:
+            return parse_string(t);
+        case TokenType::KEYWORD:
+            if (t.sym == sym::TRUE || t.sym == sym::FALSE)
+                return ast.boolLiteral(t.sym == sym::TRUE, t.line);
+            if (t.sym == sym::NOT)
+                return ast.unary(AstOp::Not, parse_expression(BP_PREFIX), t.line);
+            if (reserved(t.sym)) break;
+            [[fallthrough]];  // a contextual keyword used as a name
+        case TokenType::IDENTIFIER:
+            // A call's '(' must sit on the callee's line; statements are not
+            // terminated, so a '(' on the next line starts something else.
+            if (peek().sym == sym::LPAREN && peek().line == t.line)
+                return parse_call(t);
+            return ast.named(NodeKind::Identifier, t.sym, t.line);
+        case TokenType::SYMBOL:
+            if (t.sym == sym::SUB)
+                return ast.unary(AstOp::Neg, parse_expression(BP_PREFIX), t.line);
+            if (t.sym == sym::BANG)
+                return ast.unary(AstOp::Not, parse_expression(BP_PREFIX), t.line);
+            if (t.sym == sym::LPAREN) {
+                NodeId inner = parse_expression();
+                expect(sym::RPAREN);
+                return inner;
+            }
+            break;
+        default:
+            break;
+        }
+        throw error(t, "Unexpected '" + std::string(t.value) + "' in expression");
+    }
+
+    // `as type`, if present
+    void skip_type_annotation() {
+        static const SymbolId as = SymbolInterner::global().intern("as");
+        if (peek().sym == as) {
+            consume();
+            skip_type();
+        }
+    }
+    // A type name, with an optional <...> argument list: int, list<string>
+    void skip_type() {
+        if (peek().type != TokenType::IDENTIFIER && peek().type != TokenType::KEYWORD)
+            throw error(peek(), "Expected a type");  // some type names are keywords
+        consume();
+        if (!match(sym::LT)) return;
+        int depth = 1;
+        while (depth > 0 && peek().type != TokenType::END_OF_FILE) {
+            const Token& t = consume();
+            if (t.sym == sym::LT) ++depth;
+            else if (t.sym == sym::GT) --depth;
+        }
     }
 
-    AST parse_expression() {
-        Token t = peek();
-        if (t.type == TokenType::NUMBER) {
-            consume(); return std::make_shared<NumberNode>(t.value, t.line);
+    static bool startsExpression(const Token& t) {
+        switch (t.type) {
+            case TokenType::NUMBER:
+            case TokenType::STRING:
+            case TokenType::IDENTIFIER: return true;
+            case TokenType::KEYWORD:    return t.sym == sym::TRUE || t.sym == sym::FALSE || t.sym == sym::NOT || !reserved(t.sym);
+            case TokenType::SYMBOL:     return t.sym == sym::SUB || t.sym == sym::BANG || t.sym == sym::LPAREN;
+            default:                    return false;
+        }
+    }
+
+    // The keywords this grammar gives a role. The rest of the keyword chart
+    // (result, map, from, to, ...) is contextual: those words lex as KEYWORD,
+    // but name a variable, function or parameter like any identifier.
+    static bool reserved(SymbolId s) {
+        static const SymbolId thread = SymbolInterner::global().intern("thread");
+        static const SymbolId await = SymbolInterner::global().intern("await");
+        static const SymbolId pipe = SymbolInterner::global().intern("pipe");
+        switch (s) {
+            case sym::STAR: case sym::END: case sym::VAL: case sym::VAR: case sym::SAY:
+            case sym::LOOP: case sym::IF: case sym::ELSE: case sym::WHILE: case sym::RETURN:
+            case sym::FUNC: case sym::DEFINE: case sym::TRUE: case sym::FALSE:
+            case sym::AND: case sym::OR: case sym::NOT:
+                return true;
+            default:
+                return s == thread || s == await || s == pipe;
+        }
+    }
+    static bool isName(const Token& t) {
+        return t.type == TokenType::IDENTIFIER || (t.type == TokenType::KEYWORD && !reserved(t.sym));
+    }
+
+    NodeId parse_call(const Token& callee) {
+        consume(); // (
+        std::vector<NodeId> args;
+        if (!match(sym::RPAREN)) {
+            do {
+                args.push_back(parse_expression());
+            } while (match(sym::COMMA));
+            expect(sym::RPAREN);
+        }
+        return ast.named(NodeKind::Call, callee.sym, callee.line, args);
+    }
+
+    // "Hello, {name}!" becomes Interpolate["Hello, ", name, "!"]. Each {...}
+    // is lexed and parsed as a full expression into the same arena; the text
+    // pieces stay views into the string. A '{' without a closing '}' is text.
+    NodeId parse_string(const Token& t) {
+        std::string_view text = t.escaped ? ast.keep(Lexer::unescape(t.value)) : t.value;
+        size_t open = text.find('{');
+        if (open == std::string_view::npos) return ast.stringLiteral(text, t.line);
+
+        std::vector<NodeId> parts;
+        size_t from = 0;
+        for (; open != std::string_view::npos; open = text.find('{', from)) {
+            size_t close = text.find('}', open + 1);
+            if (close == std::string_view::npos) break;
+            if (open > from) parts.push_back(ast.stringLiteral(text.substr(from, open - from), t.line));
+            parts.push_back(parse_embedded(text.substr(open + 1, close - open - 1), t.line));
+            from = close + 1;
+        }
+        if (from < text.size()) parts.push_back(ast.stringLiteral(text.substr(from), t.line));
+        if (parts.size() == 1 && ast.kind(parts[0]) == NodeKind::StringLiteral) return parts[0];
+        return ast.add(NodeKind::Interpolate, t.line, parts);
+    }
+
+    NodeId parse_embedded(std::string_view source, int line) {
+        TokenList inner = Lexer(source).tokenize();
+        for (Token& tok : inner) tok.line = line;
+        Parser sub(inner, ast, errors, filename);
+        NodeId expr = sub.parse_expression();
+        if (sub.peek().type != TokenType::END_OF_FILE)
+            throw error(tokens[pos - 1], "Bad interpolation '{" + std::string(source) + "}'");
+        return expr;
+    }
+
+    NodeId parse_number(const Token& t) {
+        const char* first = t.value.data();
+        const char* last = first + t.value.size();
+        if (t.value.find('.') == std::string_view::npos) {
+            int64_t v = 0;
+            if (std::from_chars(first, last, v).ec == std::errc())
+                return ast.intLiteral(v, t.line);
+        }
+        double d = 0;
+        if (std::from_chars(first, last, d).ec != std::errc())
+            throw error(t, "Bad number");
+        return ast.floatLiteral(d, t.line);
+    }
+
+    std::string summary() const {
+        std::string out = std::to_string(ownErrors.errorCount()) + " syntax error(s):";
+        for (const QuarterError& e : ownErrors.all())
+            out += "\n  line " + std::to_string(e.line) + ": " + e.message;
+        return out;
+    }
+};
+
+// === QuarterLang Source Scanner ===
+// Block-at-a-time character classification for the Lexer's hot loops.
+// Classifies 16 (SSE2) or 32 (AVX2) bytes per step, picked once at startup
+// from the running CPU; other targets use the scalar loop.
+
+// SourceScanner.h
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define QTR_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define QTR_TARGET_AVX2
+#else
+#define QTR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+enum class ScanLevel { Scalar, SSE2, AVX2 };
+
+class SourceScanner {
+public:
+    // Each scan returns the first byte in [p, end) that is NOT in the class.
+    // When `newlines` is given, '\n' bytes passed over are added to it.
+    enum class CharClass { Whitespace, Identifier, Digit, StringBody, LineBody };
+
+    static const char* skipWhitespace(const char* p, const char* end, int& newlines) {
+        return kernel()(p, end, CharClass::Whitespace, &newlines);
+    }
+    static const char* identifierEnd(const char* p, const char* end) {
+        return kernel()(p, end, CharClass::Identifier, nullptr);
+    }
+    static const char* digitsEnd(const char* p, const char* end) {
+        return kernel()(p, end, CharClass::Digit, nullptr);
+    }
+    // Next '"' or '\\' (string terminator or escape).
+    static const char* stringStop(const char* p, const char* end) {
+        return kernel()(p, end, CharClass::StringBody, nullptr);
+    }
+    // Next '\n' (end of a // comment).
+    static const char* lineEnd(const char* p, const char* end) {
+        return kernel()(p, end, CharClass::LineBody, nullptr);
+    }
+    static int countNewlines(const char* p, const char* end) {
+        int n = 0;
+        while ((p = kernel()(p, end, CharClass::LineBody, nullptr)) < end) { ++n; ++p; }
+        return n;
+    }
+
+    static ScanLevel level() { return state().level; }
+    static const char* levelName(ScanLevel l) {
+        switch (l) {
+            case ScanLevel::AVX2: return "avx2";
+            case ScanLevel::SSE2: return "sse2";
+            default:              return "scalar";
+        }
+    }
+    // Force a level (benchmarks, debugging). Returns false if the CPU lacks it.
+    static bool setLevel(ScanLevel l) {
+        if (!supported(l)) return false;
+        state().level = l;
+        state().fn = kernelFor(l);
+        return true;
+    }
+    static bool supported(ScanLevel l) {
+        if (l == ScanLevel::Scalar) return true;
+#ifdef QTR_SCAN_X86
+        if (l == ScanLevel::SSE2) return true;
+        return cpuHasAVX2();
+#else
+        return false;
+#endif
+    }
+
+private:
+    using ScanFn = const char* (*)(const char*, const char*, CharClass, int*);
+
+    struct State {
+        ScanLevel level;
+        ScanFn fn;
+    };
+
+    static State& state() {
+        static State s = detect();
+        return s;
+    }
+    static ScanFn kernel() { return state().fn; }
+
+    static State detect() {
+        ScanLevel l = supported(ScanLevel::AVX2) ? ScanLevel::AVX2
+                    : supported(ScanLevel::SSE2) ? ScanLevel::SSE2 : ScanLevel::Scalar;
+        if (const char* env = std::getenv("QUARTER_SCAN")) {
+            if (!std::strcmp(env, "scalar")) l = ScanLevel::Scalar;
+            else if (!std::strcmp(env, "sse2") && supported(ScanLevel::SSE2)) l = ScanLevel::SSE2;
         }
-        if (t.type == TokenType::STRING) {
-            consume(); return std::make_shared<StringNode>(t.value, t.line);
+        return {l, kernelFor(l)};
+    }
+
+    static ScanFn kernelFor(ScanLevel l) {
+#ifdef QTR_SCAN_X86
+        if (l == ScanLevel::AVX2) return scanAVX2;
+        if (l == ScanLevel::SSE2) return scanSSE2;
+#endif
+        (void)l;
+        return scanScalar;
+    }
+
+    // --- Scalar reference ---
+    static bool inClass(unsigned char c, CharClass cls) {
+        switch (cls) {
+            case CharClass::Whitespace: return c == ' ' || (c >= '\t' && c <= '\r');
+            case CharClass::Identifier: return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                                               (c >= '0' && c <= '9') || c == '_';
+            case CharClass::Digit:      return c >= '0' && c <= '9';
+            case CharClass::StringBody: return c != '"' && c != '\\';
+            case CharClass::LineBody:   return c != '\n';
+        }
+        return false;
+    }
+
+    static const char* scanScalar(const char* p, const char* end, CharClass cls, int* newlines) {
+        for (; p < end; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (!inClass(c, cls)) break;
+            if (newlines && c == '\n') ++*newlines;
+        }
+        return p;
+    }
+
+#ifdef QTR_SCAN_X86
+    static unsigned lowestBit(uint32_t m) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        _BitScanForward(&idx, m);
+        return idx;
+#else
+        return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+    }
+    static int popCount(uint32_t m) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return static_cast<int>(__popcnt(m));
+#else
+        return __builtin_popcount(m);
+#endif
+    }
+
+    static bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuid(r, 1);
+        bool osxsave = (r[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    // Bytes are signed in the compare intrinsics; everything >= 0x80 is negative
+    // and therefore falls outside every ASCII range tested here.
+    static __m128i rangeSSE2(__m128i v, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+    }
+
+    static uint32_t classMaskSSE2(__m128i v, CharClass cls) {
+        __m128i in;
+        switch (cls) {
+            case CharClass::Whitespace:
+                in = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), rangeSSE2(v, '\t', '\r'));
+                break;
+            case CharClass::Identifier: {
+                __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                in = _mm_or_si128(_mm_or_si128(rangeSSE2(lower, 'a', 'z'), rangeSSE2(v, '0', '9')),
+                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+                break;
+            }
+            case CharClass::Digit:
+                in = rangeSSE2(v, '0', '9');
+                break;
+            case CharClass::StringBody:
+                return static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')))));
+            default:
+                return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+        }
+        return ~static_cast<uint32_t>(_mm_movemask_epi8(in)) & 0xFFFFu;
+    }
+
+    static const char* scanSSE2(const char* p, const char* end, CharClass cls, int* newlines) {
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            uint32_t stop = classMaskSSE2(v, cls);
+            if (newlines) {
+                uint32_t nl = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+                if (stop) nl &= (1u << lowestBit(stop)) - 1;
+                *newlines += popCount(nl);
+            }
+            if (stop) return p + lowestBit(stop);
+            p += 16;
+        }
+        return scanScalar(p, end, cls, newlines);
+    }
+
+    QTR_TARGET_AVX2 static __m256i rangeAVX2(__m256i v, char lo, char hi) {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+    }
+
+    QTR_TARGET_AVX2 static uint32_t classMaskAVX2(__m256i v, CharClass cls) {
+        __m256i in;
+        switch (cls) {
+            case CharClass::Whitespace:
+                in = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), rangeAVX2(v, '\t', '\r'));
+                break;
+            case CharClass::Identifier: {
+                __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+                in = _mm256_or_si256(_mm256_or_si256(rangeAVX2(lower, 'a', 'z'), rangeAVX2(v, '0', '9')),
+                                     _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+                break;
+            }
+            case CharClass::Digit:
+                in = rangeAVX2(v, '0', '9');
+                break;
+            case CharClass::StringBody:
+                return static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')))));
+            default:
+                return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
         }
-        if (t.type == TokenType::IDENTIFIER) {
-            consume(); return std::make_shared<IdentifierNode>(t.value, t.line);
+        return ~static_cast<uint32_t>(_mm256_movemask_epi8(in));
+    }
+
+    QTR_TARGET_AVX2 static const char* scanAVX2(const char* p, const char* end, CharClass cls, int* newlines) {
+        while (end - p >= 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            uint32_t stop = classMaskAVX2(v, cls);
+            if (newlines) {
+                uint32_t nl = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+                if (stop) nl &= (1u << lowestBit(stop)) - 1;
+                *newlines += popCount(nl);
+            }
+            if (stop) return p + lowestBit(stop);
+            p += 32;
         }
-        throw std::runtime_error("Unexpected expression at line " + std::to_string(t.line));
+        return scanSSE2(p, end, cls, newlines);
     }
+#endif
 };
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <algorithm>
 #include <cctype>
-#include <unordered_set>
+#include "SymbolInterner.h"
+#include "SourceScanner.h"
+#include "QuarterLang_Keywords.h"
 
 enum class TokenType {
     KEYWORD, IDENTIFIER, NUMBER, STRING, SYMBOL,
     COMMENT, END_OF_FILE
 };
 
+// Tokens do not own text: `value` views the source buffer handed to the Lexer,
+// which must outlive the tokens. A string literal with escapes keeps its raw
+// body and sets `escaped`; the consumer decodes it with Lexer::unescape().
+// Keywords, identifiers and symbols also carry their interned `sym` so later
+// stages compare integers; literals are never interned.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     int line;
+    SymbolId sym = sym::NONE;
+    bool escaped = false;
 };
 
 class Lexer {
 public:
-    Lexer(const std::string& src) : src(src), pos(0), line(1) {}
+    Lexer(std::string_view src) : src(src), pos(0), line(1) {}
 
     std::vector<Token> tokenize() {
         std::vector<Token> tokens;
+        tokens.reserve(src.size() / 8 + 16);
         while (true) {
-            Token t = nextToken();
-            tokens.push_back(t);
-            if (t.type == TokenType::END_OF_FILE) break;
+            tokens.push_back(nextToken());
+            if (tokens.back().type == TokenType::END_OF_FILE) break;
         }
         return tokens;
     }
 
+    // Decodes the raw body of an escaped string token: \n, \t, and \c -> c.
+    static std::string unescape(std::string_view body) {
+        std::string str;
+        str.reserve(body.size());
+        for (size_t i = 0; i < body.size(); ++i) {
+            if (body[i] == '\\' && i + 1 < body.size()) {
+                char esc = body[++i];
+                if (esc == 'n') str += '\n';
+                else if (esc == 't') str += '\t';
+                else str += esc;
+            } else {
+                str += body[i];
+            }
+        }
+        return str;
+    }
+
 private:
-    const std::string src;
+    std::string_view src;
     size_t pos;
     int line;
+    SymbolInterner& interner = SymbolInterner::global();
 
-    const std::unordered_set<std::string> keywords = {
-        "star","end","val","var","say","loop","if","else","while","match","case","break","continue","return","func"
-    };
-
-    char peek() const { return pos < src.size() ? src[pos] : '\0'; }
+    char peek(size_t ahead = 0) const { return pos + ahead < src.size() ? src[pos + ahead] : '\0'; }
     char get() { return pos < src.size() ? src[pos++] : '\0'; }
+    std::string_view slice(size_t start) const { return src.substr(start, pos - start); }
+    const char* at() const { return src.data() + pos; }
+    const char* srcEnd() const { return src.data() + src.size(); }
+    void seek(const char* p) { pos = static_cast<size_t>(p - src.data()); }
     void skipWhitespace() {
-        while (isspace(peek())) {
-            if (peek() == '\n') ++line;
-            get();
-        }
+        seek(SourceScanner::skipWhitespace(at(), srcEnd(), line));
     }
-    bool isIdentifierStart(char c) { return std::isalpha(c) || c == '_'; }
-    bool isIdentifierChar(char c) { return std::isalnum(c) || c == '_'; }
+    bool isIdentifierStart(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
 
     Token nextToken() {
         skipWhitespace();
 
         char c = peek();
-        if (c == '\0') return {TokenType::END_OF_FILE, "", line};
+        if (c == '\0') return {TokenType::END_OF_FILE, {}, line};
 
         // Comments
         if (c == '/') {
-            if (src[pos + 1] == '/') {
-                std::string comment;
-                while (peek() != '\n' && peek() != '\0') comment += get();
-                return {TokenType::COMMENT, comment, line};
-            } else if (src[pos + 1] == '*') {
+            if (peek(1) == '/') {
+                size_t start = pos;
+                seek(SourceScanner::lineEnd(at(), srcEnd()));
+                return {TokenType::COMMENT, slice(start), line};
+            } else if (peek(1) == '*') {
+                size_t start = pos;
                 pos += 2; // Skip /*
-                std::string comment = "/*";
-                while (pos < src.size() && !(peek() == '*' && src[pos + 1] == '/')) {
-                    if (peek() == '\n') ++line;
-                    comment += get();
-                }
-                if (pos < src.size()) {
-                    comment += "*";
-                    comment += "/";
-                    pos += 2;
-                }
-                return {TokenType::COMMENT, comment, line};
+                size_t close = src.find("*/", pos);
+                if (close == std::string_view::npos) close = src.size();
+                line += SourceScanner::countNewlines(at(), src.data() + close);
+                pos = close < src.size() ? close + 2 : close;
+                return {TokenType::COMMENT, slice(start), line};
             }
         }
 
-        // Strings
+        // Strings: always a view of the raw body; escapes are flagged, not decoded
         if (c == '"') {
-            std::string str;
             get(); // skip "
-            while (peek() != '"' && peek() != '\0') {
-                if (peek() == '\\') {
-                    get(); // skip \
-                    char esc = get();
-                    if (esc == 'n') str += '\n';
-                    else if (esc == 't') str += '\t';
-                    else str += esc;
-                } else {
-                    str += get();
-                }
+            size_t start = pos;
+            bool escaped = false;
+            while (true) {
+                seek(SourceScanner::stringStop(at(), srcEnd()));
+                if (peek() != '\\') break;
+                escaped = true;
+                pos = std::min(pos + 2, src.size());
             }
+            std::string_view body = slice(start);
             get(); // skip ending "
-            return {TokenType::STRING, str, line};
+            return {TokenType::STRING, body, line, sym::NONE, escaped};
         }
 
         // Numbers
-        if (isdigit(c)) {
-            std::string num;
-            bool has_dot = false;
-            while (isdigit(peek()) || peek() == '.') {
-                if (peek() == '.') {
-                    if (has_dot) break;
-                    has_dot = true;
-                }
-                num += get();
+        if (isdigit(static_cast<unsigned char>(c))) {
+            size_t start = pos;
+            seek(SourceScanner::digitsEnd(at(), srcEnd()));
+            if (peek() == '.') {
+                get();
+                seek(SourceScanner::digitsEnd(at(), srcEnd()));
             }
-            return {TokenType::NUMBER, num, line};
+            return {TokenType::NUMBER, slice(start), line};
         }
 
         // Identifiers/Keywords
         if (isIdentifierStart(c)) {
-            std::string id;
-            while (isIdentifierChar(peek())) id += get();
-            if (keywords.count(id)) return {TokenType::KEYWORD, id, line};
-            else return {TokenType::IDENTIFIER, id, line};
+            size_t start = pos;
+            seek(SourceScanner::identifierEnd(at(), srcEnd()));
+            std::string_view id = slice(start);
+            SymbolId s = interner.intern(id);
+            return {QuarterKeywords::isKeyword(id) ? TokenType::KEYWORD : TokenType::IDENTIFIER, id, line, s};
         }
 
-        // Symbols (multi-char: ==, !=, <=, >=, ->, =>)
-        std::string symbol;
-        symbol += get();
+        // Symbols (multi-char: ==, !=, <=, >=, ->, =>, &&, ||)
+        size_t start = pos;
+        char first = get();
         char next = peek();
-        if ((symbol == "=" || symbol == "!" || symbol == "<" || symbol == ">" || symbol == "-") && 
-            (next == '=' || (symbol == "-" && next == '>'))) {
-            symbol += get();
-        } else if (symbol == "=" && next == '>') {
-            symbol += get();
+        if ((first == '=' || first == '!' || first == '<' || first == '>' || first == '-') &&
+            (next == '=' || (first == '-' && next == '>'))) {
+            get();
+        } else if (first == '=' && next == '>') {
+            get();
+        } else if ((first == '&' || first == '|') && next == first) {
+            get();
         }
-        return {TokenType::SYMBOL, symbol, line};
+        std::string_view symbol = slice(start);
+        return {TokenType::SYMBOL, symbol, line, interner.intern(symbol)};
     }
 };
 
@@ -2763,6 +7769,59 @@ int main() {
     return 0;
 }
 
+// === Lexer throughput benchmark ===
+// Usage: ./lexer_bench [file.quarter] [repeats]
+// Without a file, lexes a synthetic ~16 MB program. Reports MB/s for every
+// scan level the CPU supports so the SIMD gain is visible side by side.
+
+#include <chrono>
+#include "QuarterLang_SourceBuffer.h"
+
+std::string syntheticQuarterSource(size_t targetBytes) {
+    std::string src = "star\n";
+    size_t i = 0;
+    while (src.size() < targetBytes) {
+        std::string n = std::to_string(i++);
+        src += "    val identifier_number_" + n + " = " + n + ".25\n";
+        src += "    say \"a moderately long string literal for line " + n + "\"\n";
+        src += "    // comment describing statement " + n + " in a little detail\n";
+        src += "    counter_" + n + " = identifier_number_" + n + "\n";
+    }
+    src += "end\n";
+    return src;
+}
+
+int main(int argc, char* argv[]) {
+    SourceBuffer source;
+    if (argc > 1) {
+        if (!source.open(argv[1])) {
+            std::cerr << "Cannot open " << argv[1] << "\n";
+            return 1;
+        }
+    } else {
+        source = SourceBuffer(syntheticQuarterSource(16u << 20));
+    }
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    double mb = static_cast<double>(source.size()) / (1024.0 * 1024.0);
+
+    std::cout << "Lexing " << mb << " MB x " << repeats << "\n";
+    for (ScanLevel l : {ScanLevel::Scalar, ScanLevel::SSE2, ScanLevel::AVX2}) {
+        if (!SourceScanner::setLevel(l)) continue;
+        size_t tokenCount = 0;
+        double best = 1e30;
+        for (int r = 0; r < repeats; ++r) {
+            auto t0 = std::chrono::steady_clock::now();
+            Lexer lexer(source.view());
+            tokenCount = lexer.tokenize().size();
+            std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+            best = std::min(best, dt.count());
+        }
+        std::cout << "  " << SourceScanner::levelName(l) << ": " << (mb / best) << " MB/s ("
+                  << tokenCount << " tokens, best of " << repeats << ")\n";
+    }
+    return 0;
+}
+
 // === QuarterLang Indexter ===
 // Indexter: Symbol Table and Semantic Lookup System
 
@@ -2771,10 +7830,11 @@ int main() {
 #include <unordered_map>
 #include <vector>
 #include <optional>
+#include "SymbolInterner.h"
 
 // ---- Symbol Metadata Structure ----
 struct QSymbolInfo {
-    std::string name;           // The identifier
+    SymbolId name;              // The interned identifier
     std::string type;           // "int", "text", "dg", "func", etc.
     int scopeLevel;             // Nesting or block depth
     int declLine;               // Declaration line number
@@ -2791,18 +7851,22 @@ public:
     // Exit a block scope (e.g., at 'end')
     void exitScope() {
         // Remove all symbols declared at this scope
-        for (auto it = index.begin(); it != index.end(); ) {
-            if (it->second.scopeLevel == currentScope)
-                it = index.erase(it);
-            else
-                ++it;
+        auto it = scopeStack.find(currentScope);
+        if (it != scopeStack.end()) {
+            for (SymbolId name : it->second) {
+                auto found = index.find(name);
+                if (found != index.end() && found->second.scopeLevel == currentScope)
+                    index.erase(found);
+            }
+            scopeStack.erase(it);
         }
         if (currentScope > 0) currentScope--;
     }
 
     // Declare a symbol
-    bool declare(const std::string& name, const std::string& type, int line) {
-        if (index.count(name) && index[name].scopeLevel == currentScope) {
+    bool declare(SymbolId name, const std::string& type, int line) {
+        auto it = index.find(name);
+        if (it != index.end() && it->second.scopeLevel == currentScope) {
             // Already declared in this scope
             return false;
         }
@@ -2812,7 +7876,7 @@ public:
     }
 
     // Lookup symbol info (searches outward through scopes)
-    std::optional<QSymbolInfo> lookup(const std::string& name) const {
+    std::optional<QSymbolInfo> lookup(SymbolId name) const {
         auto it = index.find(name);
         if (it != index.end())
             return it->second;
@@ -2827,7 +7891,7 @@ public:
         std::vector<QSymbolInfo> result;
         auto it = scopeStack.find(currentScope);
         if (it != scopeStack.end()) {
-            for (const auto& name : it->second) {
+            for (SymbolId name : it->second) {
                 auto found = index.find(name);
                 if (found != index.end())
                     result.push_back(found->second);
@@ -2838,8 +7902,8 @@ public:
 
 private:
     int currentScope;
-    std::unordered_map<std::string, QSymbolInfo> index;
-    std::unordered_map<int, std::vector<std::string>> scopeStack;
+    std::unordered_map<SymbolId, QSymbolInfo> index;
+    std::unordered_map<int, std::vector<SymbolId>> scopeStack;
 };
 
 // =======================
@@ -2939,6 +8003,7 @@ public:
     void setVerbose(bool v) { verbose = v; }
     void clear() { errors.clear(); }
     int errorCount() const { return (int)errors.size(); }
+    const std::vector<QuarterError>& all() const { return errors; }
 };
 
 #endif // QUARTER_ERROR_HANDLER_H
@@ -2951,6 +8016,8 @@ public:
 #include <unordered_set>
 #include <cctype>
 #include <sstream>
+#include <string_view>
+#include "QuarterLang_Keywords.h"
 
 namespace QuarterLang {
 
@@ -2963,12 +8030,7 @@ const std::string STRING  = "\033[1;32m";   // Green/Bold
 const std::string COMMENT = "\033[1;90m";   // Grey
 const std::string SYMBOL  = "\033[1;34m";   // Blue/Bold
 
-// --- QuarterLang Reserved Keywords (update as needed) ---
-const std::unordered_set<std::string> KEYWORDS = {
-    "star", "end", "val", "var", "say", "do", "loop", "to", "as", "if",
-    "else", "match", "break", "continue", "fn", "dg", "type", "in", "not"
-    // ... Add all your QuarterLang keywords here
-};
+// --- QuarterLang Reserved Keywords: see QuarterKeywords (generated from the keyword chart) ---
 
 class SyntaxHighlighter {
 public:
@@ -3016,8 +8078,8 @@ public:
             if (std::isalpha(line[i]) || line[i] == '_') {
                 size_t start = i;
                 while (i < n && (std::isalnum(line[i]) || line[i] == '_')) i++;
-                std::string token = line.substr(start, i - start);
-                if (KEYWORDS.count(token))
+                std::string_view token = std::string_view(line).substr(start, i - start);
+                if (QuarterKeywords::isKeyword(token))
                     result << KEYWORD << token << RESET;
                 else
                     result << IDENT << token << RESET;
@@ -3078,6 +8140,8 @@ end
 #include <unordered_set>
 #include <cctype>
 #include <sstream>
+#include <string_view>
+#include "QuarterLang_Keywords.h"
 
 namespace QuarterLang {
 
@@ -3090,12 +8154,7 @@ const std::string STRING  = "\033[1;32m";   // Green/Bold
 const std::string COMMENT = "\033[1;90m";   // Grey
 const std::string SYMBOL  = "\033[1;34m";   // Blue/Bold
 
-// --- QuarterLang Reserved Keywords (update as needed) ---
-const std::unordered_set<std::string> KEYWORDS = {
-    "star", "end", "val", "var", "say", "do", "loop", "to", "as", "if",
-    "else", "match", "break", "continue", "fn", "dg", "type", "in", "not"
-    // ... Add all your QuarterLang keywords here
-};
+// --- QuarterLang Reserved Keywords: see QuarterKeywords (generated from the keyword chart) ---
 
 class SyntaxHighlighter {
 public:
@@ -3143,8 +8202,8 @@ public:
             if (std::isalpha(line[i]) || line[i] == '_') {
                 size_t start = i;
                 while (i < n && (std::isalnum(line[i]) || line[i] == '_')) i++;
-                std::string token = line.substr(start, i - start);
-                if (KEYWORDS.count(token))
+                std::string_view token = std::string_view(line).substr(start, i - start);
+                if (QuarterKeywords::isKeyword(token))
                     result << KEYWORD << token << RESET;
                 else
                     result << IDENT << token << RESET;
@@ -3237,12 +8296,16 @@ private:
 #pragma once
 #include <string>
 #include <vector>
+#include "QuarterLang_SourceBuffer.h"
 
 class QuarterFiler {
 public:
     // Load file content as string
     static bool load(const std::string& filepath, std::string& outContent);
 
+    // Map file content without copying it (preferred for large sources)
+    static bool load(const std::string& filepath, SourceBuffer& outBuffer);
+
     // Save string content to file
     static bool save(const std::string& filepath, const std::string& content);
 
@@ -3267,12 +8330,16 @@ private:
 namespace fs = std::filesystem;
 
 bool QuarterFiler::load(const std::string& filepath, std::string& outContent) {
-    std::ifstream file(filepath, std::ios::in | std::ios::binary);
-    if (!file) return false;
-    outContent.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    SourceBuffer buffer;
+    if (!buffer.open(filepath)) return false;
+    outContent.assign(buffer.data(), buffer.size());
     return true;
 }
 
+bool QuarterFiler::load(const std::string& filepath, SourceBuffer& outBuffer) {
+    return outBuffer.open(filepath);
+}
+
 bool QuarterFiler::save(const std::string& filepath, const std::string& content) {
     std::ofstream file(filepath, std::ios::out | std::ios::binary);
     if (!file) return false;
@@ -3693,7 +8760,9 @@ for (auto& name : libsys.listLibraries()) {
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "QuarterLang_SourceBuffer.h"
 
 // --- Injection Points ---
 const std::string INJECT_BEFORE_STAR = "// [Injected] :: Entering new scope\n";
@@ -3701,13 +8770,11 @@ const std::string INJECT_AFTER_STAR  = "say \"[Injected] Scope started\";\n";
 const std::string INJECT_BEFORE_END  = "say \"[Injected] Scope ending\";\n";
 const std::string INJECT_AFTER_END   = "// [Injected] :: Scope closed\n";
 
-// --- Utility: Read file into string ---
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file) throw std::runtime_error("Could not open file: " + filename);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+// --- Utility: Map file (streamed for pipes and "-") ---
+SourceBuffer readFile(const std::string& filename) {
+    SourceBuffer buffer;
+    if (!buffer.open(filename)) throw std::runtime_error("Could not open file: " + filename);
+    return buffer;
 }
 
 // --- Utility: Write string to file ---
@@ -3718,17 +8785,22 @@ void writeFile(const std::string& filename, const std::string& content) {
 }
 
 // --- Core Injection Function ---
-std::string injectQuarterLang(const std::string& src) {
-    std::istringstream iss(src);
+std::string injectQuarterLang(std::string_view src) {
     std::ostringstream oss;
-    std::string line;
     bool inScope = false;
 
-    while (std::getline(iss, line)) {
+    // Walk the lines as views into the source; only the output is built up
+    for (size_t pos = 0; pos < src.size();) {
+        size_t eol = src.find('\n', pos);
+        if (eol == std::string_view::npos) eol = src.size();
+        std::string_view line = src.substr(pos, eol - pos);
+        pos = eol + 1;
+
         // Detect 'star' and 'end' keywords for injection points
-        std::string trimmed = line;
+        std::string_view trimmed = line;
         // Trim leading spaces
-        trimmed.erase(0, trimmed.find_first_not_of(" \t\r\n"));
+        size_t first = trimmed.find_first_not_of(" \t\r\n");
+        trimmed.remove_prefix(first == std::string_view::npos ? trimmed.size() : first);
 
         if (trimmed == "star") {
             oss << INJECT_BEFORE_STAR;
@@ -3757,8 +8829,8 @@ int main(int argc, char* argv[]) {
     }
 
     try {
-        std::string input = readFile(argv[1]);
-        std::string injected = injectQuarterLang(input);
+        SourceBuffer input = readFile(argv[1]);
+        std::string injected = injectQuarterLang(input.view());
         writeFile(argv[2], injected);
         std::cout << "Injection complete. Output written to " << argv[2] << "\n";
     } catch (const std::exception& ex) {
@@ -4020,7 +9092,7 @@ int main() {
 #include <variant>
 #include <stdexcept>
 #include <memory>
-#include <stack>
+#include <vector>
 
 enum class QType { QInt, QText, QDG, QUnknown };
 
@@ -4039,31 +9111,31 @@ class QuarterMemoryHandler {
 public:
     // Scope-aware: use stack for block-level vars (star ... end)
     void enterScope() {
-        memoryScopes.emplace();
+        memoryScopes.emplace_back();
     }
 
     void exitScope() {
         if (!memoryScopes.empty()) {
-            memoryScopes.pop();
+            memoryScopes.pop_back();
         }
     }
 
     // Allocate a variable or constant
     void allocate(const std::string& name, const QValue& val) {
         if (memoryScopes.empty()) enterScope();
-        if (memoryScopes.top().count(name)) {
+        if (!memoryScopes.back().emplace(name, val).second) {
             throw std::runtime_error("Variable '" + name + "' already exists in this scope.");
         }
-        memoryScopes.top()[name] = val;
     }
 
     // Assign to existing variable
     void assign(const std::string& name, const QValue& val) {
         for (auto it = memoryScopes.rbegin(); it != memoryScopes.rend(); ++it) {
-            if (it->count(name)) {
-                if ((*it)[name].immutable)
+            auto found = it->find(name);
+            if (found != it->end()) {
+                if (found->second.immutable)
                     throw std::runtime_error("Cannot assign to immutable (val) '" + name + "'");
-                (*it)[name] = val;
+                found->second = val;
                 return;
             }
         }
@@ -4073,7 +9145,8 @@ public:
     // Retrieve a value
     QValue get(const std::string& name) const {
         for (auto it = memoryScopes.crbegin(); it != memoryScopes.crend(); ++it) {
-            if (it->count(name)) return it->at(name);
+            auto found = it->find(name);
+            if (found != it->end()) return found->second;
         }
         throw std::runtime_error("Variable '" + name + "' not found");
     }
@@ -4081,7 +9154,7 @@ public:
     // Deallocate a variable from current scope
     void deallocate(const std::string& name) {
         if (!memoryScopes.empty()) {
-            memoryScopes.top().erase(name);
+            memoryScopes.back().erase(name);
         }
     }
 
@@ -4089,7 +9162,7 @@ public:
     void debugPrint() const {
         std::cout << "Memory Handler: Current Scope Vars:\n";
         if (memoryScopes.empty()) return;
-        for (const auto& [k, v] : memoryScopes.top()) {
+        for (const auto& [k, v] : memoryScopes.back()) {
             std::cout << "  " << k << " = ";
             switch (v.type) {
                 case QType::QInt: std::cout << std::get<int>(v.value); break;
@@ -4102,8 +9175,9 @@ public:
     }
 
 private:
-    // Stack of variable tables for block scoping
-    std::stack<std::unordered_map<std::string, QValue>> memoryScopes;
+    // Stack of variable tables for block scoping; innermost last. A vector,
+    // not std::stack, so lookups can walk it outward with one hash per scope.
+    std::vector<std::unordered_map<std::string, QValue>> memoryScopes;
 };
 
 
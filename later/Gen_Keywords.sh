@@ -0,0 +1 @@
+g++ -std=c++17 -O2 QuarterLang_KeywordGen.cpp -o qtr_kwgen && ./qtr_kwgen ../QuarterLang_Statements___Keywords_Chart.csv QuarterLang_Keywords.h
@@ -1,9 +1,9 @@
 Lexer lexer(code);
-Parser parser(lexer.tokenize());
+AST ast;
+Parser parser(lexer.tokenize(), ast);
 auto parsed = parser.parse();
 
-AST ast;
-for (const auto& stmt : parsed) {
+for (auto stmt : parsed) {
     ast.addChild(stmt);
 }
 
@@ -1,15 +1,22 @@
 // QuarterLang_AST.cpp
+// Index-based AST: every node is a row in one vector, addressed by NodeRef,
+// and a node's children are one contiguous run in `links`. Parsing appends,
+// walking touches adjacent memory, and dropping the AST frees it in one go.
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
 #include <string>
 #include <vector>
-#include <memory>
 #include <iostream>
 
-enum class ASTNodeType {
+enum class ASTNodeType : uint8_t {
     VAL_DECL, VAR_DECL, LOOP_STMT,
     TRUTHS_DECL, PROOFS_DECL,
     FUNC_DECL, STRING_LITERAL,
     INT_LITERAL, IDENTIFIER,
+    BINARY_EXPR, UNARY_EXPR, CALL_EXPR,  // value: operator / callee name
     ROOT
 };
 
@@ -24,29 +31,85 @@ std::string ASTNodeTypeToString(ASTNodeType type) {
         case ASTNodeType::STRING_LITERAL: return "StringLiteral";
         case ASTNodeType::INT_LITERAL: return "IntLiteral";
         case ASTNodeType::IDENTIFIER: return "Identifier";
+        case ASTNodeType::BINARY_EXPR: return "BinaryExpr";
+        case ASTNodeType::UNARY_EXPR: return "UnaryExpr";
+        case ASTNodeType::CALL_EXPR: return "CallExpr";
         case ASTNodeType::ROOT: return "Root";
         default: return "Unknown";
     }
 }
 
+using NodeRef = uint32_t;
+
 struct ASTNode {
     ASTNodeType type;
     std::string value;
-    std::vector<std::shared_ptr<ASTNode>> children;
-
-    ASTNode(ASTNodeType t, const std::string& v = "") : type(t), value(v) {}
+    uint32_t firstChild = 0;  // index into AST::links
+    uint32_t childCount = 0;
 };
 
 class AST {
 public:
-    std::shared_ptr<ASTNode> root;
+    std::vector<ASTNode> nodes;
+    std::vector<NodeRef> links;  // children runs, back to back
+    NodeRef root;
 
     AST() {
-        root = std::make_shared<ASTNode>(ASTNodeType::ROOT);
+        root = make(ASTNodeType::ROOT);
+    }
+
+    NodeRef make(ASTNodeType t, const std::string& v = "", std::initializer_list<NodeRef> kids = {}) {
+        return append(t, v, kids.begin(), kids.size());
+    }
+
+    NodeRef make(ASTNodeType t, const std::string& v, const std::vector<NodeRef>& kids) {
+        return append(t, v, kids.data(), kids.size());
+    }
+
+    const ASTNode& node(NodeRef n) const { return nodes[n]; }
+    NodeRef child(NodeRef n, size_t i) const { return links[nodes[n].firstChild + i]; }
+    size_t childCount(NodeRef n) const { return nodes[n].childCount; }
+
+    // Appends a top-level statement. The root's run stays contiguous and keeps
+    // spare slots after it; when they run out it grows in place if it is the
+    // newest run, else moves to the end with double the room. A REPL adding
+    // one statement at a time therefore copies each statement O(1) times.
+    void addChild(NodeRef n) {
+        ASTNode& r = nodes[root];
+        if (r.childCount == rootCapacity) {
+            const uint32_t capacity = std::max<uint32_t>(16, rootCapacity * 2);
+            if (r.firstChild + rootCapacity == links.size()) {
+                links.resize(r.firstChild + capacity);
+            } else {
+                const uint32_t moved = static_cast<uint32_t>(links.size());
+                links.resize(moved + capacity);
+                std::copy_n(links.begin() + r.firstChild, r.childCount, links.begin() + moved);
+                r.firstChild = moved;
+            }
+            rootCapacity = capacity;
+        }
+        links[r.firstChild + r.childCount++] = n;
     }
 
-    void addChild(const std::shared_ptr<ASTNode>& node) {
-        root->children.push_back(node);
+    // Moves another AST's nodes in after this one's (its root comes along as
+    // an unused node) and returns `roots` renumbered into this AST.
+    std::vector<NodeRef> adopt(AST&& other, const std::vector<NodeRef>& roots) {
+        const NodeRef base = static_cast<NodeRef>(nodes.size());
+        const uint32_t linkBase = static_cast<uint32_t>(links.size());
+        for (ASTNode& n : other.nodes) n.firstChild += linkBase;
+        for (NodeRef& c : other.links) c += base;
+        // insert() keeps geometric growth; an exact reserve per file would
+        // reallocate on every merge.
+        nodes.insert(nodes.end(), std::make_move_iterator(other.nodes.begin()),
+                     std::make_move_iterator(other.nodes.end()));
+        links.insert(links.end(), other.links.begin(), other.links.end());
+
+        std::vector<NodeRef> moved;
+        moved.reserve(roots.size());
+        for (NodeRef r : roots) moved.push_back(r + base);
+        other.nodes.clear();
+        other.links.clear();
+        return moved;
     }
 
     void print() const {
@@ -55,15 +118,24 @@ public:
     }
 
 private:
-    void printNode(const std::shared_ptr<ASTNode>& node, int indent) const {
+    uint32_t rootCapacity = 0;  // slots reserved for the root's run
+
+    NodeRef append(ASTNodeType t, const std::string& v, const NodeRef* kids, size_t count) {
+        NodeRef id = static_cast<NodeRef>(nodes.size());
+        nodes.push_back({t, v, static_cast<uint32_t>(links.size()), static_cast<uint32_t>(count)});
+        links.insert(links.end(), kids, kids + count);
+        return id;
+    }
+
+    void printNode(NodeRef n, int indent) const {
         for (int i = 0; i < indent; ++i) std::cout << "  ";
-        std::cout << ASTNodeTypeToString(node->type);
-        if (!node->value.empty())
-            std::cout << ": " << node->value;
+        std::cout << ASTNodeTypeToString(nodes[n].type);
+        if (!nodes[n].value.empty())
+            std::cout << ": " << nodes[n].value;
         std::cout << std::endl;
 
-        for (const auto& child : node->children) {
-            printNode(child, indent + 1);
+        for (size_t i = 0; i < childCount(n); ++i) {
+            printNode(child(n, i), indent + 1);
         }
     }
 };
@@ -0,0 +1,471 @@
+// QuarterLang_AsyncIO.h
+// Whole-file reads and writes that run in the background, so a build that
+// reads many sources or writes many outputs has them all in flight at once
+// instead of one after another. On Linux the transfers go to the kernel
+// through an io_uring: one system call submits a request, and one thread
+// collects every completion. Where no ring can be had (other systems, old
+// kernels, containers that filter the call) a few threads do plain blocking
+// I/O instead; callers cannot tell the difference.
+//
+// Every operation reports to a callback once it is over, on an I/O thread
+// (or on the caller's, if the file could not even be opened). Callbacks
+// hold that thread up: they must be short, must not throw, and must not
+// start or wait for other AsyncIO operations. Batch is there for callers
+// that just want to wait. Operations on the same path string run in the
+// order they were issued, so a read that follows a write sees what was
+// written.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define QTR_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#undef BLOCK_SIZE  // from the <linux/fs.h> it pulls in; too common a name to leave defined
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+class AsyncIO {
+public:
+    using ReadDone = std::function<void(std::string data, std::exception_ptr error)>;
+    using WriteDone = std::function<void(std::exception_ptr error)>;
+
+    static constexpr unsigned MAX_IN_FLIGHT = 256;  // further requests wait for room
+
+    // The process-wide instance; it starts on first use.
+    static AsyncIO& global() {
+        static AsyncIO instance;
+        return instance;
+    }
+
+    // `useRing` false forces the thread pool.
+    explicit AsyncIO(bool useRing = true, unsigned threads = 4) {
+#ifdef QTR_IO_URING
+        if (useRing) ring = Ring::open(MAX_IN_FLIGHT);
+        if (ring) {
+            reaper = std::thread([this] { reap(); });
+            return;
+        }
+#endif
+        (void)useRing;
+        for (unsigned i = 0; i < std::max(1u, threads); ++i) pool.emplace_back([this] { serve(); });
+    }
+    AsyncIO(const AsyncIO&) = delete;
+    AsyncIO& operator=(const AsyncIO&) = delete;
+
+    // Waits for everything issued so far.
+    ~AsyncIO() {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            room.wait(guard, [this] { return issued == 0; });
+            stopping = true;
+        }
+        work.notify_all();
+        for (std::thread& t : pool) t.join();
+#ifdef QTR_IO_URING
+        if (ring) {
+            ring->stop();
+            reaper.join();
+        }
+#endif
+    }
+
+    const char* backend() const { return usingRing() ? "io_uring" : "threads"; }
+
+    // The whole file, or an error saying why not.
+    void read(std::string path, ReadDone done) {
+        auto op = std::make_unique<Op>();
+        op->path = std::move(path);
+        op->onRead = std::move(done);
+        issue(std::move(op));
+    }
+
+    // Replaces the file with `data`, or appends it.
+    void write(std::string path, std::string data, bool append, WriteDone done) {
+        auto op = std::make_unique<Op>();
+        op->path = std::move(path);
+        op->data = std::move(data);
+        op->writing = true;
+        op->append = append;
+        op->onWrite = std::move(done);
+        issue(std::move(op));
+    }
+
+    // A set of operations to wait for together. Any thread may add to it.
+    class Batch {
+    public:
+        explicit Batch(AsyncIO& io = AsyncIO::global()) : io(io) {}
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+        ~Batch() {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [this] { return pending == 0; });
+        }
+
+        // `into` must stay put until wait() returns.
+        void read(std::string path, std::string& into) {
+            start();
+            io.read(std::move(path), [this, &into](std::string data, std::exception_ptr error) {
+                into = std::move(data);
+                finish(error);
+            });
+        }
+        // `then`, if given, is told how the write went instead of wait().
+        void write(std::string path, std::string data, bool append = false, WriteDone then = nullptr) {
+            start();
+            io.write(std::move(path), std::move(data), append,
+                     [this, then = std::move(then)](std::exception_ptr error) {
+                         if (then) {
+                             then(error);
+                             error = nullptr;
+                         }
+                         finish(error);
+                     });
+        }
+
+        // Returns once all of it is over; rethrows the first error.
+        void wait() {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [this] { return pending == 0; });
+            std::exception_ptr first;
+            std::swap(first, error);
+            guard.unlock();
+            if (first) std::rethrow_exception(first);
+        }
+
+    private:
+        AsyncIO& io;
+        std::mutex lock;
+        std::condition_variable finished;
+        size_t pending = 0;
+        std::exception_ptr error;
+
+        void start() {
+            std::lock_guard<std::mutex> guard(lock);
+            ++pending;
+        }
+        // Notifies under the lock: once pending is 0 the batch may be gone.
+        void finish(std::exception_ptr failure) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (failure && !error) error = failure;
+            if (--pending == 0) finished.notify_all();
+        }
+    };
+
+private:
+    struct Op {
+        std::string path;
+        std::string data;  // read into, or written from
+        bool writing = false;
+        bool append = false;
+        ReadDone onRead;
+        WriteDone onWrite;
+#ifdef QTR_IO_URING
+        int fd = -1;
+        bool sized = false;  // a regular file: stop at its size
+        size_t done = 0;     // bytes moved so far
+        iovec piece{};
+#endif
+    };
+
+    std::mutex lock;
+    std::condition_variable room;  // issued dropped below MAX_IN_FLIGHT
+    std::condition_variable work;  // pool: queue or stopping changed
+    size_t issued = 0;             // started and not yet finished
+    bool stopping = false;
+    std::unordered_map<std::string, std::deque<std::unique_ptr<Op>>> byPath;  // front: the one running
+    std::deque<Op*> queue;         // pool only
+    std::vector<std::thread> pool;
+
+    bool usingRing() const {
+#ifdef QTR_IO_URING
+        return ring != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    void issue(std::unique_ptr<Op> op) {
+        Op* runNow = nullptr;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            room.wait(guard, [this] { return issued < MAX_IN_FLIGHT; });
+            ++issued;
+            auto& line = byPath[op->path];
+            line.push_back(std::move(op));
+            if (line.size() == 1) runNow = line.front().get();
+        }
+        if (runNow) begin(*runNow);
+    }
+
+    void begin(Op& op) {
+#ifdef QTR_IO_URING
+        if (ring) {
+            startRing(op);
+            return;
+        }
+#endif
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(&op);
+        }
+        work.notify_one();
+    }
+
+    // Reports the result, then starts whatever was waiting on the same path.
+    void finish(Op& op, int error) {
+        std::exception_ptr failure;
+        if (error) {
+            failure = std::make_exception_ptr(std::runtime_error(
+                std::string(op.writing ? "Cannot write '" : "Cannot read '") + op.path + "': " + std::strerror(error)));
+        }
+        if (op.writing) op.onWrite(failure);
+        else op.onRead(failure ? std::string() : std::move(op.data), failure);
+
+        std::unique_ptr<Op> over;
+        Op* next = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = byPath.find(op.path);
+            over = std::move(it->second.front());
+            it->second.pop_front();
+            if (it->second.empty()) byPath.erase(it);
+            else next = it->second.front().get();
+            --issued;
+        }
+        room.notify_all();
+        if (next) begin(*next);
+    }
+
+    // --- Thread pool ---
+    void serve() {
+        for (;;) {
+            Op* op;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                work.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                op = queue.front();
+                queue.pop_front();
+            }
+            errno = 0;
+            int error = op->writing ? writeBlocking(*op) : readBlocking(*op);
+            finish(*op, error);
+        }
+    }
+    static int readBlocking(Op& op) {
+        std::ifstream in(op.path, std::ios::binary);
+        if (!in) return errno ? errno : ENOENT;
+        std::ostringstream bytes;
+        bytes << in.rdbuf();
+        if (in.bad()) return errno ? errno : EIO;
+        op.data = std::move(bytes).str();
+        return 0;
+    }
+    static int writeBlocking(Op& op) {
+        std::ofstream out(op.path, std::ios::binary | (op.append ? std::ios::app : std::ios::trunc));
+        if (!out) return errno ? errno : EACCES;
+        out.write(op.data.data(), static_cast<std::streamsize>(op.data.size()));
+        out.close();
+        if (!out) return errno ? errno : EIO;
+        return 0;
+    }
+
+#ifdef QTR_IO_URING
+    // --- io_uring ---
+    // The submission and completion queues are shared memory with the
+    // kernel: we fill in a request and move the tail, the kernel moves the
+    // head, and the other way round for completions. Every operation has at
+    // most one request in the ring, and there are never more operations
+    // than MAX_IN_FLIGHT, so the completion queue (twice the size) cannot
+    // overflow.
+    class Ring {
+    public:
+        static std::unique_ptr<Ring> open(unsigned entries) {
+            io_uring_params params{};
+            int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) return nullptr;
+            std::unique_ptr<Ring> ring(new Ring(fd));
+            return ring->map(params) ? std::move(ring) : nullptr;
+        }
+        ~Ring() {
+            if (sqes) munmap(sqes, sqeBytes);
+            if (cqRing && cqRing != sqRing) munmap(cqRing, cqBytes);
+            if (sqRing) munmap(sqRing, sqBytes);
+            close(fd);
+        }
+
+        // Any thread; `user` comes back with the completion.
+        void submit(uint8_t opcode, int file, const iovec* piece, uint64_t offset, void* user) {
+            std::lock_guard<std::mutex> guard(submitLock);
+            unsigned tail = *sqTail;  // only ever written here
+            unsigned index = tail & *sqMask;
+            io_uring_sqe& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof sqe);
+            sqe.opcode = opcode;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<uint64_t>(piece);
+            sqe.len = piece ? 1 : 0;
+            sqe.off = offset;
+            sqe.user_data = reinterpret_cast<uint64_t>(user);
+            sqArray[index] = index;
+            submitted.fetch_add(1, std::memory_order_release);
+            __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+            while (syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0) < 0 &&
+                   (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+                std::this_thread::yield();
+            }
+        }
+
+        // The reaper only. Blocks until at least one completion is there,
+        // then hands each to `handle` as (user, result).
+        template <typename Handle>
+        void complete(Handle handle) {
+            unsigned head = *cqHead;  // only ever written here
+            if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                return;  // woken, or interrupted: look again
+            }
+            do {
+                submitted.load(std::memory_order_acquire);
+                const io_uring_cqe& cqe = cqes[head & *cqMask];
+                void* user = reinterpret_cast<void*>(cqe.user_data);
+                int result = cqe.res;
+                __atomic_store_n(cqHead, ++head, __ATOMIC_RELEASE);
+                handle(user, result);
+            } while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE));
+        }
+
+        // A request with no user: the reaper's cue to return.
+        void stop() { submit(IORING_OP_NOP, -1, nullptr, 0, nullptr); }
+
+    private:
+        int fd;
+        std::mutex submitLock;
+        // The kernel passes each request from the submitter to the reaper,
+        // which neither the C++ memory model nor a race detector can see;
+        // releasing this before a submit and acquiring it after completions
+        // arrive says that whatever the submitter wrote is visible.
+        std::atomic<uint64_t> submitted{0};
+        void* sqRing = nullptr;
+        void* cqRing = nullptr;
+        size_t sqBytes = 0, cqBytes = 0, sqeBytes = 0;
+        unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+        unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+        io_uring_sqe* sqes = nullptr;
+        io_uring_cqe* cqes = nullptr;
+
+        explicit Ring(int file) : fd(file) {}
+
+        bool map(const io_uring_params& p) {
+            sqBytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            cqBytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) sqBytes = cqBytes = std::max(sqBytes, cqBytes);
+            sqRing = mmap(nullptr, sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sqRing == MAP_FAILED) return sqRing = nullptr, false;
+            cqRing = single ? sqRing
+                            : mmap(nullptr, cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                   IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) return cqRing = nullptr, false;
+            sqeBytes = p.sq_entries * sizeof(io_uring_sqe);
+            void* entries = mmap(nullptr, sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_SQES);
+            if (entries == MAP_FAILED) return false;
+            sqes = static_cast<io_uring_sqe*>(entries);
+
+            char* sq = static_cast<char*>(sqRing);
+            sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            sqMask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            char* cq = static_cast<char*>(cqRing);
+            cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            cqMask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+            return true;
+        }
+    };
+
+    static constexpr size_t UNSIZED_CHUNK = 1 << 16;  // pipes, /proc and the like
+
+    std::unique_ptr<Ring> ring;
+    std::thread reaper;
+
+    // Opening stays synchronous; only the transfers go through the ring.
+    void startRing(Op& op) {
+        int flags = op.writing ? O_WRONLY | O_CREAT | (op.append ? O_APPEND : O_TRUNC) : O_RDONLY;
+        op.fd = ::open(op.path.c_str(), flags | O_CLOEXEC, 0644);
+        if (op.fd < 0) {
+            finish(op, errno);
+            return;
+        }
+        if (!op.writing) {
+            struct stat st {};
+            op.sized = fstat(op.fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+            op.data.resize(op.sized ? static_cast<size_t>(st.st_size) : UNSIZED_CHUNK);
+        }
+        if (op.data.empty()) {
+            endRing(op, 0);  // an empty write
+            return;
+        }
+        submitRing(op);
+    }
+    void submitRing(Op& op) {
+        op.piece = {op.data.data() + op.done, op.data.size() - op.done};
+        ring->submit(op.writing ? IORING_OP_WRITEV : IORING_OP_READV, op.fd, &op.piece, op.done, &op);
+    }
+    void endRing(Op& op, int error) {
+        ::close(op.fd);
+        op.fd = -1;
+        finish(op, error);
+    }
+
+    void reap() {
+        bool running = true;
+        while (running) {
+            ring->complete([&](void* user, int result) {
+                if (!user) {
+                    running = false;
+                    return;
+                }
+                Op& op = *static_cast<Op*>(user);
+                if (result == -EINTR || result == -EAGAIN) return submitRing(op);
+                if (result < 0) return endRing(op, -result);
+                if (result == 0) {
+                    if (op.writing) return endRing(op, EIO);
+                    op.data.resize(op.done);  // end of file
+                    return endRing(op, 0);
+                }
+                op.done += static_cast<size_t>(result);
+                if (op.done < op.data.size()) return submitRing(op);
+                if (op.writing || op.sized) return endRing(op, 0);
+                op.data.resize(op.data.size() * 2);  // unsized: read until end of file
+                submitRing(op);
+            });
+        }
+    }
+#endif
+};
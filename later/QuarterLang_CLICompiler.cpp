@@ -7,17 +7,16 @@
 #include "QuarterLang_CodeGenerator.cpp"
 #include "QuarterLang_BinaryEmitter.cpp"
 
-#include <fstream>
+#include "QuarterLang_SourceBuffer.h"
 
-std::string readFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) {
+// Maps the source ("-" streams stdin); tokens borrow from the returned buffer.
+SourceBuffer readFile(const std::string& path) {
+    SourceBuffer buffer;
+    if (!buffer.open(path)) {
         std::cerr << "❌ Cannot open source file: " << path << std::endl;
         exit(1);
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return buffer;
 }
 
 int main(int argc, char** argv) {
@@ -30,21 +29,21 @@ int main(int argc, char** argv) {
     std::string asmOutput = "output.asm";
 
     std::cout << "🔍 Reading source: " << sourcePath << "\n";
-    std::string source = readFile(sourcePath);
+    SourceBuffer source = readFile(sourcePath);
 
     // 1️⃣ LEXER
-    Lexer lexer(source);
+    Lexer lexer(source.view());
     auto tokens = lexer.tokenize();
     std::cout << "✅ Lexing complete: " << tokens.size() << " tokens\n";
 
     // 2️⃣ PARSER
-    Parser parser(tokens);
+    AST ast;
+    Parser parser(tokens, ast);
     auto astNodes = parser.parse();
     std::cout << "✅ Parsing complete: " << astNodes.size() << " root-level nodes\n";
 
     // 3️⃣ AST WRAP
-    AST ast;
-    for (auto& node : astNodes)
+    for (auto node : astNodes)
         ast.addChild(node);
 
     // Optional: Debug tree
@@ -52,7 +51,7 @@ int main(int argc, char** argv) {
 
     // 4️⃣ IR GEN
     IRGenerator irgen;
-    auto rawIR = irgen.generate(ast.root);
+    auto rawIR = irgen.generate(ast);
     std::cout << "✅ IR generated: " << rawIR.size() << " instructions\n";
 
     // 5️⃣ OPTIMIZER
@@ -72,39 +71,44 @@ int main(int argc, char** argv) {
 }
 
 #include "QuarterLang_ProjectLoader.cpp"
+#include "QuarterLang_ParallelFrontEnd.cpp"
 
 int main(int argc, char** argv) {
     if (argc < 2) {
-        std::cerr << "Usage: qtrc <file.qtr | project.qtrproj>\n";
+        std::cerr << "Usage: qtrc <file.qtr | project.qtrproj> [--no-cache] [--cache-dir <dir>]\n";
         return 1;
     }
 
     std::string entry = argv[1];
     std::vector<std::string> files;
+    bool useCache = true;
+    std::string cacheDir;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-cache") useCache = false;
+        else if (arg == "--cache-dir" && i + 1 < argc) cacheDir = argv[++i];
+    }
 
     if (entry.ends_with(".qtrproj")) {
         files = QuarterProjectLoader::loadSourcesFromProject(entry);
     } else {
         files.push_back(entry);
     }
+    if (cacheDir.empty())
+        cacheDir = (std::filesystem::path(entry).parent_path() / ".qtrcache").string();
 
-    AST ast;
-    for (const auto& f : files) {
-        std::string code = QuarterProjectLoader::readFile(f);
-        Lexer lexer(code);
-        Parser parser(lexer.tokenize());
-        auto nodes = parser.parse();
-        for (auto& n : nodes)
-            ast.addChild(n);
-    }
+    // Files are compiled to optimized IR in parallel; unchanged files come
+    // straight from the cache. Output and errors are in project order either
+    // way, so the result is the same on every run.
+    ErrorHandler errors;
+    IRCache cache(useCache ? cacheDir : "", "opt=default");
+    std::vector<IRInstruction> optIR = ParallelFrontEnd().compile(files, cache, errors);
+    errors.throwIfErrors();
+    cache.flush();
+    if (useCache) cache.report();
 
-    std::cout << "📦 Project parsed: " << files.size() << " files\n";
-
-    IRGenerator irgen;
-    auto rawIR = irgen.generate(ast.root);
-
-    Optimizer opt;
-    auto optIR = opt.optimize(rawIR);
+    std::cout << "📦 Project compiled: " << files.size() << " files\n";
 
     CodeGenerator codegen(optIR);
     codegen.generate("output.asm");
@@ -114,4 +118,3 @@ int main(int argc, char** argv) {
 
     return 0;
 }
-
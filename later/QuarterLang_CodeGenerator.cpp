@@ -73,6 +73,12 @@ private:
                     nasm << "  ; DodecaGram: " << instr.arg << " | 0x" << instr.hex << "\n";
                     break;
 
+                case IROpcode::IR_BINOP:
+                case IROpcode::IR_UNOP:
+                case IROpcode::IR_CALL:
+                    nasm << "  ; " << instr.opcodeToStr(instr.op) << " " << instr.arg << "\n";
+                    break;
+
                 default:
                     nasm << "  ; [NOP]\n";
                     break;
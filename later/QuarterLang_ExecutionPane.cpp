@@ -1,36 +1,55 @@
 // QuarterLang_ExecutionPane.cpp
 #pragma once
+#include "QuarterLang_Parser.cpp"
 #include "QuarterLang_Runtime.cpp"
+#include "QuarterLang_IncrementalLexer.cpp"
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <mutex>
 
 class ExecutionPane {
 private:
     std::atomic<bool> running;
-    std::string currentCode;
     std::thread execThread;
+    std::mutex codeMutex;           // guards editorLexer and tokenSnapshot
+    IncrementalLexer editorLexer;   // edits re-lex only the damaged region
+    std::vector<Token> tokenSnapshot;
+    bool tokensDirty = true;
 
 public:
     ExecutionPane() : running(false) {}
 
     void start(const std::string& code) {
-        currentCode = code;
         if (running) stop();
+        {
+            std::lock_guard<std::mutex> lock(codeMutex);
+            editorLexer.reset(code);
+            tokensDirty = true;
+        }
         running = true;
 
         execThread = std::thread([&]() {
             while (running) {
                 clearScreen();
                 std::cout << "🔁 Live QuarterLang Execution\n";
-                executeCode(currentCode);
+                executeCode(currentTokens());
                 std::this_thread::sleep_for(std::chrono::seconds(2));
             }
         });
     }
 
     void updateCode(const std::string& newCode) {
-        currentCode = newCode;
+        std::lock_guard<std::mutex> lock(codeMutex);
+        editorLexer.update(newCode);
+        tokensDirty = true;
+    }
+
+    // Editor hook: `removed` bytes at `offset` were replaced by `inserted`.
+    void applyEdit(size_t offset, size_t removed, const std::string& inserted) {
+        std::lock_guard<std::mutex> lock(codeMutex);
+        editorLexer.edit(offset, removed, inserted);
+        tokensDirty = true;
     }
 
     void stop() {
@@ -43,18 +62,28 @@ public:
     }
 
 private:
-    void executeCode(const std::string& code) {
-        Lexer lexer(code);
-        auto tokens = lexer.tokenize();
-
-        Parser parser(tokens);
-        auto nodes = parser.parse();
+    std::vector<Token> currentTokens() {
+        std::lock_guard<std::mutex> lock(codeMutex);
+        if (tokensDirty) {
+            tokenSnapshot = editorLexer.tokens();
+            tokensDirty = false;
+        }
+        return tokenSnapshot;
+    }
 
+    void executeCode(const std::vector<Token>& tokens) {
         AST ast;
-        for (const auto& n : nodes) ast.addChild(n);
+        ErrorHandler errors;
+        Parser parser(tokens, ast, errors);
+        auto nodes = parser.parse();
+        if (errors.hasErrors()) {
+            errors.report();  // mid-edit code is often broken; wait for the next change
+            return;
+        }
+        for (auto n : nodes) ast.addChild(n);
 
         QuarterRuntime rt;
-        rt.execute(ast.root);
+        rt.execute(ast);
     }
 
     void clearScreen() {
@@ -1,6 +1,7 @@
 // QuarterLang_IDEPlugin.cpp
 #pragma once
 #include "QuarterLang_CLICompiler.cpp"
+#include "QuarterLang_IncrementalLexer.cpp"
 #include <filesystem>
 #include <thread>
 #include <chrono>
@@ -10,6 +11,7 @@ private:
     std::string currentFile;
     std::string diagnostics;
     std::string compileOutput;
+    IncrementalLexer editorLexer;  // survives rebuilds; only changed regions are re-lexed
     bool autoBuild = true;
 
 public:
@@ -37,19 +39,25 @@ public:
 private:
     void runCompiler(const std::string& sourceFile) {
         // 1. Read source
-        std::string src = readFile(sourceFile);
-        Lexer lexer(src);
-        auto tokens = lexer.tokenize();
+        SourceBuffer src = readFile(sourceFile);
+        editorLexer.update(src.view());
+        auto tokens = editorLexer.tokens();
 
-        Parser parser(tokens);
+        AST ast;
+        ErrorHandler errors;
+        Parser parser(tokens, ast, errors);
         auto astNodes = parser.parse();
 
-        AST ast;
-        for (auto& node : astNodes)
+        diagnostics = "[Diagnostics]\n";
+        for (const Error& err : errors.all())
+            diagnostics += "⚠️ " + ErrorHandler::format(err) + ": " + err.message + "\n";
+        if (errors.hasErrors()) return;
+
+        for (auto node : astNodes)
             ast.addChild(node);
 
         IRGenerator irgen;
-        auto ir = irgen.generate(ast.root);
+        auto ir = irgen.generate(ast);
 
         Optimizer opt;
         auto optimized = opt.optimize(ir);
@@ -57,18 +65,10 @@ private:
         CodeGenerator cg(optimized);
         std::string asmPath = "ide_output.asm";
         cg.generate(asmPath);
-        compileOutput = readFile(asmPath);
+        compileOutput = std::string(readFile(asmPath).view());
 
         BinaryEmitter be(asmPath);
         be.build();
-
-        // Populate diagnostics with dummy error messages
-        diagnostics = "[Diagnostics]\n";
-        for (auto& token : tokens) {
-            if (token.lexeme == "ERROR") {
-                diagnostics += "⚠️ Syntax error at line " + std::to_string(token.line) + "\n";
-            }
-        }
     }
 };
 
@@ -87,7 +87,7 @@ private:
 
 public:
     void loadFile(const std::string& path) {
-        currentSource = readFile(path);
+        currentSource = std::string(readFile(path).view());
         execPane.start(currentSource);  // 💥 Live execution from IDE
     }
 
@@ -96,6 +96,11 @@ public:
         execPane.updateCode(newCode);  // 💥 Hot swap running code
     }
 
+    void applyEdit(size_t offset, size_t removed, const std::string& inserted) {
+        currentSource.replace(std::min(offset, currentSource.size()), removed, inserted);
+        execPane.applyEdit(offset, removed, inserted);  // ⚡ Re-lex only the edited span
+    }
+
     void stopExecution() {
         execPane.stop();
     }
@@ -7,7 +7,9 @@
 
 enum class IROpcode {
     IR_VAL, IR_VAR, IR_LOOP, IR_TRUTH, IR_PROOF,
-    IR_LOAD_STR, IR_LOAD_INT, IR_DG_SYMBOL, IR_NOP
+    IR_LOAD_STR, IR_LOAD_INT, IR_DG_SYMBOL,
+    IR_BINOP, IR_UNOP, IR_CALL,  // operands are the preceding loads (postfix order)
+    IR_NOP
 };
 
 struct IRInstruction {
@@ -33,6 +35,9 @@ struct IRInstruction {
             case IROpcode::IR_LOAD_STR: return "LOAD_STR";
             case IROpcode::IR_LOAD_INT: return "LOAD_INT";
             case IROpcode::IR_DG_SYMBOL: return "DODECAGRAM";
+            case IROpcode::IR_BINOP: return "BINOP";
+            case IROpcode::IR_UNOP: return "UNOP";
+            case IROpcode::IR_CALL: return "CALL";
             default: return "NOP";
         }
     }
@@ -41,56 +46,73 @@ struct IRInstruction {
 class IRGenerator {
 private:
     std::vector<IRInstruction> instructions;
+    const AST* ast = nullptr;
 
 public:
-    std::vector<IRInstruction> generate(const std::shared_ptr<ASTNode>& node) {
-        walk(node);
+    std::vector<IRInstruction> generate(const AST& tree) {
+        ast = &tree;
+        walk(tree.root);
         return instructions;
     }
 
-    void walk(const std::shared_ptr<ASTNode>& node) {
-        switch (node->type) {
+    void walk(NodeRef n) {
+        const ASTNode& node = ast->node(n);
+        switch (node.type) {
             case ASTNodeType::VAL_DECL:
-                emit(IROpcode::IR_VAL, node->value);
-                walk(node->children[0]); // type
-                walk(node->children[1]); // value
+                emit(IROpcode::IR_VAL, node.value);
+                walk(ast->child(n, 0)); // type
+                walk(ast->child(n, 1)); // value
                 break;
             case ASTNodeType::VAR_DECL:
-                emit(IROpcode::IR_VAR, node->value);
-                walk(node->children[0]);
-                walk(node->children[1]);
+                emit(IROpcode::IR_VAR, node.value);
+                walk(ast->child(n, 0));
+                walk(ast->child(n, 1));
                 break;
             case ASTNodeType::INT_LITERAL:
-                emit(IROpcode::IR_LOAD_INT, node->value, intToHex(std::stoi(node->value)));
+                emit(IROpcode::IR_LOAD_INT, node.value, intToHex(std::stoi(node.value)));
                 break;
             case ASTNodeType::STRING_LITERAL:
-                emit(IROpcode::IR_LOAD_STR, node->value, strToHex(node->value));
+                emit(IROpcode::IR_LOAD_STR, node.value, strToHex(node.value));
                 break;
             case ASTNodeType::IDENTIFIER:
                 // Potential dodecagram encoding if symbol is DG
-                if (isDodecaGram(node->value)) {
-                    emit(IROpcode::IR_DG_SYMBOL, node->value, encodeDodecaGram(node->value));
+                if (isDodecaGram(node.value)) {
+                    emit(IROpcode::IR_DG_SYMBOL, node.value, encodeDodecaGram(node.value));
                 } else {
-                    emit(IROpcode::IR_LOAD_STR, node->value);
+                    emit(IROpcode::IR_LOAD_STR, node.value);
                 }
                 break;
+            case ASTNodeType::BINARY_EXPR:
+                walk(ast->child(n, 0));
+                walk(ast->child(n, 1));
+                emit(IROpcode::IR_BINOP, node.value);
+                break;
+            case ASTNodeType::UNARY_EXPR:
+                walk(ast->child(n, 0));
+                emit(IROpcode::IR_UNOP, node.value);
+                break;
+            case ASTNodeType::CALL_EXPR:
+                for (size_t i = 0; i < ast->childCount(n); ++i)
+                    walk(ast->child(n, i));
+                emit(IROpcode::IR_CALL, node.value, intToHex(static_cast<int>(ast->childCount(n)))); // hex: argc
+                break;
             case ASTNodeType::TRUTHS_DECL:
-                for (const auto& child : node->children)
-                    emit(IROpcode::IR_TRUTH, child->value);
+                for (size_t i = 0; i < ast->childCount(n); ++i)
+                    emit(IROpcode::IR_TRUTH, ast->node(ast->child(n, i)).value);
                 break;
             case ASTNodeType::PROOFS_DECL:
-                emit(IROpcode::IR_PROOF, node->value);
-                walk(node->children[0]);
-                walk(node->children[1]);
+                emit(IROpcode::IR_PROOF, node.value);
+                walk(ast->child(n, 0));
+                walk(ast->child(n, 1));
                 break;
             case ASTNodeType::LOOP_STMT:
                 emit(IROpcode::IR_LOOP, "loop_start");
-                walk(node->children[0]); // from
-                walk(node->children[1]); // to
+                walk(ast->child(n, 0)); // from
+                walk(ast->child(n, 1)); // to
                 break;
             case ASTNodeType::ROOT:
-                for (const auto& child : node->children)
-                    walk(child);
+                for (size_t i = 0; i < ast->childCount(n); ++i)
+                    walk(ast->child(n, i));
                 break;
             default:
                 emit(IROpcode::IR_NOP, "unknown_node");
@@ -0,0 +1,166 @@
+// QuarterLang_IRCache.cpp
+// On-disk cache of per-file IR. An entry is keyed by a hash of the source
+// bytes, the compiler version and the option set, so any change to one of
+// them is a miss; nothing is ever invalidated in place. Entries are written
+// to a temp file and renamed, so a crashed or concurrent build never leaves
+// a torn entry behind. The writes run in the background (see AsyncIO), so
+// storing an entry does not hold up the worker that compiled it.
+#pragma once
+#include "QuarterLang_IRBytecode.cpp"
+#include "QuarterLang_AsyncIO.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef QUARTER_COMPILER_VERSION
+#define QUARTER_COMPILER_VERSION "qtrc-0.1"
+#endif
+
+// Raw and optimized IR for one source file.
+struct CachedIR {
+    std::vector<IRInstruction> raw;
+    std::vector<IRInstruction> optimized;
+};
+
+class IRCache {
+public:
+    static constexpr const char* MAGIC = "QIRCACHE 1";
+
+    struct Stats {
+        std::atomic<size_t> hits{0};
+        std::atomic<size_t> misses{0};
+        std::atomic<size_t> writes{0};
+        std::atomic<size_t> bytesRead{0};  // source bytes whose front end was skipped
+    };
+
+    // An empty directory disables the cache: every lookup misses and nothing
+    // is written.
+    IRCache(std::string directory, std::string options)
+        : dir(std::move(directory)), optionSet(std::move(options)) {
+        if (dir.empty()) return;
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        enabled = !ec;
+    }
+
+    // 64-bit FNV-1a over the source, the compiler version and the options.
+    std::string keyFor(std::string_view source) const {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&h](std::string_view bytes) {
+            for (unsigned char c : bytes) {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            h ^= 0xff;  // separator, so "ab"+"c" and "a"+"bc" differ
+            h *= 1099511628211ull;
+        };
+        mix(source);
+        mix(QUARTER_COMPILER_VERSION);
+        mix(optionSet);
+        std::ostringstream out;
+        out << std::hex;
+        out.width(16);
+        out.fill('0');
+        out << h << '-' << source.size();
+        return out.str();
+    }
+
+    bool load(const std::string& key, CachedIR& out, size_t sourceBytes) {
+        if (enabled) {
+            std::ifstream in(pathFor(key), std::ios::binary);
+            std::string magic;
+            if (in && std::getline(in, magic) && magic == MAGIC &&
+                readList(in, out.raw) && readList(in, out.optimized)) {
+                stats.hits++;
+                stats.bytesRead += sourceBytes;
+                return true;
+            }
+        }
+        stats.misses++;
+        return false;
+    }
+
+    // Returns before the entry is on disk; flush() waits for it.
+    void store(const std::string& key, const CachedIR& entry) {
+        if (!enabled) return;
+        std::ostringstream tid;
+        tid << std::this_thread::get_id();
+        std::filesystem::path target = pathFor(key);
+        std::filesystem::path temp = target;
+        temp += ".tmp" + tid.str();
+        std::ostringstream out;
+        out << MAGIC << '\n';
+        writeList(out, entry.raw);
+        writeList(out, entry.optimized);
+        writing.write(temp.string(), std::move(out).str(), false, [this, temp, target](std::exception_ptr error) {
+            std::error_code ec;
+            if (!error) std::filesystem::rename(temp, target, ec);
+            if (error || ec) std::filesystem::remove(temp, ec);
+            else stats.writes++;
+        });
+    }
+
+    // Waits until every stored entry is on disk (or given up on).
+    void flush() { writing.wait(); }
+
+    const Stats& statistics() const { return stats; }
+
+    void report() const {
+        size_t hits = stats.hits, misses = stats.misses;
+        size_t total = hits + misses;
+        std::ostringstream rate;
+        rate.setf(std::ios::fixed);
+        rate.precision(1);
+        rate << (total ? 100.0 * hits / total : 0.0);
+        std::cout << "🗄️  IR cache: " << hits << " hit(s), " << misses << " miss(es) ("
+                  << rate.str() << "%), " << stats.writes << " written, "
+                  << stats.bytesRead << " source bytes skipped\n";
+    }
+
+private:
+    std::string dir;
+    std::string optionSet;
+    bool enabled = false;
+    Stats stats;
+    AsyncIO::Batch writing;  // last, so it is waited for before the rest goes
+
+    std::filesystem::path pathFor(const std::string& key) const {
+        return std::filesystem::path(dir) / (key + ".qir");
+    }
+
+    // Text format: a count line, then one line per instruction:
+    // <opcode> <arg length> <hex length> <arg><hex>
+    static void writeList(std::ostream& out, const std::vector<IRInstruction>& list) {
+        out << list.size() << '\n';
+        for (const IRInstruction& i : list) {
+            out << static_cast<int>(i.op) << ' ' << i.arg.size() << ' ' << i.hex.size() << ' '
+                << i.arg << i.hex << '\n';
+        }
+    }
+
+    static bool readList(std::istream& in, std::vector<IRInstruction>& list) {
+        size_t count = 0;
+        if (!(in >> count)) return false;
+        list.clear();
+        list.reserve(std::min<size_t>(count, 1 << 16));  // a corrupt count must not allocate
+        for (size_t n = 0; n < count; ++n) {
+            int op = 0;
+            size_t argLen = 0, hexLen = 0;
+            if (!(in >> op >> argLen >> hexLen) || in.get() != ' ') return false;
+            if (op < 0 || op > static_cast<int>(IROpcode::IR_NOP)) return false;
+            IRInstruction i{static_cast<IROpcode>(op), std::string(argLen, '\0'), std::string(hexLen, '\0')};
+            if (!in.read(i.arg.data(), argLen) || !in.read(i.hex.data(), hexLen)) return false;
+            list.push_back(std::move(i));
+        }
+        return true;
+    }
+};
@@ -3,10 +3,11 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include "QuarterLang_SourceBuffer.h"
 
 class ImportResolver {
 public:
-    std::unordered_map<std::string, std::string> fileContents;
+    std::unordered_map<std::string, SourceBuffer> fileContents;
 
     void load(const std::vector<std::string>& paths) {
         for (const auto& path : paths) {
@@ -16,8 +17,8 @@ public:
     }
 
     std::string resolve(const std::string& ns, const std::string& symbol) {
-        std::string src = fileContents[ns];
-        if (src.find(symbol) != std::string::npos)
+        auto it = fileContents.find(ns);
+        if (it != fileContents.end() && it->second.view().find(symbol) != std::string_view::npos)
             return "[✔️ found] " + symbol + " in " + ns;
         return "[❌ missing] " + symbol + " in " + ns;
     }
@@ -0,0 +1,163 @@
+// QuarterLang_IncrementalLexer.cpp
+// Keeps an editor buffer and its token stream in step. An edit re-lexes from
+// the last token boundary before the damage and stops at the first token that
+// starts where an old token (shifted by the edit) started: the lexer carries no
+// state across token boundaries, so from there the old tail is still valid.
+//
+// Tokens live in a gap buffer that follows the cursor. Tokens before the gap
+// hold absolute offsets/lines; tokens after it hold distances from the end of
+// the buffer, so an edit never has to touch the tail to shift it.
+#pragma once
+#include "QuarterLang_Lexer.cpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tokens [first, first + inserted) replaced the old [first, first + removed).
+struct TokenEdit {
+    size_t first = 0;
+    size_t removed = 0;
+    size_t inserted = 0;
+};
+
+class IncrementalLexer {
+private:
+    std::string text;
+    std::vector<Token> buf;  // [0, gapStart) absolute, [gapEnd, size) end-relative
+    size_t gapStart = 0;
+    size_t gapEnd = 0;
+    int lastLine = 1;        // line of the EOF token
+
+public:
+    IncrementalLexer() { reset(""); }
+    explicit IncrementalLexer(std::string_view source) { reset(source); }
+
+    void reset(std::string_view source) {
+        text.assign(source);
+        buf = Lexer(text).tokenize();
+        lastLine = buf.back().line;
+        buf.pop_back();
+        gapStart = gapEnd = buf.size();
+    }
+
+    const std::string& source() const { return text; }
+
+    // Token count, EOF included.
+    size_t size() const { return buf.size() - (gapEnd - gapStart) + 1; }
+
+    Token at(size_t i) const {
+        if (i < gapStart) return buf[i];
+        if (i + 1 == size()) return {T_EOF, "", lastLine, text.size(), 0};
+        Token t = buf[i + (gapEnd - gapStart)];
+        t.offset = text.size() - t.offset;
+        t.line = lastLine - t.line;
+        return t;
+    }
+
+    // Flat copy for the parser.
+    std::vector<Token> tokens() const {
+        std::vector<Token> out;
+        out.reserve(size());
+        for (size_t i = 0; i < size(); ++i) out.push_back(at(i));
+        return out;
+    }
+
+    // Replaces `removed` bytes at `offset` with `inserted`.
+    TokenEdit edit(size_t offset, size_t removed, std::string_view inserted) {
+        offset = std::min(offset, text.size());
+        removed = std::min(removed, text.size() - offset);
+
+        // First token that reaches the edit; anything ending before it was
+        // terminated by an untouched character and cannot change.
+        size_t lo = 0, hi = size() - 1;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            Token t = at(mid);
+            if (t.offset + t.length < offset) lo = mid + 1; else hi = mid;
+        }
+        const size_t first = lo;
+        moveGap(first);
+
+        text.replace(offset, removed, inserted);
+        size_t start = first > 0 ? buf[first - 1].offset + buf[first - 1].length : 0;
+        int startLine = first > 0 ? buf[first - 1].line : 1;
+
+        Lexer lexer(text, start, startLine);
+        const size_t damageEnd = offset + inserted.size();
+        size_t dropped = 0, added = 0;
+        Token tok;
+        while (lexer.next(tok)) {
+            if (tok.offset >= damageEnd) {
+                while (gapEnd < buf.size() && tailOffset(gapEnd) < static_cast<ptrdiff_t>(tok.offset)) {
+                    ++gapEnd;
+                    ++dropped;
+                }
+                if (gapEnd < buf.size() && tailOffset(gapEnd) == static_cast<ptrdiff_t>(tok.offset)) {
+                    lastLine = tok.line + buf[gapEnd].line;
+                    return {first, dropped, added};
+                }
+            }
+            insertAtGap(std::move(tok));
+            ++added;
+        }
+        dropped += buf.size() - gapEnd;
+        gapEnd = buf.size();
+        lastLine = tok.line;
+        return {first, dropped, added};
+    }
+
+    // Diffs `updated` against the buffer and applies it as one edit.
+    TokenEdit update(std::string_view updated) {
+        std::string_view current = text;
+        size_t prefix = 0;
+        size_t limit = std::min(current.size(), updated.size());
+        while (prefix < limit && current[prefix] == updated[prefix]) ++prefix;
+        size_t suffix = 0;
+        while (suffix < limit - prefix &&
+               current[current.size() - 1 - suffix] == updated[updated.size() - 1 - suffix])
+            ++suffix;
+        if (prefix == current.size() && prefix == updated.size()) return {};
+        return edit(prefix, current.size() - prefix - suffix,
+                    updated.substr(prefix, updated.size() - prefix - suffix));
+    }
+
+private:
+    // Where an old tail token starts in the edited text (negative if the edit ate it).
+    ptrdiff_t tailOffset(size_t slot) const {
+        return static_cast<ptrdiff_t>(text.size()) - static_cast<ptrdiff_t>(buf[slot].offset);
+    }
+
+    // Converts the tokens the gap passes over; cost is the distance moved.
+    // With an empty gap the slots coincide and the token is converted in place.
+    void moveGap(size_t to) {
+        while (gapStart > to) {
+            --gapStart;
+            --gapEnd;
+            if (gapStart != gapEnd) buf[gapEnd] = std::move(buf[gapStart]);
+            flip(buf[gapEnd]);
+        }
+        while (gapStart < to) {
+            if (gapStart != gapEnd) buf[gapStart] = std::move(buf[gapEnd]);
+            flip(buf[gapStart]);
+            ++gapStart;
+            ++gapEnd;
+        }
+    }
+
+    // Absolute <-> end-relative; the mapping is its own inverse.
+    void flip(Token& t) const {
+        t.offset = text.size() - t.offset;
+        t.line = lastLine - t.line;
+    }
+
+    void insertAtGap(Token&& t) {
+        if (gapStart == gapEnd) {
+            size_t grow = std::max<size_t>(256, buf.size() / 4);
+            buf.insert(buf.begin() + gapEnd, grow, Token{T_EOF, "", 0});
+            gapEnd += grow;
+        }
+        buf[gapStart++] = std::move(t);
+    }
+};
@@ -0,0 +1,160 @@
+// QuarterLang_KeywordGen.cpp
+// Build-time generator for QuarterLang_Keywords.h.
+// Reads the first column of QuarterLang_Statements___Keywords_Chart.csv and
+// searches for a seed that hashes every keyword into its own slot, then writes
+// the table out as constexpr data. Rerun via Gen_Keywords.sh whenever the chart changes.
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Must match QuarterKeywords::hash in the generated header.
+static uint32_t keywordHash(const std::string& s, uint32_t seed) {
+    uint32_t h = seed;
+    for (char c : s) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+static std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// First CSV field of a line, honouring "quoted, fields".
+static std::string firstField(const std::string& line) {
+    if (line.empty() || line[0] != '"') return line.substr(0, line.find(','));
+    std::string out;
+    for (size_t i = 1; i < line.size(); ++i) {
+        if (line[i] == '"') {
+            if (i + 1 < line.size() && line[i + 1] == '"') { out += '"'; ++i; }
+            else break;
+        } else {
+            out += line[i];
+        }
+    }
+    return out;
+}
+
+static std::vector<std::string> readKeywords(const std::string& csvPath) {
+    std::ifstream in(csvPath);
+    if (!in) {
+        std::cerr << "❌ Cannot open keyword chart: " << csvPath << "\n";
+        exit(1);
+    }
+    std::vector<std::string> words;
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        std::string field = firstField(line);
+        size_t start = 0;
+        while (start <= field.size()) {
+            size_t comma = field.find(',', start);
+            if (comma == std::string::npos) comma = field.size();
+            std::string word = trim(field.substr(start, comma - start));
+            if (!word.empty() && std::find(words.begin(), words.end(), word) == words.end())
+                words.push_back(word);
+            start = comma + 1;
+        }
+    }
+    return words;
+}
+
+static std::string enumName(const std::string& word) {
+    std::string out = "KW_";
+    for (char c : word) out += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: qtr_kwgen <keywords.csv> <QuarterLang_Keywords.h>\n";
+        return 1;
+    }
+    std::vector<std::string> words = readKeywords(argv[1]);
+
+    uint32_t bits = 1;
+    while ((1u << bits) < words.size() * 2) ++bits;
+
+    uint32_t seed = 0;
+    std::vector<int> slots;
+    for (bool found = false; !found; ++bits) {
+        for (uint32_t trial = 1; trial < 2000000 && !found; ++trial) {
+            uint32_t candidate = trial * 2654435761u;
+            slots.assign(size_t(1) << bits, -1);
+            found = true;
+            for (size_t i = 0; i < words.size(); ++i) {
+                int& slot = slots[keywordHash(words[i], candidate) & ((1u << bits) - 1)];
+                if (slot >= 0) { found = false; break; }
+                slot = static_cast<int>(i);
+            }
+            if (found) seed = candidate;
+        }
+        if (found) break;
+    }
+
+    std::ofstream out(argv[2]);
+    if (!out) {
+        std::cerr << "❌ Cannot write: " << argv[2] << "\n";
+        return 1;
+    }
+    out << "// QuarterLang_Keywords.h\n"
+           "// GENERATED by QuarterLang_KeywordGen.cpp from QuarterLang_Statements___Keywords_Chart.csv.\n"
+           "// Do not edit by hand; rerun Gen_Keywords.sh after changing the chart.\n"
+           "//\n"
+           "// Perfect-hash keyword table shared by every lexer, the syntax highlighter,\n"
+           "// the completion agent and the language detector. Lookup is one hash, one\n"
+           "// table load and one length-checked compare; nothing is built at runtime.\n"
+           "#pragma once\n"
+           "#include <cstddef>\n"
+           "#include <cstdint>\n"
+           "#include <string_view>\n\n"
+           "namespace QuarterKeywords {\n\n"
+           "enum Keyword : int16_t {\n"
+           "    KW_NONE = -1,\n";
+    for (size_t i = 0; i < words.size(); ++i)
+        out << "    " << enumName(words[i]) << " = " << i << ",\n";
+    out << "};\n\n"
+           "constexpr size_t COUNT = " << words.size() << ";\n"
+           "constexpr uint32_t SEED = " << seed << "u;\n"
+           "constexpr uint32_t TABLE_BITS = " << bits << ";\n"
+           "constexpr uint32_t TABLE_MASK = (1u << TABLE_BITS) - 1;\n\n"
+           "// Chart order; index == Keyword value.\n"
+           "constexpr std::string_view LIST[COUNT] = {\n";
+    for (size_t i = 0; i < words.size(); ++i)
+        out << "    \"" << words[i] << "\",\n";
+    out << "};\n\n"
+           "constexpr int16_t SLOTS[1u << TABLE_BITS] = {";
+    for (size_t i = 0; i < slots.size(); ++i)
+        out << (i % 16 == 0 ? "\n    " : " ") << slots[i] << ",";
+    out << "\n};\n\n"
+           "constexpr uint32_t hash(std::string_view s) {\n"
+           "    uint32_t h = SEED;\n"
+           "    for (char c : s) {\n"
+           "        h ^= static_cast<uint8_t>(c);\n"
+           "        h *= 16777619u;\n"
+           "    }\n"
+           "    return h ^ (h >> 15);\n"
+           "}\n\n"
+           "constexpr Keyword find(std::string_view s) {\n"
+           "    int16_t i = SLOTS[hash(s) & TABLE_MASK];\n"
+           "    return (i >= 0 && LIST[i] == s) ? static_cast<Keyword>(i) : KW_NONE;\n"
+           "}\n\n"
+           "constexpr bool isKeyword(std::string_view s) { return find(s) != KW_NONE; }\n\n"
+           "constexpr std::string_view spelling(Keyword k) { return k >= 0 ? LIST[k] : std::string_view{}; }\n\n";
+    out << "static_assert(find(\"" << words.front() << "\") == " << enumName(words.front())
+        << ", \"keyword table is inconsistent\");\n"
+           "static_assert(!isKeyword(\"\"), \"empty spelling must not be a keyword\");\n\n"
+           "} // namespace QuarterKeywords\n";
+
+    std::cout << "✅ " << words.size() << " keywords, " << (1u << bits) << " slots, seed " << seed
+              << " -> " << argv[2] << "\n";
+    return 0;
+}
@@ -0,0 +1,276 @@
+// QuarterLang_Keywords.h
+// GENERATED by QuarterLang_KeywordGen.cpp from QuarterLang_Statements___Keywords_Chart.csv.
+// Do not edit by hand; rerun Gen_Keywords.sh after changing the chart.
+//
+// Perfect-hash keyword table shared by every lexer, the syntax highlighter,
+// the completion agent and the language detector. Lookup is one hash, one
+// table load and one length-checked compare; nothing is built at runtime.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace QuarterKeywords {
+
+enum Keyword : int16_t {
+    KW_NONE = -1,
+    KW_STAR = 0,
+    KW_END = 1,
+    KW_VAL = 2,
+    KW_VAR = 3,
+    KW_AS = 4,
+    KW_BOOL = 5,
+    KW_TRUE = 6,
+    KW_FALSE = 7,
+    KW_TRUTHS = 8,
+    KW_PROOFS = 9,
+    KW_TYPES = 10,
+    KW_PRIMATIVES = 11,
+    KW_DODECAGRAMS = 12,
+    KW_DG = 13,
+    KW_DGVEC = 14,
+    KW_LOOP = 15,
+    KW_TO = 16,
+    KW_WHILE = 17,
+    KW_WHEN = 18,
+    KW_IF = 19,
+    KW_ELSE = 20,
+    KW_ELIF = 21,
+    KW_STOP = 22,
+    KW_BREAK = 23,
+    KW_CONTINUE = 24,
+    KW_MATCH = 25,
+    KW_CASE = 26,
+    KW_CONDITIONALS = 27,
+    KW_AND = 28,
+    KW_OR = 29,
+    KW_NOT = 30,
+    KW_SAY = 31,
+    KW_DEFINE = 32,
+    KW_FN = 33,
+    KW_FUNC = 34,
+    KW_PROCEDURE = 35,
+    KW_YIELD = 36,
+    KW_RETURN = 37,
+    KW_THREAD = 38,
+    KW_SPAWN = 39,
+    KW_ASYNC = 40,
+    KW_AWAIT = 41,
+    KW_LOCK = 42,
+    KW_SYNC = 43,
+    KW_INLINE = 44,
+    KW_NEST = 45,
+    KW_PIPE = 46,
+    KW_MAP = 47,
+    KW_FILTER = 48,
+    KW_REDUCE = 49,
+    KW_BIND = 50,
+    KW_DERIVE = 51,
+    KW_FROM = 52,
+    KW_BY = 53,
+    KW_ENTRY = 54,
+    KW_TABLE = 55,
+    KW_SCOPE = 56,
+    KW_DECORATE = 57,
+    KW_DECORATORS = 58,
+    KW_CLASS = 59,
+    KW_OBJECT = 60,
+    KW_STRUCTS = 61,
+    KW_MODULE = 62,
+    KW_IMPORT = 63,
+    KW_INCLUDE = 64,
+    KW_TEXTURES = 65,
+    KW_UPDATE = 66,
+    KW_FRAME = 67,
+    KW_TICK = 68,
+    KW_TICKRATE = 69,
+    KW_UNIT = 70,
+    KW_CYCLE = 71,
+    KW_REF = 72,
+    KW_MUTATE = 73,
+    KW_MIRROR = 74,
+    KW_LENS = 75,
+    KW_NODES = 76,
+    KW_CONTROLS = 77,
+    KW_KEYWORDS = 78,
+    KW_NASM = 79,
+    KW_HEX = 80,
+    KW_ASM = 81,
+    KW_PROFILE = 82,
+    KW_ASSERT = 83,
+    KW_TEST = 84,
+    KW_OPTION = 85,
+    KW_RESULT = 86,
+    KW_ERROR = 87,
+    KW_TRY = 88,
+    KW_CATCH = 89,
+    KW_FINALLY = 90,
+    KW_GUARD = 91,
+    KW_TRACK = 92,
+    KW_OVERRIDE = 93,
+    KW_IMPLEMENTS = 94,
+    KW_CONCEPT = 95,
+};
+
+constexpr size_t COUNT = 96;
+constexpr uint32_t SEED = 3635196752u;
+constexpr uint32_t TABLE_BITS = 9;
+constexpr uint32_t TABLE_MASK = (1u << TABLE_BITS) - 1;
+
+// Chart order; index == Keyword value.
+constexpr std::string_view LIST[COUNT] = {
+    "star",
+    "end",
+    "val",
+    "var",
+    "as",
+    "bool",
+    "true",
+    "false",
+    "truths",
+    "proofs",
+    "types",
+    "primatives",
+    "dodecagrams",
+    "dg",
+    "dgvec",
+    "loop",
+    "to",
+    "while",
+    "when",
+    "if",
+    "else",
+    "elif",
+    "stop",
+    "break",
+    "continue",
+    "match",
+    "case",
+    "conditionals",
+    "and",
+    "or",
+    "not",
+    "say",
+    "define",
+    "fn",
+    "func",
+    "procedure",
+    "yield",
+    "return",
+    "thread",
+    "spawn",
+    "async",
+    "await",
+    "lock",
+    "sync",
+    "inline",
+    "nest",
+    "pipe",
+    "map",
+    "filter",
+    "reduce",
+    "bind",
+    "derive",
+    "from",
+    "by",
+    "entry",
+    "table",
+    "scope",
+    "decorate",
+    "decorators",
+    "class",
+    "object",
+    "structs",
+    "module",
+    "import",
+    "include",
+    "textures",
+    "update",
+    "frame",
+    "tick",
+    "tickrate",
+    "unit",
+    "cycle",
+    "ref",
+    "mutate",
+    "mirror",
+    "lens",
+    "nodes",
+    "controls",
+    "keywords",
+    "nasm",
+    "hex",
+    "asm",
+    "profile",
+    "assert",
+    "test",
+    "option",
+    "result",
+    "error",
+    "try",
+    "catch",
+    "finally",
+    "guard",
+    "track",
+    "override",
+    "implements",
+    "concept",
+};
+
+constexpr int16_t SLOTS[1u << TABLE_BITS] = {
+    -1, -1, 90, -1, -1, -1, 20, 3, -1, 92, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, 17, -1, -1, -1, -1, 56, -1, -1, -1, -1, -1,
+    -1, -1, 23, 61, 55, -1, -1, -1, 57, -1, -1, 82, 36, -1, 31, -1,
+    45, 93, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, 69, -1, -1, -1, -1, -1, -1, 83, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 70, -1, -1,
+    -1, -1, 52, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 94, -1, -1,
+    -1, -1, -1, -1, 71, -1, 64, -1, -1, 24, -1, -1, -1, 14, -1, -1,
+    -1, -1, -1, -1, -1, -1, 19, 21, -1, -1, -1, -1, 44, -1, 86, -1,
+    -1, -1, -1, -1, -1, 46, 81, -1, 73, -1, -1, -1, -1, -1, -1, -1,
+    22, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, 35, -1, -1, 89, 72, -1, -1, 65, -1, 74,
+    -1, -1, -1, -1, 30, -1, -1, -1, -1, -1, 4, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, 49, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, 85, -1,
+    -1, -1, 29, -1, -1, 43, 95, -1, 10, 66, -1, -1, 25, -1, -1, -1,
+    16, -1, -1, -1, -1, 63, -1, -1, -1, -1, -1, -1, -1, 28, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, 54, -1, 87, -1, -1, -1, -1, 77,
+    -1, -1, 11, -1, 12, -1, -1, -1, -1, 13, -1, -1, 48, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, -1, -1, -1,
+    -1, -1, 8, -1, 41, -1, 75, -1, 26, -1, -1, -1, -1, -1, -1, 59,
+    -1, -1, -1, -1, -1, 15, -1, 33, -1, -1, -1, -1, -1, -1, -1, -1,
+    58, -1, -1, 7, -1, -1, 50, -1, 42, -1, -1, 27, -1, -1, -1, -1,
+    -1, 5, -1, -1, 80, 78, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 38, -1, -1, 91, -1, -1, -1, -1, 32, 47, -1, -1, 67, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, 34, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0,
+    84, -1, 37, -1, -1, -1, -1, -1, -1, 2, 68, -1, 18, -1, -1, -1,
+    -1, 79, 88, 53, -1, -1, -1, -1, -1, 60, -1, -1, 40, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, 51, 76, -1, -1, 39,
+};
+
+constexpr uint32_t hash(std::string_view s) {
+    uint32_t h = SEED;
+    for (char c : s) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+constexpr Keyword find(std::string_view s) {
+    int16_t i = SLOTS[hash(s) & TABLE_MASK];
+    return (i >= 0 && LIST[i] == s) ? static_cast<Keyword>(i) : KW_NONE;
+}
+
+constexpr bool isKeyword(std::string_view s) { return find(s) != KW_NONE; }
+
+constexpr std::string_view spelling(Keyword k) { return k >= 0 ? LIST[k] : std::string_view{}; }
+
+static_assert(find("star") == KW_STAR, "keyword table is inconsistent");
+static_assert(!isKeyword(""), "empty spelling must not be a keyword");
+
+} // namespace QuarterKeywords
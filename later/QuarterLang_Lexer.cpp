@@ -1,8 +1,10 @@
 // QuarterLang_Lexer.cpp
+#pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
 #include <cctype>
+#include "QuarterLang_Keywords.h"
 
 enum TokenType {
     T_KEYWORD, T_IDENTIFIER, T_NUMBER, T_STRING,
@@ -13,27 +15,34 @@ struct Token {
     TokenType type;
     std::string lexeme;
     int line;
+    size_t offset = 0;  // span in the source, quotes included
+    size_t length = 0;
 };
 
 class Lexer {
 private:
-    std::string source;
+    std::string_view source;  // caller keeps the buffer alive (see SourceBuffer)
     size_t current = 0;
     int line = 1;
     std::vector<Token> tokens;
 
-    std::unordered_map<std::string, TokenType> keywords = {
-        {"val", T_KEYWORD}, {"var", T_KEYWORD}, {"loop", T_KEYWORD},
-        {"truths", T_KEYWORD}, {"proofs", T_KEYWORD},
-        {"dg", T_KEYWORD}, {"dgvec", T_KEYWORD},
-        {"bool", T_KEYWORD}, {"types", T_KEYWORD}
-    };
-
 public:
-    Lexer(const std::string& src) : source(src) {}
+    Lexer(std::string_view src) : source(src) {}
+
+    // Resume lexing mid-buffer; `start` must sit between tokens.
+    Lexer(std::string_view src, size_t start, int startLine) : source(src), current(start), line(startLine) {}
 
     std::vector<Token> tokenize() {
+        Token tok;
+        while (next(tok)) tokens.push_back(std::move(tok));
+        tokens.push_back(std::move(tok));
+        return tokens;
+    }
+
+    // Scans one token. Returns false (and an EOF token) at end of input.
+    bool next(Token& out) {
         while (!isAtEnd()) {
+            size_t start = current;
             char c = advance();
 
             if (std::isspace(c)) {
@@ -42,32 +51,40 @@ public:
             }
 
             if (std::isalpha(c)) {
+                --current; // re-read the first character as part of the word
                 std::string word = readWhile(isAlphaNumeric);
-                TokenType type = keywords.count(word) ? keywords[word] : T_IDENTIFIER;
-                tokens.push_back({type, word, line});
+                TokenType type = QuarterKeywords::isKeyword(word) ? T_KEYWORD : T_IDENTIFIER;
+                out = {type, std::move(word), line};
             } else if (std::isdigit(c)) {
-                std::string num = readWhile(isDigit);
-                tokens.push_back({T_NUMBER, num, line});
+                --current;
+                out = {T_NUMBER, readWhile(isDigit), line};
             } else if (c == '"') {
-                std::string str = readString();
-                tokens.push_back({T_STRING, str, line});
+                out = {T_STRING, readString(), line};
             } else if (c == ':') {
-                tokens.push_back({T_COLON, ":", line});
+                out = {T_COLON, ":", line};
+            } else if (isTwoCharOperator(c, peek())) {
+                out = {T_OPERATOR, std::string{c, advance()}, line};
             } else {
-                tokens.push_back({T_OPERATOR, std::string(1, c), line});
+                out = {T_OPERATOR, std::string(1, c), line};
             }
+            out.offset = start;
+            out.length = current - start;
+            return true;
         }
 
-        tokens.push_back({T_EOF, "", line});
-        return tokens;
+        out = {T_EOF, "", line, current, 0};
+        return false;
     }
 
+    size_t position() const { return current; }
+    int currentLine() const { return line; }
+
 private:
     bool isAtEnd() const { return current >= source.length(); }
 
     char advance() { return source[current++]; }
 
-    char peek() const { return source[current]; }
+    char peek() const { return isAtEnd() ? '\0' : source[current]; }
 
     static bool isAlphaNumeric(char c) {
         return std::isalnum(c) || c == '_';
@@ -77,6 +94,12 @@ private:
         return std::isdigit(c);
     }
 
+    // ==, !=, <=, >=, &&, ||
+    static bool isTwoCharOperator(char c, char next) {
+        if (next == '=') return c == '=' || c == '!' || c == '<' || c == '>';
+        return (c == '&' || c == '|') && next == c;
+    }
+
     std::string readWhile(bool (*condition)(char)) {
         std::string result;
         while (!isAtEnd() && condition(source[current])) {
@@ -90,7 +113,7 @@ private:
         while (!isAtEnd() && peek() != '"') {
             str += advance();
         }
-        advance(); // Consume closing quote
+        if (!isAtEnd()) advance(); // Consume closing quote
         return str;
     }
 };
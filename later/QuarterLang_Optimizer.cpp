@@ -9,8 +9,11 @@ private:
 
     // Optional: Constant environment
     std::map<std::string, std::string> constValues;
+    bool verbose = true;
 
 public:
+    void setVerbose(bool v) { verbose = v; }
+
     std::vector<IRInstruction> optimize(const std::vector<IRInstruction>& input) {
         optimized.clear();
         for (const auto& instr : input) {
@@ -92,6 +95,7 @@ private:
     }
 
     void log(const std::string& msg) {
+        if (!verbose) return;
         std::cout << "[OPT] " << msg << std::endl;
     }
 };
@@ -0,0 +1,197 @@
+// QuarterLang_ParallelFrontEnd.cpp
+// Reads, lexes and parses the files of a project concurrently. Each file gets
+// its own source mapping, AST and ErrorHandler, so workers share nothing while
+// they run; the per-file ASTs are merged afterwards in project order, so the
+// result does not depend on scheduling.
+#pragma once
+#include "QuarterLang_Lexer.cpp"
+#include "QuarterLang_Parser.cpp"
+#include "QuarterLang_AST.cpp"
+#include "QuarterLang_ErrorHandler.cpp"
+#include "QuarterLang_IRBytecode.cpp"
+#include "QuarterLang_Optimizer.cpp"
+#include "QuarterLang_IRCache.cpp"
+#include "QuarterLang_SourceBuffer.h"
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One file's front-end output.
+struct ParsedUnit {
+    std::string path;
+    AST ast;
+    std::vector<NodeRef> statements;
+    CachedIR ir;  // compile() only
+    ErrorHandler errors;
+    bool opened = false;
+};
+
+// Per-worker deque of file indices, largest file at the front. The owner works
+// front to back; idle workers steal from the back, so a late steal never
+// picks up a long job.
+class WorkStealingQueue {
+private:
+    std::deque<size_t> items;
+    std::mutex lock;
+
+public:
+    void push(size_t item) {
+        std::lock_guard<std::mutex> guard(lock);
+        items.push_back(item);
+    }
+
+    bool pop(size_t& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (items.empty()) return false;
+        out = items.front();
+        items.pop_front();
+        return true;
+    }
+
+    bool steal(size_t& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (items.empty()) return false;
+        out = items.back();
+        items.pop_back();
+        return true;
+    }
+};
+
+class ParallelFrontEnd {
+public:
+    explicit ParallelFrontEnd(unsigned threads = std::thread::hardware_concurrency())
+        : threadCount(std::max(1u, threads)) {}
+
+    // Parses every file and merges the statements into `ast` in the order the
+    // files are listed. Diagnostics land in `errors`, also in file order.
+    void run(const std::vector<std::string>& files, AST& ast, ErrorHandler& errors) {
+        std::vector<ParsedUnit> units(files.size());
+        for (size_t i = 0; i < files.size(); ++i) units[i].path = files[i];
+
+        forEachUnit(units, parseOne);
+
+        std::vector<NodeRef> statements;
+        for (ParsedUnit& unit : units) {
+            if (!unit.opened) {
+                errors.add(Error::Stage::Lexer, unit.path + ": cannot open file");
+                continue;
+            }
+            for (const Error& err : unit.errors.all())
+                errors.add(err.stage, unit.path + ": " + err.message, err.line, err.col, err.snippet);
+            std::vector<NodeRef> moved = ast.adopt(std::move(unit.ast), unit.statements);
+            statements.insert(statements.end(), moved.begin(), moved.end());
+        }
+        // All at once: the root's child run is relocated at most one time.
+        for (NodeRef n : statements) ast.addChild(n);
+    }
+
+    // Like run(), but goes all the way to optimized IR per file, skipping
+    // the front end and optimizer for any file `cache` already holds. The
+    // optimizer runs per file, so cached and fresh output are identical.
+    std::vector<IRInstruction> compile(const std::vector<std::string>& files, IRCache& cache, ErrorHandler& errors) {
+        std::vector<ParsedUnit> units(files.size());
+        for (size_t i = 0; i < files.size(); ++i) units[i].path = files[i];
+
+        forEachUnit(units, [&cache](ParsedUnit& unit) { compileOne(unit, cache); });
+
+        std::vector<IRInstruction> program;
+        for (ParsedUnit& unit : units) {
+            if (!unit.opened) {
+                errors.add(Error::Stage::Lexer, unit.path + ": cannot open file");
+                continue;
+            }
+            for (const Error& err : unit.errors.all())
+                errors.add(err.stage, unit.path + ": " + err.message, err.line, err.col, err.snippet);
+            program.insert(program.end(), std::make_move_iterator(unit.ir.optimized.begin()),
+                           std::make_move_iterator(unit.ir.optimized.end()));
+        }
+        return program;
+    }
+
+private:
+    unsigned threadCount;
+
+    template <typename Task>
+    void forEachUnit(std::vector<ParsedUnit>& units, Task task) {
+        size_t workers = std::min<size_t>(threadCount, units.size());
+        if (workers <= 1) {
+            for (ParsedUnit& unit : units) task(unit);
+            return;
+        }
+
+        // Deal the files out biggest first, round-robin, so every worker
+        // starts on a large file and the small ones fill in the gaps.
+        std::vector<size_t> bySize(units.size());
+        std::vector<uintmax_t> sizes(units.size());
+        for (size_t i = 0; i < units.size(); ++i) {
+            bySize[i] = i;
+            std::error_code ec;
+            sizes[i] = std::filesystem::file_size(units[i].path, ec);
+            if (ec) sizes[i] = 0;
+        }
+        std::stable_sort(bySize.begin(), bySize.end(),
+                         [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+        std::vector<WorkStealingQueue> queues(workers);
+        for (size_t i = 0; i < bySize.size(); ++i) queues[i % workers].push(bySize[i]);
+
+        auto work = [&](size_t self) {
+            size_t item;
+            for (;;) {
+                if (queues[self].pop(item)) {
+                    task(units[item]);
+                    continue;
+                }
+                // Nothing is ever pushed after start-up, so one empty sweep
+                // over the other queues means the work is done.
+                bool stole = false;
+                for (size_t k = 1; k < workers && !stole; ++k)
+                    stole = queues[(self + k) % workers].steal(item);
+                if (!stole) return;
+                task(units[item]);
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (size_t w = 1; w < workers; ++w) pool.emplace_back(work, w);
+        work(0);
+        for (std::thread& t : pool) t.join();
+    }
+
+    // The AST owns copies of its strings, so the mapping is dropped as soon
+    // as the file is parsed.
+    static void parseOne(ParsedUnit& unit) {
+        SourceBuffer source;
+        unit.opened = source.open(unit.path);
+        if (!unit.opened) return;
+        Lexer lexer(source.view());
+        Parser parser(lexer.tokenize(), unit.ast, unit.errors);
+        unit.statements = parser.parse();
+    }
+
+    static void compileOne(ParsedUnit& unit, IRCache& cache) {
+        SourceBuffer source;
+        unit.opened = source.open(unit.path);
+        if (!unit.opened) return;
+        std::string key = cache.keyFor(source.view());
+        if (cache.load(key, unit.ir, source.size())) return;
+
+        Lexer lexer(source.view());
+        Parser parser(lexer.tokenize(), unit.ast, unit.errors);
+        for (NodeRef n : parser.parse()) unit.ast.addChild(n);
+        if (unit.errors.hasErrors()) return;  // never cache a broken file
+
+        unit.ir.raw = IRGenerator().generate(unit.ast);
+        Optimizer opt;
+        opt.setVerbose(false);  // workers would interleave the log
+        unit.ir.optimized = opt.optimize(unit.ir.raw);
+        cache.store(key, unit.ir);
+    }
+};
@@ -1,44 +1,96 @@
 // QuarterLang_Parser.cpp
+#pragma once
 #include "QuarterLang_Lexer.cpp"
-#include <memory>
+#include "QuarterLang_AST.cpp"
+#include "QuarterLang_ErrorHandler.cpp"
 #include <iostream>
+#include <unordered_map>
 
-enum class ASTNodeType {
-    VAL_DECL, VAR_DECL, LOOP_STMT, TRUTHS_DECL, PROOFS_DECL,
-    FUNC_DECL, STRING_LITERAL, INT_LITERAL, IDENTIFIER
-};
-
-struct ASTNode {
-    ASTNodeType type;
-    std::string value;
-    std::vector<std::shared_ptr<ASTNode>> children;
-
-    ASTNode(ASTNodeType t, const std::string& v = "") : type(t), value(v) {}
-};
-
+// Builds nodes into the caller's AST and returns the top-level statements;
+// hand them to AST::addChild to hang them off the root.
+//
+// A syntax error does not stop the parse: it is recorded in the ErrorHandler,
+// the broken statement is dropped, and parsing resumes at the next statement
+// boundary, so one pass reports every error. Without a caller-supplied
+// handler, parse() prints all of them and exits.
 class Parser {
 private:
     std::vector<Token> tokens;
+    AST& ast;
     size_t current = 0;
+    static constexpr NodeRef NONE = UINT32_MAX;
+
+    ErrorHandler ownErrors;
+    ErrorHandler& errors;
+    bool exitOnError;
+
+    struct ParseError {};  // unwinds to the statement loop
 
 public:
-    explicit Parser(const std::vector<Token>& toks) : tokens(toks) {}
+    Parser(const std::vector<Token>& toks, AST& tree)
+        : tokens(toks), ast(tree), errors(ownErrors), exitOnError(true) {
+        ast.nodes.reserve(ast.nodes.size() + tokens.size());
+    }
 
-    std::vector<std::shared_ptr<ASTNode>> parse() {
-        std::vector<std::shared_ptr<ASTNode>> statements;
+    Parser(const std::vector<Token>& toks, AST& tree, ErrorHandler& diagnostics)
+        : tokens(toks), ast(tree), errors(diagnostics), exitOnError(false) {
+        ast.nodes.reserve(ast.nodes.size() + tokens.size());
+    }
+
+    std::vector<NodeRef> parse() {
+        std::vector<NodeRef> statements;
         while (!isAtEnd()) {
-            auto stmt = parseStatement();
-            if (stmt) statements.push_back(stmt);
+            try {
+                NodeRef stmt = parseStatement();
+                if (stmt != NONE) statements.push_back(stmt);
+            } catch (const ParseError&) {
+                synchronize();
+            }
         }
+        if (exitOnError) errors.throwIfErrors();
         return statements;
     }
 
 private:
     bool isAtEnd() const { return peek().type == T_EOF; }
 
-    Token peek() const { return tokens[current]; }
+    const Token& peek() const { return tokens[current]; }
 
-    Token advance() { return tokens[current++]; }
+    // Never steps past EOF, so recovery can always call it.
+    Token advance() {
+        Token t = tokens[current];
+        if (!isAtEnd()) ++current;
+        return t;
+    }
+
+    // Records the error and returns the exception to throw. When the statement
+    // ran off the end of its line, the error is placed on that line.
+    ParseError error(const Token& at, const std::string& msg) {
+        int line = at.line;
+        std::string where = "'" + at.lexeme + "'";
+        if (at.type == T_EOF) {
+            where = "end of input";
+        } else if (current > 0 && &at == &tokens[current] && tokens[current - 1].line < at.line) {
+            line = tokens[current - 1].line;
+            where = "end of line";
+        }
+        errors.add(Error::Stage::Parser, msg + " (found " + where + ")", line);
+        return ParseError{};
+    }
+
+    // Panic mode: skip to a statement boundary. The lexer drops newlines, so
+    // the first token on a later line than the failed statement's last token
+    // counts as one, as do `end` and `define`. Every statement consumes at
+    // least one token before it can fail, so this always makes progress.
+    void synchronize() {
+        int errorLine = tokens[current - 1].line;
+        while (!isAtEnd()) {
+            const Token& t = tokens[current];
+            if (t.line > errorLine) return;
+            if (t.type == T_KEYWORD && (t.lexeme == "end" || t.lexeme == "define")) return;
+            advance();
+        }
+    }
 
     bool match(TokenType type) {
         if (peek().type == type) {
@@ -50,11 +102,10 @@ private:
 
     Token expect(TokenType type, const std::string& msg) {
         if (match(type)) return tokens[current - 1];
-        std::cerr << "Parse error on line " << peek().line << ": " << msg << std::endl;
-        exit(1);
+        throw error(peek(), msg);
     }
 
-    std::shared_ptr<ASTNode> parseStatement() {
+    NodeRef parseStatement() {
         if (match(T_KEYWORD)) {
             std::string keyword = tokens[current - 1].lexeme;
 
@@ -70,61 +121,155 @@ private:
             if (keyword == "proofs") {
                 return parseProofs();
             }
+            return NONE; // unsupported statement keyword; already consumed
         }
 
         // Unknown or unsupported statement
         advance();
-        return nullptr;
+        return NONE;
     }
 
-    std::shared_ptr<ASTNode> parseVarDecl(bool isConst) {
+    NodeRef parseVarDecl(bool isConst) {
         auto name = expect(T_IDENTIFIER, "Expected variable name");
         expect(T_KEYWORD, "Expected 'as'");
-        auto type = expect(T_IDENTIFIER, "Expected type name");
+        if (peek().type == T_KEYWORD) advance();  // some type names are keywords: bool, dg
+        else expect(T_IDENTIFIER, "Expected type name");
+        const Token& type = tokens[current - 1];
         expect(T_COLON, "Expected ':'");
-        auto value = advance(); // Could be number or string
 
-        auto decl = std::make_shared<ASTNode>(isConst ? ASTNodeType::VAL_DECL : ASTNodeType::VAR_DECL, name.lexeme);
-        decl->children.push_back(std::make_shared<ASTNode>(ASTNodeType::IDENTIFIER, type.lexeme));
-        decl->children.push_back(std::make_shared<ASTNode>(
-            value.type == T_STRING ? ASTNodeType::STRING_LITERAL : ASTNodeType::INT_LITERAL, value.lexeme));
-        return decl;
+        NodeRef typeNode = ast.make(ASTNodeType::IDENTIFIER, type.lexeme);
+        NodeRef valueNode = parseExpression();
+        return ast.make(isConst ? ASTNodeType::VAL_DECL : ASTNodeType::VAR_DECL, name.lexeme, {typeNode, valueNode});
+    }
+
+    // --- Expressions ---
+    // Pratt parser: binding power decides how tightly an infix operator holds
+    // its operands; equal power ends the loop, so operators associate left.
+    enum BindingPower : int {
+        BP_NONE, BP_OR, BP_AND, BP_EQUALITY, BP_COMPARE, BP_TERM, BP_FACTOR, BP_PREFIX
+    };
+
+    static int infixPower(const Token& t) {
+        if (t.type == T_KEYWORD) {
+            if (t.lexeme == "or") return BP_OR;
+            if (t.lexeme == "and") return BP_AND;
+            return BP_NONE;
+        }
+        if (t.type != T_OPERATOR) return BP_NONE;
+        static const std::unordered_map<std::string, int> table = {
+            {"||", BP_OR}, {"&&", BP_AND},
+            {"==", BP_EQUALITY}, {"!=", BP_EQUALITY},
+            {"<", BP_COMPARE}, {"<=", BP_COMPARE}, {">", BP_COMPARE}, {">=", BP_COMPARE},
+            {"+", BP_TERM}, {"-", BP_TERM},
+            {"*", BP_FACTOR}, {"/", BP_FACTOR}, {"%", BP_FACTOR},
+        };
+        auto it = table.find(t.lexeme);
+        return it == table.end() ? BP_NONE : it->second;
+    }
+
+    NodeRef parseExpression(int minPower = BP_NONE) {
+        NodeRef lhs = parsePrefix();
+        while (infixPower(peek()) > minPower) {
+            Token op = advance();
+            NodeRef rhs = parseExpression(infixPower(op));
+            lhs = ast.make(ASTNodeType::BINARY_EXPR, op.lexeme, {lhs, rhs});
+        }
+        return lhs;
+    }
+
+    NodeRef parsePrefix() {
+        if (!startsExpression(peek())) throw error(peek(), "Expected an expression");
+        Token t = advance();
+        switch (t.type) {
+            case T_NUMBER:
+                return ast.make(ASTNodeType::INT_LITERAL, t.lexeme);
+            case T_STRING:
+                return ast.make(ASTNodeType::STRING_LITERAL, t.lexeme);
+            case T_KEYWORD:
+                if (t.lexeme == "not")
+                    return ast.make(ASTNodeType::UNARY_EXPR, "!", {parseExpression(BP_PREFIX)});
+                return ast.make(ASTNodeType::IDENTIFIER, t.lexeme);  // true, false
+            case T_IDENTIFIER:
+                // The '(' has to be on the callee's line to make this a call.
+                if (peek().type == T_OPERATOR && peek().lexeme == "(" && peek().line == t.line)
+                    return parseCall(t);
+                return ast.make(ASTNodeType::IDENTIFIER, t.lexeme);
+            case T_OPERATOR:
+                if (t.lexeme == "-" || t.lexeme == "!")
+                    return ast.make(ASTNodeType::UNARY_EXPR, t.lexeme, {parseExpression(BP_PREFIX)});
+                if (t.lexeme == "(") {
+                    NodeRef inner = parseExpression();
+                    expectOperator(")");
+                    return inner;
+                }
+                break;
+            default:
+                break;
+        }
+        throw error(t, "Expected an expression");
+    }
+
+    static bool startsExpression(const Token& t) {
+        if (t.type == T_NUMBER || t.type == T_STRING || t.type == T_IDENTIFIER) return true;
+        if (t.type == T_KEYWORD) return t.lexeme == "not" || t.lexeme == "true" || t.lexeme == "false";
+        return t.type == T_OPERATOR && (t.lexeme == "-" || t.lexeme == "!" || t.lexeme == "(");
+    }
+
+    NodeRef parseCall(const Token& callee) {
+        advance(); // (
+        std::vector<NodeRef> args;
+        if (!matchOperator(")")) {
+            do {
+                args.push_back(parseExpression());
+            } while (matchOperator(","));
+            expectOperator(")");
+        }
+        return ast.make(ASTNodeType::CALL_EXPR, callee.lexeme, args);
+    }
+
+    bool matchOperator(const char* op) {
+        if (peek().type == T_OPERATOR && peek().lexeme == op) {
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    void expectOperator(const char* op) {
+        if (matchOperator(op)) return;
+        throw error(peek(), std::string("Expected '") + op + "'");
     }
 
-    std::shared_ptr<ASTNode> parseLoop() {
-        expect(T_IDENTIFIER, "Expected 'from'");
+    NodeRef parseLoop() {
+        expect(T_KEYWORD, "Expected 'from'");
         auto start = advance(); // number
-        expect(T_IDENTIFIER, "Expected 'to'");
+        expect(T_KEYWORD, "Expected 'to'");
         auto end = advance();   // number
         expect(T_COLON, "Expected ':'");
 
-        auto loop = std::make_shared<ASTNode>(ASTNodeType::LOOP_STMT);
-        loop->children.push_back(std::make_shared<ASTNode>(ASTNodeType::INT_LITERAL, start.lexeme));
-        loop->children.push_back(std::make_shared<ASTNode>(ASTNodeType::INT_LITERAL, end.lexeme));
-        return loop;
+        NodeRef from = ast.make(ASTNodeType::INT_LITERAL, start.lexeme);
+        NodeRef to = ast.make(ASTNodeType::INT_LITERAL, end.lexeme);
+        return ast.make(ASTNodeType::LOOP_STMT, "", {from, to});
     }
 
-    std::shared_ptr<ASTNode> parseTruths() {
+    NodeRef parseTruths() {
         expect(T_COLON, "Expected ':' after 'truths'");
-        std::vector<std::shared_ptr<ASTNode>> truthNodes;
+        std::vector<NodeRef> truthNodes;
         while (!isAtEnd() && peek().type == T_IDENTIFIER) {
             auto id = advance();
-            truthNodes.push_back(std::make_shared<ASTNode>(ASTNodeType::IDENTIFIER, id.lexeme));
+            truthNodes.push_back(ast.make(ASTNodeType::IDENTIFIER, id.lexeme));
         }
-        auto truths = std::make_shared<ASTNode>(ASTNodeType::TRUTHS_DECL);
-        truths->children = truthNodes;
-        return truths;
+        return ast.make(ASTNodeType::TRUTHS_DECL, "", truthNodes);
     }
 
-    std::shared_ptr<ASTNode> parseProofs() {
+    NodeRef parseProofs() {
         auto validate = advance(); // usually "validate"
         auto lhs = advance();      // e.g. gravity
         auto against = advance();  // e.g. "against"
         auto rhs = advance();      // e.g. mass
 
-        auto proofs = std::make_shared<ASTNode>(ASTNodeType::PROOFS_DECL, validate.lexeme);
-        proofs->children.push_back(std::make_shared<ASTNode>(ASTNodeType::IDENTIFIER, lhs.lexeme));
-        proofs->children.push_back(std::make_shared<ASTNode>(ASTNodeType::IDENTIFIER, rhs.lexeme));
-        return proofs;
+        NodeRef lhsNode = ast.make(ASTNodeType::IDENTIFIER, lhs.lexeme);
+        NodeRef rhsNode = ast.make(ASTNodeType::IDENTIFIER, rhs.lexeme);
+        return ast.make(ASTNodeType::PROOFS_DECL, validate.lexeme, {lhsNode, rhsNode});
     }
 };
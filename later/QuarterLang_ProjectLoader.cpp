@@ -3,8 +3,8 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <filesystem>
+#include "QuarterLang_SourceBuffer.h"
 
 class QuarterProjectLoader {
 public:
@@ -33,14 +33,13 @@ public:
         return sources;
     }
 
-    static std::string readFile(const std::string& path) {
-        std::ifstream file(path);
-        if (!file) {
+    // Maps the file; keep the buffer alive while its tokens are in use.
+    static SourceBuffer readFile(const std::string& path) {
+        SourceBuffer buffer;
+        if (!buffer.open(path)) {
             std::cerr << "❌ Cannot open: " << path << "\n";
             exit(1);
         }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
+        return buffer;
     }
 };
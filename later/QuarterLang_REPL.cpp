@@ -1,11 +1,12 @@
 // QuarterLang_REPL.cpp
+#include "QuarterLang_Parser.cpp"
 #include "QuarterLang_Runtime.cpp"
 #include <string>
 
 class QuarterREPL {
 private:
     QuarterRuntime runtime;
-    std::shared_ptr<ASTNode> root = std::make_shared<ASTNode>(ASTNodeType::ROOT);
+    AST ast;  // every line entered so far, hung off ast.root
 
 public:
     void start() {
@@ -18,12 +19,17 @@ public:
             if (line == "exit") break;
 
             Lexer lexer(line);
-            Parser parser(lexer.tokenize());
+            ErrorHandler errors;
+            Parser parser(lexer.tokenize(), ast, errors);
             auto nodes = parser.parse();
+            if (errors.hasErrors()) {
+                errors.report();  // keep the session; drop the bad line
+                continue;
+            }
 
-            for (auto& n : nodes) root->children.push_back(n);
+            for (auto n : nodes) ast.addChild(n);
 
-            runtime.execute(root);
+            runtime.execute(ast);
         }
     }
 };
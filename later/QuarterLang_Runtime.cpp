@@ -10,15 +10,21 @@ private:
     std::unordered_map<std::string, bool> constants;
 
 public:
-    void execute(const std::shared_ptr<ASTNode>& root) {
-        for (const auto& child : root->children) {
-            executeNode(child);
+    void execute(const AST& tree) {
+        ast = &tree;
+        for (size_t i = 0; i < tree.childCount(tree.root); ++i) {
+            executeNode(tree.child(tree.root, i));
         }
     }
 
 private:
-    void executeNode(const std::shared_ptr<ASTNode>& node) {
-        switch (node->type) {
+    const AST* ast = nullptr;
+
+    const std::string& valueOf(NodeRef n) const { return ast->node(n).value; }
+    const std::string& childValue(NodeRef n, size_t i) const { return valueOf(ast->child(n, i)); }
+
+    void executeNode(NodeRef node) {
+        switch (ast->node(node).type) {
             case ASTNodeType::VAL_DECL:
                 handleValDecl(node);
                 break;
@@ -39,43 +45,98 @@ private:
         }
     }
 
-    void handleValDecl(const std::shared_ptr<ASTNode>& node) {
-        std::string varName = node->value;
-        std::string type = node->children[0]->value;
-        std::string val = node->children[1]->value;
+    void handleValDecl(NodeRef node) {
+        const std::string& varName = valueOf(node);
+        const std::string& type = childValue(node, 0);
+        std::string val = evaluate(ast->child(node, 1));
         memory[varName] = val;
         constants[varName] = true;
         std::cout << "[val] " << varName << " = " << val << " (" << type << ")\n";
     }
 
-    void handleVarDecl(const std::shared_ptr<ASTNode>& node) {
-        std::string varName = node->value;
-        std::string type = node->children[0]->value;
-        std::string val = node->children[1]->value;
+    void handleVarDecl(NodeRef node) {
+        const std::string& varName = valueOf(node);
+        const std::string& type = childValue(node, 0);
+        std::string val = evaluate(ast->child(node, 1));
         memory[varName] = val;
         constants[varName] = false;
         std::cout << "[var] " << varName << " = " << val << " (" << type << ")\n";
     }
 
-    void handleTruths(const std::shared_ptr<ASTNode>& node) {
+    // Values are kept as text. Integer arithmetic and comparisons are computed;
+    // anything else (strings, unknown names, calls) is rendered symbolically.
+    std::string evaluate(NodeRef n) {
+        const ASTNode& node = ast->node(n);
+        switch (node.type) {
+            case ASTNodeType::IDENTIFIER: {
+                auto it = memory.find(node.value);
+                return it != memory.end() ? it->second : node.value;
+            }
+            case ASTNodeType::UNARY_EXPR: {
+                std::string v = evaluate(ast->child(n, 0));
+                long long i;
+                if (node.value == "-" && asInt(v, i)) return std::to_string(-i);
+                if (node.value == "!" && asInt(v, i)) return std::to_string(i == 0);
+                return node.value + v;
+            }
+            case ASTNodeType::BINARY_EXPR: {
+                std::string l = evaluate(ast->child(n, 0));
+                std::string r = evaluate(ast->child(n, 1));
+                long long a, b;
+                if (asInt(l, a) && asInt(r, b)) {
+                    const std::string& op = node.value;
+                    if (op == "+") return std::to_string(a + b);
+                    if (op == "-") return std::to_string(a - b);
+                    if (op == "*") return std::to_string(a * b);
+                    if ((op == "/" || op == "%") && b != 0) return std::to_string(op == "/" ? a / b : a % b);
+                    if (op == "==") return std::to_string(a == b);
+                    if (op == "!=") return std::to_string(a != b);
+                    if (op == "<") return std::to_string(a < b);
+                    if (op == "<=") return std::to_string(a <= b);
+                    if (op == ">") return std::to_string(a > b);
+                    if (op == ">=") return std::to_string(a >= b);
+                    if (op == "&&" || op == "and") return std::to_string(a && b);
+                    if (op == "||" || op == "or") return std::to_string(a || b);
+                }
+                return "(" + l + " " + node.value + " " + r + ")";
+            }
+            case ASTNodeType::CALL_EXPR: {
+                std::string out = node.value + "(";
+                for (size_t i = 0; i < ast->childCount(n); ++i)
+                    out += (i ? ", " : "") + evaluate(ast->child(n, i));
+                return out + ")";
+            }
+            default:
+                return node.value;
+        }
+    }
+
+    static bool asInt(const std::string& s, long long& out) {
+        if (s.empty()) return false;
+        size_t used = 0;
+        try { out = std::stoll(s, &used); } catch (...) { return false; }
+        return used == s.size();
+    }
+
+    void handleTruths(NodeRef node) {
         std::cout << "[truths] ";
-        for (const auto& t : node->children)
-            std::cout << t->value << " ";
+        for (size_t i = 0; i < ast->childCount(node); ++i)
+            std::cout << childValue(node, i) << " ";
         std::cout << "\n";
     }
 
-    void handleProofs(const std::shared_ptr<ASTNode>& node) {
-        std::string proofType = node->value;
-        std::string lhs = node->children[0]->value;
-        std::string rhs = node->children[1]->value;
+    void handleProofs(NodeRef node) {
+        const std::string& proofType = valueOf(node);
+        const std::string& lhs = childValue(node, 0);
+        const std::string& rhs = childValue(node, 1);
 
         std::cout << "[proofs] " << proofType << " ";
         std::cout << lhs << " vs " << rhs << "\n";
     }
 
-    void handleLoop(const std::shared_ptr<ASTNode>& node) {
-        int start = std::stoi(node->children[0]->value);
-        int end = std::stoi(node->children[1]->value);
+    void handleLoop(NodeRef node) {
+        int start = std::stoi(childValue(node, 0));
+        int end = std::stoi(childValue(node, 1));
         std::cout << "[loop] from " << start << " to " << end << "\n";
         for (int i = start; i <= end; ++i)
             std::cout << "  ➜ Iteration: " << i << "\n";
@@ -0,0 +1,172 @@
+// QuarterLang_SourceBuffer.h
+// Read-only view of a whole source file for the lexers.
+// Regular files are memory-mapped, so the bytes are never copied and peak RSS
+// stays at roughly the file size. Pipes, character devices and stdin ("-")
+// cannot be mapped and are streamed into one owned buffer in large chunks.
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class SourceBuffer {
+public:
+    static constexpr size_t STREAM_CHUNK = 1 << 16;
+
+    SourceBuffer() = default;
+    explicit SourceBuffer(std::string text) : owned(std::move(text)) { adoptOwned(); }
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept { moveFrom(other); }
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    ~SourceBuffer() { release(); }
+
+    // Loads `path` ("-" means stdin). Returns false if it cannot be opened.
+    bool open(const std::string& path) {
+        release();
+        if (path == "-") return readFd(stdinHandle());
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size{};
+        if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            bool ok = readHandle(file);
+            CloseHandle(file);
+            return ok;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) return false;
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) return false;
+        begin = static_cast<const char*>(view);
+        length = static_cast<size_t>(size.QuadPart);
+        mapped = true;
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+            bool ok = readFd(fd);
+            ::close(fd);
+            return ok;
+        }
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+        madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        begin = static_cast<const char*>(addr);
+        length = static_cast<size_t>(st.st_size);
+        mapped = true;
+        return true;
+#endif
+    }
+
+    // Streams an already-open std::istream (e.g. std::cin) in chunks.
+    bool readStream(std::istream& in) {
+        release();
+        char chunk[STREAM_CHUNK];
+        while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0)
+            owned.append(chunk, static_cast<size_t>(in.gcount()));
+        adoptOwned();
+        return !in.bad();
+    }
+
+    std::string_view view() const { return {begin, length}; }
+    operator std::string_view() const { return view(); }
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    bool isMapped() const { return mapped; }
+
+private:
+    const char* begin = "";
+    size_t length = 0;
+    bool mapped = false;
+    std::string owned;  // streamed input only
+
+    void adoptOwned() {
+        begin = owned.data();
+        length = owned.size();
+        mapped = false;
+    }
+
+    void release() {
+        if (mapped) {
+#ifdef _WIN32
+            UnmapViewOfFile(begin);
+#else
+            munmap(const_cast<char*>(begin), length);
+#endif
+        }
+        owned.clear();
+        owned.shrink_to_fit();
+        begin = "";
+        length = 0;
+        mapped = false;
+    }
+
+    void moveFrom(SourceBuffer& other) {
+        mapped = other.mapped;
+        if (mapped) {
+            begin = other.begin;
+            length = other.length;
+        } else {
+            owned = std::move(other.owned);
+            begin = owned.data();
+            length = owned.size();
+        }
+        other.begin = "";
+        other.length = 0;
+        other.mapped = false;
+    }
+
+#ifdef _WIN32
+    static HANDLE stdinHandle() { return GetStdHandle(STD_INPUT_HANDLE); }
+    bool readFd(HANDLE h) { return readHandle(h); }
+    bool readHandle(HANDLE h) {
+        char chunk[STREAM_CHUNK];
+        DWORD got = 0;
+        while (ReadFile(h, chunk, sizeof(chunk), &got, nullptr) && got > 0)
+            owned.append(chunk, got);
+        adoptOwned();
+        return true;
+    }
+#else
+    static int stdinHandle() { return STDIN_FILENO; }
+    bool readFd(int fd) {
+        char chunk[STREAM_CHUNK];
+        for (;;) {
+            ssize_t got = ::read(fd, chunk, sizeof(chunk));
+            if (got > 0) { owned.append(chunk, static_cast<size_t>(got)); continue; }
+            if (got < 0 && errno == EINTR) continue;
+            adoptOwned();
+            return got == 0;
+        }
+    }
+#endif
+};
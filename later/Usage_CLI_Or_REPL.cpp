@@ -1,10 +1,10 @@
 Lexer lexer(code);
-Parser parser(lexer.tokenize());
+AST ast;
+Parser parser(lexer.tokenize(), ast);
 auto nodes = parser.parse();
 
-AST ast;
-for (auto& n : nodes)
+for (auto n : nodes)
     ast.addChild(n);
 
 QuarterRuntime rt;
-rt.execute(ast.root);
+rt.execute(ast);